@@ -0,0 +1,112 @@
+#include <glossy/json2glsl.hpp>
+#include <glossy/scene_data.hpp>
+#include <glossy/binary_scene.hpp>
+#include <glossy/scene_generator.hpp>
+#include <glossy/stopwatch.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstddef>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN 1
+	#endif // !WIN32_LEAN_AND_MEAN
+	#ifndef NOMINMAX
+		#define NOMINMAX 1
+	#endif // !NOMINMAX
+	#include <windows.h>
+	#include <psapi.h>
+#else // _WIN32
+	#include <sys/resource.h>
+#endif // _WIN32
+
+// measures how fast scenes of growing size are read and turned into shader code or data textures
+
+namespace {
+	char const* const scene_file = "glossy-bench-codegen.json";
+	char const* const binary_file = "glossy-bench-codegen.glsb";
+
+	// the peak resident set size of the process so far, in MiB
+	double peak_rss_mib() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof counters ) )
+			return 0.0;
+		return counters.PeakWorkingSetSize / 1048576.0;
+#else // _WIN32
+		rusage usage;
+		if( getrusage( RUSAGE_SELF, &usage ) != 0 )
+			return 0.0;
+	#ifdef __APPLE__
+		return usage.ru_maxrss / 1048576.0; // bytes
+	#else // __APPLE__
+		return usage.ru_maxrss / 1024.0; // KiB
+	#endif // __APPLE__
+#endif // _WIN32
+	}
+
+	// writes a scene with the given number of spheres over a plane and returns its size in bytes
+	std::size_t write_scene( std::size_t spheres ) {
+		glossy::generator_settings settings;
+		settings.spheres = spheres;
+		settings.animated_lights = 1;
+		std::ofstream file{ scene_file, std::ofstream::trunc };
+		glossy::generate_scene( file, settings );
+		return static_cast< std::size_t >( file.tellp() );
+	}
+
+	template< typename fun_t >
+	double time_ms( fun_t&& fun ) {
+		glossy::stopwatch timer;
+		timer.start();
+		fun();
+		return static_cast< double >( timer.elapsed_ms_flt() );
+	}
+	double mb_per_s( std::size_t bytes, double ms ) {
+		return ms > 0.0 ? bytes / 1.0e3 / ms : 0.0;
+	}
+}
+
+int main() {
+	for( std::size_t spheres : { 1000, 10000, 100000, 1000000 } ) {
+		const std::size_t json_bytes = write_scene( spheres );
+
+		glossy::scene s;
+		const double parse_ms = time_ms( [ & ]{
+			s = glossy::json2scene( scene_file );
+		} );
+
+		glossy::scene2binary( s, binary_file );
+		const double binary_ms = time_ms( [ & ]{
+			s = glossy::binary2scene( binary_file );
+		} );
+
+		// every object in the code, which is what the BVH is there to prevent
+		const bool bvh = s.bvh;
+		s.bvh = false;
+		std::string baked;
+		const double baked_ms = time_ms( [ & ]{
+			baked = glossy::scene2glsl( s );
+		} );
+
+		s.bvh = bvh;
+		s.data_driven = true;
+		std::string data_driven;
+		glossy::scene_data data;
+		const double data_driven_ms = time_ms( [ & ]{
+			data_driven = glossy::scene2glsl( s );
+			data = glossy::pack( s );
+		} );
+
+		std::cout << spheres << " spheres, " << json_bytes / 1.0e6 << " MB of JSON\n"
+			<< "  parse:              " << parse_ms << " ms, " << mb_per_s( json_bytes, parse_ms ) << " MB/s\n"
+			<< "  binary load:        " << binary_ms << " ms\n"
+			<< "  baked shader:       " << baked_ms << " ms, " << mb_per_s( baked.size(), baked_ms ) << " MB/s of code\n"
+			<< "  data driven + pack: " << data_driven_ms << " ms, " << ( data.spheres.size() + data.bvh_nodes.size() ) * sizeof( float ) / 1.0e6 << " MB of texels\n"
+			<< "  peak RSS so far:    " << peak_rss_mib() << " MiB\n";
+	}
+	std::remove( scene_file );
+	std::remove( binary_file );
+}
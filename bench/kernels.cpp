@@ -0,0 +1,121 @@
+#include <glossy/kernels.hpp>
+#include <glossy/stopwatch.hpp>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// measures the throughput of the packet kernels for every instruction set this build supports
+// and fails if their closest hits disagree with the scalar ones beyond rounding
+
+namespace {
+	using namespace glossy::kernels;
+
+	constexpr std::size_t ray_count = 1 << 16;
+	constexpr double min_seconds = 0.5;
+	// relative to the distance; the vector paths round differently, e.g. through fused multiply-adds
+	constexpr double tolerance = 1.0e-4;
+
+	// reset runs before every batch, outside of the measured time
+	template< typename reset_t, typename fun_t >
+	double rays_per_second( reset_t&& reset, fun_t&& fun ) {
+		double seconds = 0.0;
+		std::size_t traced = 0;
+		do {
+			reset();
+			glossy::stopwatch timer;
+			timer.start();
+			fun();
+			timer.stop();
+			seconds += timer.elapsed_s_flt();
+			traced += ray_count;
+		} while( seconds < min_seconds );
+		return traced / seconds;
+	}
+
+	// whether ray i of r touches object id so closely that rounding decides whether it hits
+	bool grazes( rays const& r, std::size_t i, spheres const& s, std::int32_t id ) {
+		if( id == no_hit || static_cast< std::size_t >( id ) >= s.size() )
+			return false;
+		const double ocx = double{ s.x[ id ] } - r.ox[ i ];
+		const double ocy = double{ s.y[ id ] } - r.oy[ i ];
+		const double ocz = double{ s.z[ id ] } - r.oz[ i ];
+		const double ang = r.dx[ i ] * ocx + r.dy[ i ] * ocy + r.dz[ i ] * ocz;
+		const double radius_sq = double{ s.r[ id ] } * s.r[ id ];
+		const double radicand = ang * ang + radius_sq - ( ocx * ocx + ocy * ocy + ocz * ocz );
+		return std::abs( radicand ) <= tolerance * std::max( radius_sq, ang * ang );
+	}
+
+	// counts the rays whose closest hits differ from the reference beyond rounding: by distance,
+	// or by object unless the two are hit at the same distance or one of them is only grazed
+	std::size_t mismatches( rays const& r, rays const& reference, spheres const& s ) {
+		std::size_t count = 0;
+		for( std::size_t i = 0; i < ray_count; ++i ) {
+			const bool same_t = std::abs( r.t[ i ] - reference.t[ i ] ) <= tolerance * std::max( 1.0f, reference.t[ i ] );
+			if( r.id[ i ] == reference.id[ i ] )
+				count += !same_t;
+			else
+				count += !same_t && !grazes( reference, i, s, r.id[ i ] ) && !grazes( reference, i, s, reference.id[ i ] );
+		}
+		return count;
+	}
+}
+
+int main() {
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution< float > unit{ -1.0f, 1.0f };
+
+	rays primary;
+	primary.resize( ray_count );
+	for( std::size_t i = 0; i < ray_count; ++i ) {
+		float x, y, z, len;
+		do {
+			x = unit( rng );
+			y = unit( rng );
+			z = unit( rng );
+			len = std::sqrt( x * x + y * y + z * z );
+		} while( len > 1.0f || len < 1.0e-3f );
+		primary.set( i, { unit( rng ), 1.0f + unit( rng ), unit( rng ), x / len, y / len, z / len }, 50.0f );
+	}
+
+	bool failed = false;
+	for( std::size_t sphere_count : { 4, 16, 64, 256 } ) {
+		spheres s;
+		for( std::size_t i = 0; i < sphere_count; ++i )
+			s.add( unit( rng ) * 20.0f, 1.0f + unit( rng ), unit( rng ) * 20.0f, 0.5f + 0.5f * unit( rng ) );
+		planes p;
+		p.add( 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f );
+
+		std::cout << sphere_count << " spheres, " << p.size() << " plane, " << ray_count << " rays per batch\n";
+		rays reference = primary;
+		closest_hit( reference, s, p, isa::scalar );
+		for( isa set : available() ) {
+			rays r;
+			const double closest = rays_per_second( [ & ]{
+				r = primary;
+			}, [ & ]{
+				closest_hit( r, s, p, set );
+			} );
+			const std::size_t wrong = mismatches( r, reference, s );
+
+			std::vector< std::uint8_t > occluded;
+			const double any = rays_per_second( []{}, [ & ]{
+				any_hit( primary, s, p, occluded, set );
+			} );
+
+			std::cout << "  " << name( set ) << " (" << width( set ) << " wide): "
+				<< closest / 1.0e6 << " Mrays/s closest hit, "
+				<< any / 1.0e6 << " Mrays/s any hit";
+			if( wrong ) {
+				std::cout << ", " << wrong << " closest hits differ from scalar";
+				failed = true;
+			}
+			std::cout << '\n';
+		}
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
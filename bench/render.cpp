@@ -0,0 +1,294 @@
+#include <glossy/json2glsl.hpp>
+#include <glossy/scene_generator.hpp>
+#include <glossy/tracer.hpp>
+#include <glossy/camera.hpp>
+#include <glossy/frame_stats.hpp>
+#include <glossy/stopwatch.hpp>
+#include <nlohmann/json.hpp>
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+// renders generated scenes that sweep one setting at a time away from a base case and reports
+// how long every stage takes. given an earlier report, fails if any stage got slower.
+
+namespace {
+	using namespace glossy;
+	using json = nlohmann::json;
+
+	char const* const usage =
+		"usage: glossy-bench-render [options]\n"
+		"\n"
+		"options:\n"
+		"  --out FILE         where to write the report (default: glossy-bench-render.json)\n"
+		"  --baseline FILE    compare with an earlier report and fail on regressions\n"
+		"  --tolerance X      relative slowdown that counts as a regression (default: 0.15)\n"
+		"  --frames N         frames to measure per case after warming up (default: 100)\n"
+		"  --filter TEXT      only run the cases whose name contains TEXT\n";
+
+	// a report is only comparable to others of the same version
+	constexpr int report_version = 1;
+	constexpr unsigned warmup_frames = 10;
+	// CPU stages are repeated and the fastest run counts, which is the least noisy
+	constexpr unsigned repeats = 3;
+	// slowdowns below this are noise however large they are relative to the baseline
+	constexpr double min_regression_ms = 0.1;
+
+	struct bench_case {
+		std::string name;
+		generator_settings settings;
+		unsigned width = 640;
+		unsigned height = 360;
+		// renders the data driven scene with shader_options::hybrid
+		bool hybrid = false;
+	};
+
+	std::vector< bench_case > make_cases() {
+		bench_case base;
+		base.settings.spheres = 100;
+		base.settings.lights = 1;
+		base.settings.recursion = 1;
+		base.settings.SS = 1;
+
+		std::vector< bench_case > result;
+		const auto add = [ & ]( std::string const& name, auto&& change ) {
+			bench_case c = base;
+			c.name = name;
+			change( c );
+			result.push_back( c );
+		};
+		for( std::size_t spheres : { 10, 100, 1000, 10000 } )
+			add( "spheres=" + std::to_string( spheres ), [ & ]( bench_case& c ) { c.settings.spheres = spheres; } );
+		for( std::size_t lights : { 1, 8, 64 } )
+			add( "lights=" + std::to_string( lights ), [ & ]( bench_case& c ) { c.settings.lights = lights; } );
+		for( unsigned recursion : { 0, 1, 4 } )
+			add( "recursion=" + std::to_string( recursion ), [ & ]( bench_case& c ) { c.settings.recursion = recursion; } );
+		for( unsigned SS : { 1, 2, 3 } )
+			add( "SS=" + std::to_string( SS ), [ & ]( bench_case& c ) { c.settings.SS = SS; } );
+		// the rasterized first hits, whose cost should grow far less with the spheres than tracing them
+		for( std::size_t spheres : { 100, 1000, 10000 } ) {
+			add( "hybrid,spheres=" + std::to_string( spheres ), [ & ]( bench_case& c ) {
+				c.settings.spheres = spheres;
+				c.hybrid = true;
+			} );
+		}
+		for( auto size : { sf::Vector2u{ 640, 360 }, sf::Vector2u{ 1280, 720 }, sf::Vector2u{ 1920, 1080 } } ) {
+			add( "resolution=" + std::to_string( size.x ) + 'x' + std::to_string( size.y ), [ & ]( bench_case& c ) {
+				c.width = size.x;
+				c.height = size.y;
+			} );
+		}
+		return result;
+	}
+
+	template< typename fun_t >
+	double fastest_ms( fun_t&& fun ) {
+		double result = std::numeric_limits< double >::infinity();
+		for( unsigned i = 0; i < repeats; ++i ) {
+			stopwatch timer;
+			timer.start();
+			fun();
+			result = std::min( result, static_cast< double >( timer.elapsed_ms_flt() ) );
+		}
+		return result;
+	}
+
+	// renderer receives the name of the GPU unless it already has one
+	json run( bench_case const& c, unsigned frames, std::string& renderer ) {
+		std::ostringstream text;
+		generate_scene( text, c.settings );
+		const std::string scene_json = text.str();
+
+		scene s;
+		const double parse_ms = fastest_ms( [ & ]{
+			std::istringstream stream{ scene_json };
+			s = json2scene( stream );
+		} );
+		shader_options opts;
+		if( c.hybrid ) {
+			s.data_driven = true;
+			opts.hybrid = true;
+		}
+		std::string code;
+		const double codegen_ms = fastest_ms( [ & ]{
+			code = scene2glsl( s, opts );
+		} );
+
+		// without the cache, so that the shader is really compiled
+		tracer t{ s, opts, false };
+		sf::RenderTexture target;
+		if( !target.create( c.width, c.height ) )
+			throw std::runtime_error{ "unable to create the offscreen render target" };
+		target.setView( sf::View{ { 0, 1, 1, -1 } } );
+		t.set_resolution( c.width, c.height );
+		t.set_camera( camera{} );
+
+		const auto frame_ms = [ & ]{
+			stopwatch timer;
+			timer.start();
+			target.clear();
+			t.draw( target );
+			target.display();
+			// without this we would only measure how fast the driver queues commands
+			glFinish();
+			return static_cast< double >( timer.elapsed_ms_flt() );
+		};
+		// drivers may put off part of the compilation until the shader is first used
+		const double first_frame_ms = frame_ms();
+		for( unsigned i = 0; i < warmup_frames; ++i )
+			frame_ms();
+		std::vector< double > times;
+		times.reserve( frames );
+		for( unsigned i = 0; i < frames; ++i )
+			times.push_back( frame_ms() );
+		const frame_stats stats{ times };
+		if( renderer.empty() )
+			renderer = reinterpret_cast< char const* >( glGetString( GL_RENDERER ) );
+
+		return {
+			{ "name", c.name },
+			{ "spheres", c.settings.spheres },
+			{ "lights", c.settings.lights },
+			{ "recursion", c.settings.recursion },
+			{ "SS", c.settings.SS },
+			{ "width", c.width },
+			{ "height", c.height },
+			{ "hybrid", c.hybrid },
+			{ "json_bytes", scene_json.size() },
+			{ "parse_ms", parse_ms },
+			{ "codegen_ms", codegen_ms },
+			{ "code_bytes", code.size() },
+			{ "compile_ms", t.compile_ms() },
+			{ "first_frame_ms", first_frame_ms },
+			{ "frame_ms", stats.median },
+			{ "frame_p99_ms", stats.p99 }
+		};
+	}
+
+	// prints every regression of report against baseline and returns how many there are
+	unsigned compare( json const& report, json const& baseline, double tolerance ) {
+		if( baseline.value( "version", 0 ) != report_version )
+			throw std::runtime_error{ "the baseline was written by an incompatible version of glossy-bench-render" };
+		if( baseline.value( "renderer", "" ) != report.value( "renderer", "" ) )
+			std::cout << "warning: the baseline was measured on " << baseline.value( "renderer", "an unknown renderer" ) << '\n';
+
+		unsigned regressions = 0;
+		for( auto const& current : report[ "cases" ] ) {
+			const auto old = std::find_if( baseline[ "cases" ].begin(), baseline[ "cases" ].end(), [ & ]( json const& c ) {
+				return c[ "name" ] == current[ "name" ];
+			} );
+			if( old == baseline[ "cases" ].end() )
+				continue;
+			for( char const* metric : { "parse_ms", "codegen_ms", "compile_ms", "frame_ms", "code_bytes" } ) {
+				const double before = ( *old )[ metric ].get< double >();
+				const double after = current[ metric ].get< double >();
+				// sizes are exact, times are not
+				const double slack = metric == std::string{ "code_bytes" } ? 0.0 : min_regression_ms;
+				if( after > before * ( 1.0 + tolerance ) && after - before > slack ) {
+					std::cout << "REGRESSION " << current[ "name" ].get< std::string >() << ' ' << metric << ": "
+							  << before << " -> " << after << " (+" << static_cast< int >( ( after / before - 1.0 ) * 100.0 + 0.5 ) << "%)\n";
+					++regressions;
+				}
+			}
+		}
+		return regressions;
+	}
+
+	unsigned parse_unsigned( std::string const& option, char const* value ) {
+		char* end;
+		const unsigned long result = std::strtoul( value, &end, 10 );
+		if( end == value || *end != '\0' || result == 0 || result > std::numeric_limits< unsigned >::max() )
+			throw std::runtime_error{ option + " expects a positive integer, got " + value };
+		return static_cast< unsigned >( result );
+	}
+	double parse_fraction( std::string const& option, char const* value ) {
+		char* end;
+		const double result = std::strtod( value, &end );
+		if( end == value || *end != '\0' || !( result >= 0.0 ) )
+			throw std::runtime_error{ option + " expects a non-negative number, got " + value };
+		return result;
+	}
+}
+
+int main( int argc, char** argv )
+try {
+	std::string out = "glossy-bench-render.json";
+	std::string baseline_file;
+	std::string filter;
+	double tolerance = 0.15;
+	unsigned frames = 100;
+	for( int i = 1; i < argc; ++i ) {
+		const std::string arg = argv[ i ];
+		const auto value = [ & ]() -> char const* {
+			if( i + 1 >= argc )
+				throw std::runtime_error{ "missing value for " + arg };
+			return argv[ ++i ];
+		};
+		if( arg == "--help" || arg == "-h" ) {
+			std::cout << usage;
+			return 0;
+		} else if( arg == "--out" ) {
+			out = value();
+		} else if( arg == "--baseline" ) {
+			baseline_file = value();
+		} else if( arg == "--tolerance" ) {
+			tolerance = parse_fraction( arg, value() );
+		} else if( arg == "--frames" ) {
+			frames = parse_unsigned( arg, value() );
+		} else if( arg == "--filter" ) {
+			filter = value();
+		} else {
+			throw std::runtime_error{ "unrecognized option: " + arg };
+		}
+	}
+
+	// read the baseline first so that a bad path fails before the long part
+	json baseline;
+	if( !baseline_file.empty() ) {
+		std::ifstream file{ baseline_file };
+		if( !file )
+			throw std::runtime_error{ "unable to read " + baseline_file };
+		baseline = json::parse( file );
+	}
+
+	json report{ { "version", report_version }, { "frames", frames }, { "cases", json::array() } };
+	std::string renderer;
+	for( auto const& c : make_cases() ) {
+		if( c.name.find( filter ) == std::string::npos )
+			continue;
+		json result = run( c, frames, renderer );
+		std::cout << c.name << ": parse " << result[ "parse_ms" ].get< double >() << " ms, codegen " << result[ "codegen_ms" ].get< double >()
+				  << " ms (" << result[ "code_bytes" ].get< std::size_t >() << " bytes), compile " << result[ "compile_ms" ].get< double >()
+				  << " ms, " << result[ "frame_ms" ].get< double >() << " ms/frame (p99 " << result[ "frame_p99_ms" ].get< double >() << ")\n";
+		report[ "cases" ].push_back( std::move( result ) );
+	}
+	report[ "renderer" ] = renderer;
+
+	std::ofstream file{ out, std::ofstream::trunc };
+	file << report.dump( 1, '\t' ) << '\n';
+	if( !file )
+		throw std::runtime_error{ "unable to write " + out };
+	std::cout << "report written to " << out << '\n';
+
+	if( !baseline_file.empty() ) {
+		const unsigned regressions = compare( report, baseline, tolerance );
+		if( regressions != 0 ) {
+			std::cout << "FAILED: " << regressions << " regression(s) against " << baseline_file << '\n';
+			return 1;
+		}
+		std::cout << "no regressions against " << baseline_file << '\n';
+	}
+	return 0;
+} catch( std::exception const& e ) {
+	std::cerr << e.what() << '\n';
+	return 1;
+}
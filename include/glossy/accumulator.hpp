@@ -0,0 +1,50 @@
+#ifndef glossy_accumulator_hpp_included
+#define glossy_accumulator_hpp_included
+
+#include <glossy/tracer.hpp>
+#include <glossy/float_target.hpp>
+#include <SFML/Graphics.hpp>
+
+namespace glossy {
+	// progressive rendering: every draw call adds one jittered sample per pixel to a running
+	// average in a pair of float targets that take turns as history and destination, and shows
+	// that average. with a tracer that is not progressive, every frame replaces the average,
+	// which lets adaptive sampling report the number of samples it took through alpha.
+	class accumulator {
+		float_target m_targets[ 2 ];
+		unsigned m_current = 0; // the target that holds the average
+		unsigned m_samples = 0;
+		sf::Shader m_resolve;
+		sf::RectangleShape m_shape{ { 1, 1 } };
+		// the alpha of a recent frame on its way to main memory, for recent_average_spp
+		GLuint m_spp_buffer = 0;
+		GLsync m_spp_fence = nullptr; // null without GL 3.2 or ARB_sync
+		bool m_spp_pending = false;
+		double m_recent_spp = 0.0;
+		std::size_t m_pixels = 0;
+
+	public:
+		// requires an active context
+		accumulator();
+		accumulator( accumulator const& ) = delete;
+		accumulator& operator=( accumulator const& ) = delete;
+		~accumulator();
+
+		// starts over
+		void set_resolution( unsigned int width, unsigned int height );
+		// starts over; has to be called whenever the image changes, e.g. when the camera moves
+		void reset();
+		unsigned samples() const;
+		// the mean number of samples per pixel the last frame took; stalls until the GPU is done
+		double average_spp() const;
+		// the same for a frame that was drawn a while ago, without waiting for the GPU: collects the
+		// copy that the previous call queued once it arrived, and queues the latest frame then.
+		// zero until the first copy arrives.
+		double recent_average_spp();
+
+		// the target's view has to map the unit square onto the whole target, i.e. { 0, 1, 1, -1 }
+		void draw( tracer& t, sf::RenderTarget& target );
+	};
+}
+
+#endif // !glossy_accumulator_hpp_included
@@ -0,0 +1,23 @@
+#ifndef glossy_binary_scene_hpp_included
+#define glossy_binary_scene_hpp_included
+
+#include <glossy/scene.hpp>
+#include <string>
+
+namespace glossy {
+	// a compact binary scene format that loads without any parsing. the file is a header of
+	// settings and counts followed by structure-of-arrays blocks (materials, spheres, planes,
+	// lights, meshes) and a table of the NUL-terminated light position expressions and mesh file
+	// names. everything is 4 byte little endian; see binary_scene.cpp for the exact layout.
+	extern char const* const binary_scene_extension; // ".glsb"
+
+	// maps the file into memory and copies the arrays straight out of it. mesh files that are
+	// not absolute are relative to the directory of filename, as with JSON scenes.
+	scene binary2scene( std::string const& filename );
+	void scene2binary( scene const& s, std::string const& filename );
+
+	// whether filename ends with binary_scene_extension
+	bool is_binary_scene( std::string const& filename );
+}
+
+#endif // !glossy_binary_scene_hpp_included
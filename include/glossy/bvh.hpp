@@ -0,0 +1,42 @@
+#ifndef glossy_bvh_hpp_included
+#define glossy_bvh_hpp_included
+
+#include <glossy/util.hpp>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+namespace glossy {
+	struct aabb {
+		vec3 min{ std::numeric_limits< float >::infinity(), std::numeric_limits< float >::infinity(), std::numeric_limits< float >::infinity() };
+		vec3 max{ -std::numeric_limits< float >::infinity(), -std::numeric_limits< float >::infinity(), -std::numeric_limits< float >::infinity() };
+
+		void grow( vec3 const& p );
+		void grow( aabb const& box );
+		vec3 centroid() const;
+		float area() const;
+	};
+
+	// a bounding volume hierarchy built with the surface area heuristic
+	struct bvh {
+		// the traversal in the shader keeps a stack of this many nodes, so the builder never goes deeper
+		static constexpr unsigned max_depth = 32;
+		static constexpr unsigned max_leaf_size = 4;
+
+		struct node {
+			aabb bounds;
+			// inner nodes (count == 0) have their children at first and first + 1,
+			// leaves reference the primitives first to first + count - 1
+			std::uint32_t first = 0;
+			std::uint32_t count = 0;
+		};
+
+		std::vector< node > nodes; // the root is nodes[ 0 ]
+		std::vector< std::uint32_t > indices; // maps the order of the leaves to the original primitives
+	};
+
+	// an empty list of boxes results in an empty hierarchy without even a root
+	bvh build_bvh( std::vector< aabb > const& boxes );
+}
+
+#endif // !glossy_bvh_hpp_included
@@ -0,0 +1,32 @@
+#ifndef glossy_camera_hpp_included
+#define glossy_camera_hpp_included
+
+#include <glossy/util.hpp>
+
+namespace glossy {
+	// a first person camera; at, up and right always form an orthonormal basis
+	class camera {
+		vec3 m_pos{ 0, 1, 0 };
+		float m_alpha = 0;
+		float m_beta = 0;
+		vec3 m_at{ 0, 0, 1 };
+		vec3 m_up{ 0, 1, 0 };
+		vec3 m_right{ 1, 0, 0 };
+
+		void update();
+
+	public:
+		vec3 get_position() const;
+		void set_position( vec3 const& p );
+		void move( vec3 const& v );
+
+		void rotate_x( float angle );
+		void rotate_y( float angle );
+
+		vec3 get_at() const;
+		vec3 get_up() const;
+		vec3 get_right() const;
+	};
+}
+
+#endif // !glossy_camera_hpp_included
@@ -0,0 +1,85 @@
+#ifndef glossy_cpu_tracer_hpp_included
+#define glossy_cpu_tracer_hpp_included
+
+#include <glossy/scene.hpp>
+#include <glossy/camera.hpp>
+#include <glossy/thread_pool.hpp>
+#include <glossy/kernels.hpp>
+#include <glossy/denoise.hpp>
+#include <glossy/expression.hpp>
+#include <glossy/util.hpp>
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace glossy {
+	// the CPU back end: a C++ port of the shader generated by scene2glsl that serves as
+	// ground truth for the GPU and as a fallback on machines without a usable GL driver.
+	// the primary rays of a tile are traced as one stream through the packet kernels. scenes
+	// with denoise_settings are filtered by denoise once all tiles are done.
+	class cpu_tracer {
+		struct ray {
+			vec3 o;
+			vec3 d;
+		};
+		struct light_t {
+			vec3 p;
+			vec3 col;
+		};
+		// a light::is_evaluable light, whose position set_time computes
+		struct animated_light {
+			std::size_t index; // into m_lights
+			expression x, y, z;
+		};
+
+		thread_pool& m_pool;
+		unsigned m_SS;
+		float m_fovh;
+		vec3 m_background;
+		unsigned m_recursion;
+		float m_rendering_distance;
+		denoise_settings m_denoise;
+		kernels::spheres m_spheres;
+		kernels::planes m_planes;
+		std::vector< material > m_materials; // indexed like the kernels' object ids
+		std::vector< light_t > m_lights;
+		std::vector< animated_light > m_animated;
+
+		unsigned m_width = 0;
+		unsigned m_height = 0;
+		camera m_camera;
+		std::vector< sf::Uint8 > m_pixels;
+		// the unrounded image and its guides, bottom row first; empty unless denoising
+		std::vector< vec3 > m_image;
+		std::vector< pixel_guide > m_guides;
+
+		vec3 pathtrace( ray const& r, unsigned depth ) const;
+		vec3 shade( ray const& r, std::int32_t id, float dist, unsigned depth ) const;
+		vec3 materialize( ray const& r, material const& mat, vec3 glob, vec3 rel, vec3 n, unsigned depth ) const;
+		vec3 diffuse( light_t const& l, vec3 col, vec3 p, vec3 n ) const;
+		bool visible( ray const& r, light_t const& l ) const;
+		// like the shader's set_guides
+		pixel_guide guide( ray const& r, std::int32_t id, float dist ) const;
+		ray primary_ray( vec2 screen_coord ) const;
+		void store( unsigned x, unsigned y, vec3 color );
+		void render_tile( unsigned x0, unsigned y0, unsigned x1, unsigned y1 );
+
+	public:
+		static constexpr unsigned tile_size = 32;
+
+		cpu_tracer( scene const& s, thread_pool& pool );
+
+		void set_resolution( unsigned int width, unsigned int height );
+		void set_camera( camera const& cam );
+		// moves the animated lights
+		void set_time( float seconds );
+
+		void render();
+		// the last rendered frame, top row first
+		sf::Image get_image() const;
+		// the same as RGBA pixels
+		std::vector< sf::Uint8 > const& get_pixels() const;
+	};
+}
+
+#endif // !glossy_cpu_tracer_hpp_included
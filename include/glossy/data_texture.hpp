@@ -0,0 +1,29 @@
+#ifndef glossy_data_texture_hpp_included
+#define glossy_data_texture_hpp_included
+
+#include <glossy/gl.hpp>
+#include <glossy/scene_data.hpp>
+#include <vector>
+
+namespace glossy {
+	// a floating point texture that hands arrays of vec4 to the shader. texel i lives at
+	// ( i % width, i / width ) so that large arrays stay within the size limits of 2D textures.
+	// creating, uploading and binding require an active context.
+	class data_texture {
+		GLuint m_handle = 0;
+
+	public:
+		static constexpr unsigned width = data_texture_width;
+
+		data_texture();
+		data_texture( data_texture const& ) = delete;
+		data_texture& operator=( data_texture const& ) = delete;
+		~data_texture();
+
+		// four floats per texel
+		void upload( std::vector< float > const& texels );
+		void bind( unsigned unit ) const;
+	};
+}
+
+#endif // !glossy_data_texture_hpp_included
@@ -0,0 +1,23 @@
+#ifndef glossy_denoise_hpp_included
+#define glossy_denoise_hpp_included
+
+#include <glossy/scene.hpp>
+#include <glossy/thread_pool.hpp>
+#include <glossy/util.hpp>
+#include <vector>
+
+namespace glossy {
+	// what the first hits of a pixel's samples have in common, on average
+	struct pixel_guide {
+		vec3 normal{ 0.0f, 0.0f, 0.0f };
+		float dist = -1.0f; // -1 for misses
+		vec3 albedo{ 0.0f, 0.0f, 0.0f }; // the background for misses
+	};
+
+	// the CPU path of the edge-avoiding à-trous filter of settings, which computes what denoiser
+	// does on the GPU. image and guides hold width * height pixels, the bottom row first. the
+	// rows of every iteration are spread over pool.
+	void denoise( std::vector< vec3 >& image, std::vector< pixel_guide > const& guides, unsigned width, unsigned height, denoise_settings const& settings, thread_pool& pool );
+}
+
+#endif // !glossy_denoise_hpp_included
@@ -0,0 +1,31 @@
+#ifndef glossy_denoiser_hpp_included
+#define glossy_denoiser_hpp_included
+
+#include <glossy/tracer.hpp>
+#include <glossy/float_target.hpp>
+#include <SFML/Graphics.hpp>
+
+namespace glossy {
+	// the GPU path of the edge-avoiding à-trous filter of denoise_settings (see denoise for the
+	// CPU one). the tracer draws into three targets at once: the image, the normal and distance
+	// of the first hits and their albedo. the iterations read the guides from there and take
+	// turns on two more targets for the image, and the last one draws into the render target.
+	class denoiser {
+		float_target m_frame{ 3 }; // the tracer's image, ( normal, distance ) and ( albedo, 1 )
+		float_target m_targets[ 2 ];
+		sf::Shader m_filter;
+		sf::RectangleShape m_shape{ { 1, 1 } };
+
+	public:
+		// requires an active context
+		denoiser();
+
+		void set_resolution( unsigned int width, unsigned int height );
+
+		// filters the image as t's get_denoise says, or not at all without iterations. the
+		// target's view has to map the unit square onto the whole target, i.e. { 0, 1, 1, -1 }.
+		void draw( tracer& t, sf::RenderTarget& target );
+	};
+}
+
+#endif // !glossy_denoiser_hpp_included
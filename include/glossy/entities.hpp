@@ -3,6 +3,9 @@
 
 #include <glossy/util.hpp>
 #include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
 
 namespace glossy {
 	struct material {
@@ -11,28 +14,46 @@ namespace glossy {
 		bool diffuse = true;
 		bool specular = false;
 
+		// the bits of type(), and how many values it can take
+		enum : unsigned {
+			checkered_bit = 0x01u,
+			diffuse_bit = 0x02u,
+			specular_bit = 0x04u,
+			type_count = 0x08u
+		};
+
+		// the bit mask the shader calls material::type
+		unsigned type() const;
 		std::ostream& print( std::ostream& stream ) const;
 	};
 
+	// what all shapes have in common; scenes keep every shape in an array of its own, so there is
+	// no need to handle them through this
 	struct object {
 		vec3 position{ 0.0, 0.0, 0.0 };
 		material mat;
-
-		virtual ~object() = default;
-		virtual std::ostream& print( std::ostream& stream ) const = 0;
-		virtual char const* type() const = 0;
 	};
 	struct sphere : public object {
 		float radius = 1.0;
 
-		virtual std::ostream& print( std::ostream& stream ) const override;
-		virtual char const* type() const override;
+		std::ostream& print( std::ostream& stream ) const;
+		char const* type() const;
 	};
 	struct plane : public object {
 		vec3 normal{ 0.0, 1.0, 0.0 };
 
-		virtual std::ostream& print( std::ostream& stream ) const override;
-		virtual char const* type() const override;
+		std::ostream& print( std::ostream& stream ) const;
+		char const* type() const;
+	};
+	// triangles from an OBJ or PLY file (see load_meshes), scaled and then moved to position.
+	// meshes are always traced through data textures, so they have no shader code of their own.
+	struct mesh : public object {
+		std::string file; // as given in the scene file
+		float scale = 1.0;
+
+		// in the coordinates of the file
+		std::vector< vec3 > vertices;
+		std::vector< std::uint32_t > indices; // three per triangle
 	};
 
 	// in order to allow moving lights, the position is stored as a vector of strings
@@ -40,6 +61,13 @@ namespace glossy {
 		strvec3 position{ "0.0", "0.0", "0.0" };
 		vec3 color{ 1.0, 1.0, 1.0 };
 
+		// true iff every component of the position is a plain number rather than an expression
+		bool is_static() const;
+		// true iff the position is animated, but only with expressions that glossy::expression
+		// supports, so that it can be computed on the CPU once per frame instead of in the shader
+		bool is_evaluable() const;
+		// throws unless is_static()
+		vec3 static_position() const;
 		std::ostream& print( std::ostream& stream ) const;
 	};
 }
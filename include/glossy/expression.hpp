@@ -0,0 +1,40 @@
+#ifndef glossy_expression_hpp_included
+#define glossy_expression_hpp_included
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace glossy {
+	// a GLSL float expression of global_time, such as the components of animated light positions,
+	// translated for evaluation on the CPU. the subset covers numbers, + - * / and parentheses,
+	// global_time and the common built-in functions of floats, from sin to smoothstep. numbers
+	// without a point are ints like in GLSL, whose division truncates; it is left out, as are
+	// octal numbers.
+	class expression {
+		enum class op : std::uint8_t;
+		struct instruction {
+			op code;
+			float value; // of constants
+		};
+		std::vector< instruction > m_code; // in postfix order
+		std::size_t m_depth = 0; // of the stack that evaluating takes
+
+		class parser;
+		// how many values code pops from the stack; each instruction pushes one
+		static unsigned operands( op code );
+
+	public:
+		// the constant 0
+		expression();
+		// throws std::invalid_argument if source is not in the subset
+		explicit expression( std::string const& source );
+
+		// whether source is in the subset
+		static bool supported( std::string const& source );
+
+		float operator()( float global_time ) const;
+	};
+}
+
+#endif // !glossy_expression_hpp_included
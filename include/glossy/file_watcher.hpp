@@ -0,0 +1,34 @@
+#ifndef glossy_file_watcher_hpp_included
+#define glossy_file_watcher_hpp_included
+
+#include <glossy/stopwatch.hpp>
+#include <string>
+#include <ctime>
+
+namespace glossy {
+	// tells whether a file has been written to. on Linux, inotify watches the file's directory,
+	// which also catches editors that save by renaming a new file over the old one; elsewhere the
+	// modification time is polled twice per second.
+	class file_watcher {
+		std::string m_filename;
+		// inotify instance and watch on Linux
+		int m_fd = -1;
+		int m_watch = -1;
+		std::string m_name; // without the directory, as inotify reports it
+		std::time_t m_modified = 0;
+		stopwatch m_poll;
+
+	public:
+		// throws std::runtime_error if the file cannot be watched
+		explicit file_watcher( std::string const& filename );
+		file_watcher( file_watcher const& ) = delete;
+		file_watcher& operator=( file_watcher const& ) = delete;
+		~file_watcher();
+
+		// whether the file changed since the previous call; never blocks. one save may take
+		// several writes, so a file that changed may still be incomplete.
+		bool changed();
+	};
+}
+
+#endif // !glossy_file_watcher_hpp_included
@@ -0,0 +1,51 @@
+#ifndef glossy_float_target_hpp_included
+#define glossy_float_target_hpp_included
+
+#include <glossy/gl.hpp>
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace glossy {
+	// an RGBA32F texture that can be rendered into, for results that must not be rounded to
+	// 8 bits, or several of the same size that shaders write at once through gl_FragData.
+	// everything requires an active context; framebuffers are not shared between contexts, so
+	// the one behind this is created on first use in the context active then.
+	class float_target {
+		std::vector< GLuint > m_textures;
+		GLuint m_framebuffer = 0;
+		unsigned int m_width = 0;
+		unsigned int m_height = 0;
+
+	public:
+		// redirects rendering into the target for its lifetime
+		class binding {
+			GLint m_previous = 0;
+
+		public:
+			explicit binding( float_target& target );
+			binding( binding const& ) = delete;
+			binding& operator=( binding const& ) = delete;
+			~binding();
+		};
+
+		explicit float_target( unsigned count = 1 );
+		float_target( float_target const& ) = delete;
+		float_target& operator=( float_target const& ) = delete;
+		~float_target();
+
+		// the contents are undefined afterwards
+		void resize( unsigned int width, unsigned int height );
+		// the textures are numbered like gl_FragData
+		void bind( unsigned unit, unsigned index = 0 ) const;
+		// the states for drawing into float targets: they replace what is there, alpha included,
+		// where SFML's default alpha blending would mix the data that passes keep in alpha
+		static sf::RenderStates overwrite( sf::Shader const* shader );
+		// reads the texels back, four floats each, bottom row first; stalls until the GPU is done
+		std::vector< float > read( unsigned index = 0 ) const;
+		// queues the same copy into a pixel pack buffer without waiting for it; format selects the
+		// channels, e.g. GL_ALPHA for one float per texel
+		void copy( GLuint pack_buffer, GLenum format, unsigned index = 0 ) const;
+	};
+}
+
+#endif // !glossy_float_target_hpp_included
@@ -0,0 +1,78 @@
+#ifndef glossy_frame_profiler_hpp_included
+#define glossy_frame_profiler_hpp_included
+
+#include <glossy/frame_stats.hpp>
+#include <glossy/stopwatch.hpp>
+#include <array>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace glossy {
+	// per-frame timings of the interactive renderer: the wall-clock time of every frame, CPU spans
+	// within it and the GPU time of its draw calls, which arrives a few frames later (see gpu_timer).
+	// keeps the latest frames for statistics and can write every frame to a log.
+	class frame_profiler {
+	public:
+		enum span : unsigned {
+			events,  // polling and handling window events
+			update,  // moving the camera and uploading uniforms
+			draw,    // issuing draw calls
+			display, // swapping buffers, which includes waiting for vsync
+			span_count
+		};
+
+		struct frame {
+			std::uint64_t index = 0;
+			double cpu_ms = 0.0;
+			std::array< double, span_count > span_ms{};
+			double gpu_ms = -1.0; // negative if not measured
+		};
+
+		// how many frames the statistics cover
+		static constexpr std::size_t history = 256;
+
+		frame_profiler() = default;
+		// writes a line per frame to filename: JSON objects if it ends in ".json" or ".jsonl", CSV otherwise
+		explicit frame_profiler( std::string const& filename );
+		frame_profiler( frame_profiler&& ) = default;
+		frame_profiler& operator=( frame_profiler&& ) = default;
+		// logs the frames that are still waiting for their GPU time without it
+		~frame_profiler();
+
+		// the frame that begin_frame started, to tag its GPU measurement with
+		std::uint64_t current() const;
+
+		void begin_frame();
+		void begin( span s );
+		void end( span s );
+		void end_frame();
+		// the GPU time of an earlier frame; results have to arrive in the order of their frames
+		void set_gpu_ms( std::uint64_t frame, double ms );
+
+		// over the latest completed frames; frames without a GPU measurement do not count towards gpu_stats
+		frame_stats cpu_stats() const;
+		frame_stats gpu_stats() const;
+		frame_stats span_stats( span s ) const;
+		// the latest completed frames, oldest first
+		std::deque< frame > const& frames() const;
+
+	private:
+		std::deque< frame > m_pending; // waiting for their GPU time
+		std::deque< frame > m_history;
+		std::uint64_t m_next = 0;
+		stopwatch m_frame_timer;
+		std::array< stopwatch, span_count > m_span_timers;
+		std::array< bool, span_count > m_span_used{}; // in the current frame
+		std::unique_ptr< std::ofstream > m_log; // null if not logging
+		bool m_json = false;
+
+		void complete( frame const& f );
+	};
+
+	char const* name( frame_profiler::span s );
+}
+
+#endif // !glossy_frame_profiler_hpp_included
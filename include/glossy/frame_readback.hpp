@@ -0,0 +1,52 @@
+#ifndef glossy_frame_readback_hpp_included
+#define glossy_frame_readback_hpp_included
+
+#include <glossy/gl.hpp>
+#include <SFML/System.hpp>
+#include <functional>
+#include <vector>
+
+namespace glossy {
+	// copies frames to main memory without stalling the GPU: read only queues a copy of the
+	// frame into the next of a ring of pixel buffers, behind a fence. a buffer is mapped once
+	// the ring comes around to it again, by when its copy is long done, or by flush. everything
+	// requires the context of the frames to be active.
+	class frame_readback {
+	public:
+		// receives the frames in the order they were read, RGBA and bottom row first
+		using sink = std::function< void( unsigned frame, std::vector< sf::Uint8 > pixels ) >;
+
+	private:
+		struct slot {
+			GLuint buffer = 0;
+			GLsync fence = nullptr; // null without GL 3.2 or ARB_sync, whose drivers block on mapping
+			unsigned frame = 0;
+			bool used = false;
+		};
+
+		unsigned int m_width;
+		unsigned int m_height;
+		sink m_sink;
+		std::vector< slot > m_slots;
+		std::size_t m_next = 0;
+
+		// waits for the copy into s and hands its pixels to the sink
+		void collect( slot& s );
+
+	public:
+		static constexpr unsigned default_depth = 3;
+
+		frame_readback( unsigned int width, unsigned int height, sink done, unsigned depth = default_depth );
+		frame_readback( frame_readback const& ) = delete;
+		frame_readback& operator=( frame_readback const& ) = delete;
+		// drops the frames that were not flushed
+		~frame_readback();
+
+		// queues a copy of the framebuffer bound for reading, which has to be width x height
+		void read( unsigned frame );
+		// hands all queued frames to the sink
+		void flush();
+	};
+}
+
+#endif // !glossy_frame_readback_hpp_included
@@ -0,0 +1,23 @@
+#ifndef glossy_frame_stats_hpp_included
+#define glossy_frame_stats_hpp_included
+
+#include <ostream>
+#include <vector>
+#include <cstddef>
+
+namespace glossy {
+	// aggregate of a series of frame times in milliseconds
+	struct frame_stats {
+		std::size_t count = 0;
+		double min = 0.0;
+		double median = 0.0;
+		double p99 = 0.0;
+		double mean = 0.0;
+
+		frame_stats() = default;
+		explicit frame_stats( std::vector< double > samples );
+	};
+	std::ostream& operator<<( std::ostream& stream, frame_stats const& stats );
+}
+
+#endif // !glossy_frame_stats_hpp_included
@@ -0,0 +1,44 @@
+#ifndef glossy_frame_writer_hpp_included
+#define glossy_frame_writer_hpp_included
+
+#include <glossy/thread_pool.hpp>
+#include <SFML/System.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace glossy {
+	// encodes frames and saves them on a thread pool of its own, so that rendering goes on
+	// meanwhile. the format follows the extension of the file names, like sf::Image::saveToFile.
+	// at most max_pending frames wait for their turn; write blocks while there are more.
+	class frame_writer {
+		std::string m_pattern;
+		unsigned m_max_pending;
+		std::mutex m_mutex;
+		std::condition_variable m_done;
+		unsigned m_pending = 0;
+		std::string m_error; // of the first write that failed
+		// last, so that its workers are gone before the members above
+		thread_pool m_pool;
+
+	public:
+		// zero threads selects one per hardware thread; max_pending defaults to two per thread
+		frame_writer( std::string pattern, unsigned threads = 0, unsigned max_pending = 0 );
+		frame_writer( frame_writer const& ) = delete;
+		frame_writer& operator=( frame_writer const& ) = delete;
+		// waits for the writes, whose errors go unreported
+		~frame_writer();
+
+		// the name of the file of a frame: the last run of '#' in pattern replaced by the frame's
+		// number, padded with zeros to the length of the run
+		static std::string file_name( std::string const& pattern, unsigned frame );
+
+		// pixels are RGBA, top row first unless bottom_up
+		void write( unsigned frame, unsigned int width, unsigned int height, std::vector< sf::Uint8 > pixels, bool bottom_up );
+		// waits for all writes and throws std::runtime_error if any failed
+		void finish();
+	};
+}
+
+#endif // !glossy_frame_writer_hpp_included
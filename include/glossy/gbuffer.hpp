@@ -0,0 +1,51 @@
+#ifndef glossy_gbuffer_hpp_included
+#define glossy_gbuffer_hpp_included
+
+#include <glossy/gl.hpp>
+#include <glossy/scene_data.hpp>
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace glossy {
+	// the first hits of the primary rays of the hybrid mode (see shader_options::hybrid), which
+	// are rasterized instead of traced: a quad around the projection of every sphere and one over
+	// the whole screen for every plane, whose fragments intersect the ray of their pixel with
+	// their object like the tracer does. the depth test keeps the closest hit. three RGBA32F
+	// targets hold, per pixel:
+	//   ( position, rel.x ), ( normal, rel.z ), ( color, material type )
+	// where rel is the position relative to the object, and the material type is -1 where
+	// nothing was hit. everything requires an active context; like float_target's, the
+	// framebuffer is created on first use in the context active then.
+	class gbuffer {
+		GLuint m_textures[ 3 ] = {};
+		GLuint m_depth = 0;
+		GLuint m_framebuffer = 0;
+		unsigned int m_width = 0;
+		unsigned int m_height = 0;
+		sf::Shader m_shader;
+		// three floats per vertex, two triangles per object: ( object, corner x, corner y )
+		std::vector< float > m_corners;
+
+	public:
+		static constexpr unsigned target_count = 3;
+
+		// the spheres and planes are read from the data textures bound to these units, laid out
+		// like scene_data's
+		gbuffer( unsigned sphere_data_unit, unsigned plane_data_unit );
+		gbuffer( gbuffer const& ) = delete;
+		gbuffer& operator=( gbuffer const& ) = delete;
+		~gbuffer();
+
+		// the contents are undefined afterwards
+		void resize( unsigned int width, unsigned int height );
+		// binds the targets to the units first and up, in the order above
+		void bind( unsigned first ) const;
+
+		// rasterizes the first hits of the rays through ( pixel + sample_offset ) of every pixel
+		// of v, i.e. gl_FragCoord.xy + sample_offset in calc. leaves the GL state of target as
+		// SFML expects it.
+		void draw( sf::RenderTarget& target, view const& v, sf::Glsl::Vec2 sample_offset, int sphere_count, int plane_count );
+	};
+}
+
+#endif // !glossy_gbuffer_hpp_included
@@ -0,0 +1,62 @@
+#ifndef glossy_gl_hpp_included
+#define glossy_gl_hpp_included
+
+#include <SFML/OpenGL.hpp>
+#if defined( __APPLE__ )
+	#include <OpenGL/glext.h>
+#else
+	#include <GL/glext.h>
+#endif
+
+// OpenGL entry points beyond 1.1, which SFML does not expose. they are loaded through
+// sf::Context::getFunction and have to be loaded before use.
+namespace glossy {
+	namespace gl {
+		extern PFNGLACTIVETEXTUREPROC ActiveTexture;
+		extern PFNGLGETPROGRAMIVPROC GetProgramiv;
+		extern PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
+		extern PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers;
+		extern PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+		extern PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D;
+		extern PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus;
+		extern PFNGLDRAWBUFFERSPROC DrawBuffers;
+		extern PFNGLGENRENDERBUFFERSPROC GenRenderbuffers;
+		extern PFNGLDELETERENDERBUFFERSPROC DeleteRenderbuffers;
+		extern PFNGLBINDRENDERBUFFERPROC BindRenderbuffer;
+		extern PFNGLRENDERBUFFERSTORAGEPROC RenderbufferStorage;
+		extern PFNGLFRAMEBUFFERRENDERBUFFERPROC FramebufferRenderbuffer;
+
+		extern PFNGLGENQUERIESPROC GenQueries;
+		extern PFNGLDELETEQUERIESPROC DeleteQueries;
+		extern PFNGLBEGINQUERYPROC BeginQuery;
+		extern PFNGLENDQUERYPROC EndQuery;
+		extern PFNGLGETQUERYOBJECTIVPROC GetQueryObjectiv;
+
+		extern PFNGLGENBUFFERSPROC GenBuffers;
+		extern PFNGLDELETEBUFFERSPROC DeleteBuffers;
+		extern PFNGLBINDBUFFERPROC BindBuffer;
+		extern PFNGLBUFFERDATAPROC BufferData;
+		extern PFNGLMAPBUFFERPROC MapBuffer;
+		extern PFNGLUNMAPBUFFERPROC UnmapBuffer;
+
+		// optional: GL 3.3 or ARB_timer_query
+		extern PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v;
+		bool has_timer_query();
+
+		// optional: GL 4.1 or ARB_get_program_binary
+		extern PFNGLGETPROGRAMBINARYPROC GetProgramBinary;
+		extern PFNGLPROGRAMBINARYPROC ProgramBinary;
+		bool has_program_binary();
+
+		// optional: GL 3.2 or ARB_sync
+		extern PFNGLFENCESYNCPROC FenceSync;
+		extern PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+		extern PFNGLDELETESYNCPROC DeleteSync;
+		bool has_sync();
+
+		// requires an active context; throws if the driver lacks a function that is not optional
+		void load();
+	}
+}
+
+#endif // !glossy_gl_hpp_included
@@ -0,0 +1,45 @@
+#ifndef glossy_governor_hpp_included
+#define glossy_governor_hpp_included
+
+#include <glossy/gpu_timer.hpp>
+#include <glossy/stopwatch.hpp>
+#include <SFML/Graphics.hpp>
+#include <functional>
+
+namespace glossy {
+	// dynamic resolution: renders into the lower left part of an offscreen target, scaled so that
+	// a frame takes about the target time, and stretches that part over the window with bilinear
+	// filtering. where timer queries exist, the time is the GPU time that the caller measures and
+	// reports; otherwise it is the time between frames.
+	class governor {
+		double m_target_ms;
+		float m_scale = 1.0f;
+		sf::Vector2u m_size; // of the window
+		sf::RenderTexture m_offscreen;
+		double m_reported_ms = 0.0; // zero if nothing has been reported since the last draw
+		stopwatch m_frame_timer; // without timer queries
+
+		void update_view();
+		bool adjust( double ms );
+
+	public:
+		static constexpr float min_scale = 0.25f;
+
+		explicit governor( double target_ms );
+
+		void set_resolution( unsigned int width, unsigned int height );
+		// the part of the window's resolution that is rendered
+		sf::Vector2u get_render_size() const;
+		float get_scale() const;
+
+		// the GPU time of a recent frame, measured around render in the offscreen target's context
+		void report( double gpu_ms );
+
+		// has render draw into the offscreen target, whose view maps the unit square onto the
+		// rendered part like the tracer expects, and upscales the result onto target. returns
+		// whether the scale changed, which takes effect with the next frame.
+		bool draw( sf::RenderTarget& target, std::function< void( sf::RenderTarget& ) > const& render );
+	};
+}
+
+#endif // !glossy_governor_hpp_included
@@ -0,0 +1,38 @@
+#ifndef glossy_gpu_timer_hpp_included
+#define glossy_gpu_timer_hpp_included
+
+#include <glossy/gl.hpp>
+#include <array>
+#include <cstdint>
+
+namespace glossy {
+	// measures how long the GPU spends on the commands between begin() and end() with timer
+	// queries. results arrive a few frames late instead of stalling the pipeline. query objects
+	// are not shared between contexts, so every call has to happen in the same one.
+	class gpu_timer {
+		static constexpr unsigned latency = 3;
+		std::array< GLuint, latency > m_queries{};
+		std::array< std::uint64_t, latency > m_tags{};
+		unsigned m_next = 0; // the query that begin() uses
+		unsigned m_pending = 0; // queries that have ended but not been read
+
+	public:
+		gpu_timer() = default;
+		gpu_timer( gpu_timer const& ) = delete;
+		gpu_timer& operator=( gpu_timer const& ) = delete;
+		~gpu_timer();
+
+		// false without timer queries, in which case all other functions do nothing
+		static bool is_supported();
+
+		// skips the measurement if all queries are still waiting for results. poll hands tag back
+		// with the result, e.g. to tell which frame it belongs to.
+		void begin( std::uint64_t tag = 0 );
+		void end();
+		// the oldest result that has arrived since the last call, in milliseconds
+		bool poll( double& ms );
+		bool poll( double& ms, std::uint64_t& tag );
+	};
+}
+
+#endif // !glossy_gpu_timer_hpp_included
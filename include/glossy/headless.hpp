@@ -0,0 +1,53 @@
+#ifndef glossy_headless_hpp_included
+#define glossy_headless_hpp_included
+
+#include <glossy/options.hpp>
+#include <glossy/camera.hpp>
+#include <glossy/tracer.hpp>
+#include <glossy/accumulator.hpp>
+#include <glossy/temporal_accumulator.hpp>
+#include <glossy/denoiser.hpp>
+#include <glossy/cpu_tracer.hpp>
+#include <glossy/thread_pool.hpp>
+#include <glossy/frame_readback.hpp>
+#include <glossy/frame_writer.hpp>
+#include <SFML/Graphics.hpp>
+#include <memory>
+
+namespace glossy {
+	// renders a fixed number of frames offscreen, on the GPU or the CPU, and reports how long they
+	// took. the scene's time advances by a fixed step per frame. with a sequence, every frame is
+	// saved while the next ones render.
+	class headless {
+		options m_options;
+		unsigned m_SS;
+		camera m_camera;
+
+		// GPU back end
+		std::unique_ptr< sf::RenderTexture > m_target;
+		std::unique_ptr< tracer > m_tracer;
+		std::unique_ptr< accumulator > m_accumulator; // null unless progressive or adaptive
+		std::unique_ptr< temporal_accumulator > m_temporal; // null unless temporal
+		std::unique_ptr< denoiser > m_denoiser; // null unless the scene asks for it
+
+		// CPU back end
+		std::unique_ptr< thread_pool > m_pool;
+		std::unique_ptr< cpu_tracer > m_cpu_tracer;
+
+		// sequences
+		std::unique_ptr< frame_writer > m_writer; // null without one
+		std::unique_ptr< frame_readback > m_readback; // null without one or on the CPU
+
+		headless( options const& opts, scene const& s );
+
+		void render_frame( unsigned frame );
+		sf::Image capture() const;
+
+	public:
+		explicit headless( options const& opts );
+
+		int run();
+	};
+}
+
+#endif // !glossy_headless_hpp_included
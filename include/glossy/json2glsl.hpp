@@ -1,10 +1,38 @@
 #ifndef glossy_json2glsl_hpp_included
 #define glossy_json2glsl_hpp_included
 
+#include <glossy/scene.hpp>
 #include <istream>
 #include <string>
 
 namespace glossy {
+	// also loads the meshes, whose files are relative to the scene file, or to the working
+	// directory for scenes read from a stream
+	scene json2scene( std::string const& filename );
+	scene json2scene( char const* filename );
+	scene json2scene( std::istream& stream );
+
+	// how the generated shader is going to be used, as opposed to what it renders
+	struct shader_options {
+		// trace one sample per pixel instead of the SS grid, offset from the pixel's center by the
+		// uniform jitter in [0, 1)² like the grid, and blend it over the uniform history texture
+		// with a weight of 1 / ( samples + 1 ); see accumulator
+		bool progressive = false;
+		// take the first hits of the primary rays from the uniform textures gbuffer_position,
+		// gbuffer_normal and gbuffer_material (see gbuffer) instead of tracing them. traces one
+		// sample per pixel like progressive does, and requires a data driven scene, whose spheres
+		// and planes the G-buffer is rasterized from.
+		bool hybrid = false;
+		// trace one sample per pixel like progressive, but write the distance to its first hit
+		// into alpha, or -1 if there is none, and leave blending to temporal_accumulator
+		bool temporal = false;
+	};
+
+	// shaders of scenes with denoise_settings::iterations that neither accumulate nor sample
+	// adaptively write the guides of denoiser into gl_FragData[ 1 ] and [ 2 ]. throws
+	// std::invalid_argument for hybrid shaders of scenes that are not data driven.
+	std::string scene2glsl( scene const& s, shader_options const& opts = {} );
+
 	std::string json2glsl( std::string const& filename );
 	std::string json2glsl( char const* filename );
 	std::string json2glsl( std::istream& stream );
@@ -0,0 +1,71 @@
+#ifndef glossy_kernels_hpp_included
+#define glossy_kernels_hpp_included
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// native ports of the shader's intersect() routines that trace whole streams of rays at once,
+// in packets as wide as the vector units the library was compiled for (-march=native)
+namespace glossy {
+	namespace kernels {
+		enum class isa {
+			scalar,
+			avx2,  // 8 rays per packet
+			avx512 // 16 rays per packet
+		};
+		char const* name( isa set );
+		std::size_t width( isa set );
+		// every instruction set this build supports, widest last
+		std::vector< isa > available();
+		isa native();
+
+		// structure-of-arrays object data
+		struct spheres {
+			std::vector< float > x, y, z, r;
+
+			void add( float px, float py, float pz, float radius );
+			std::size_t size() const;
+		};
+		struct planes {
+			std::vector< float > px, py, pz, nx, ny, nz;
+
+			void add( float x, float y, float z, float normal_x, float normal_y, float normal_z );
+			std::size_t size() const;
+		};
+
+		// objects are identified by their index; spheres come first, planes follow
+		constexpr std::int32_t no_hit = -1;
+
+		struct ray {
+			float ox, oy, oz;
+			float dx, dy, dz; // normalized, like in the shader
+		};
+
+		// a stream of rays in structure-of-arrays layout. t holds the maximum distance of a ray on
+		// input and the distance of its closest hit on output. the arrays are padded to a multiple
+		// of the widest packet with rays that cannot hit anything.
+		class rays {
+			std::size_t m_size = 0;
+
+		public:
+			std::vector< float > ox, oy, oz, dx, dy, dz, t;
+			std::vector< std::int32_t > id;
+
+			void resize( std::size_t count );
+			std::size_t size() const;
+			void set( std::size_t i, ray const& r, float max_dist );
+		};
+
+		// finds the closest hit of every ray, i.e. the shader's chain of eval() calls
+		void closest_hit( rays& r, spheres const& s, planes const& p, isa set = native() );
+		// occluded[ i ] is set iff ray i hits anything closer than its t, i.e. the shader's visible()
+		void any_hit( rays const& r, spheres const& s, planes const& p, std::vector< std::uint8_t >& occluded, isa set = native() );
+
+		// single ray versions
+		std::int32_t closest_hit( ray const& r, float& t, spheres const& s, planes const& p );
+		bool any_hit( ray const& r, float t, spheres const& s, planes const& p );
+	}
+}
+
+#endif // !glossy_kernels_hpp_included
@@ -0,0 +1,30 @@
+#ifndef glossy_mapped_file_hpp_included
+#define glossy_mapped_file_hpp_included
+
+#include <string>
+#include <cstddef>
+
+namespace glossy {
+	// a read-only view of a whole file through the virtual memory system, which only reads the
+	// pages that are touched
+	class mapped_file {
+		void const* m_data = nullptr;
+		std::size_t m_size = 0;
+		// HANDLEs of the file and its mapping on Windows
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+
+	public:
+		// throws std::runtime_error if the file cannot be opened or mapped
+		explicit mapped_file( std::string const& filename );
+		mapped_file( mapped_file const& ) = delete;
+		mapped_file& operator=( mapped_file const& ) = delete;
+		~mapped_file();
+
+		// null for empty files
+		char const* data() const;
+		std::size_t size() const;
+	};
+}
+
+#endif // !glossy_mapped_file_hpp_included
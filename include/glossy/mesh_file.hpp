@@ -0,0 +1,21 @@
+#ifndef glossy_mesh_file_hpp_included
+#define glossy_mesh_file_hpp_included
+
+#include <glossy/scene.hpp>
+#include <glossy/thread_pool.hpp>
+#include <string>
+
+namespace glossy {
+	// fills m.vertices and m.indices from a Wavefront OBJ or a PLY (ASCII or binary) file. only
+	// positions and faces are read; polygons are split into fans. the file is mapped into memory,
+	// and OBJ files and the vertices of binary PLY files are parsed in chunks on the pool.
+	void load_mesh( mesh& m, std::string const& filename, thread_pool& pool );
+
+	// loads every mesh of s; file names that are not absolute are relative to directory
+	void load_meshes( scene& s, std::string const& directory );
+
+	// the part of path up to and including the last separator, empty if there is none
+	std::string directory_of( std::string const& path );
+}
+
+#endif // !glossy_mesh_file_hpp_included
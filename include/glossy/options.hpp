@@ -0,0 +1,58 @@
+#ifndef glossy_options_hpp_included
+#define glossy_options_hpp_included
+
+#include <glossy/scene.hpp>
+#include <glossy/json2glsl.hpp>
+#include <string>
+
+namespace glossy {
+	struct options {
+		std::string scene; // JSON or binary (see binary_scene); empty selects the built-in default scene
+		bool help = false;
+
+		// a size of zero selects 2/3 of the desktop resolution
+		unsigned width = 0;
+		unsigned height = 0;
+
+		// forces scene::data_driven
+		bool data_driven = false;
+		// reload the scene file whenever it changes; also forces scene::data_driven, so that edits
+		// of the objects, the static lights, fovy and background do not take a recompilation
+		bool watch = false;
+		// overrides scene::light_samples unless zero
+		unsigned light_samples = 0;
+		bool shader_cache = true;
+		// accumulate samples across frames while the image does not change
+		bool progressive = false;
+		// accumulate samples across frames and reproject them when the camera moves, see temporal_accumulator
+		bool temporal = false;
+		// rasterize the first hits of the primary rays, see shader_options::hybrid; forces scene::data_driven
+		bool hybrid = false;
+		// lowers the render resolution to keep up with this frame rate; zero renders at full resolution
+		unsigned target_fps = 0;
+		// show the frame time overlay from the start; F3 toggles it
+		bool stats = false;
+		// a CSV or JSON lines file to write the timings of every frame to, see frame_profiler
+		std::string stats_log;
+
+		bool headless = false;
+		unsigned frames = 100;
+		std::string out;
+		// saves every frame, see frame_writer::file_name; implies headless
+		std::string sequence;
+		// the fixed time step of headless frames is 1 / fps seconds
+		unsigned fps = 60;
+
+		// the CPU back end always renders headless
+		bool cpu = false;
+		unsigned threads = 0; // zero selects one thread per hardware thread
+	};
+
+	extern char const* const usage;
+
+	options parse_options( int argc, char** argv );
+	scene load_scene( options const& opts );
+	shader_options get_shader_options( options const& opts );
+}
+
+#endif // !glossy_options_hpp_included
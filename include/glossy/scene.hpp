@@ -0,0 +1,61 @@
+#ifndef glossy_scene_hpp_included
+#define glossy_scene_hpp_included
+
+#include <glossy/entities.hpp>
+#include <glossy/util.hpp>
+#include <vector>
+
+namespace glossy {
+	// the edge-avoiding à-trous filter that denoiser and denoise run over finished frames. every
+	// iteration averages 5x5 pixels twice as far apart as the last one's; pixels count less the
+	// more their color, normal, distance (relative to the center's) and albedo differ, falling
+	// off with the sigmas. the color's sigma halves with every iteration, as the image gets
+	// smoother.
+	struct denoise_settings {
+		// the taps of later iterations would be further apart than screens are wide
+		static constexpr unsigned max_iterations = 10;
+
+		// 0 disables the filter
+		unsigned iterations = 0;
+		float sigma_color = 0.5f;
+		float sigma_normal = 0.2f;
+		float sigma_depth = 0.05f;
+		float sigma_albedo = 0.1f;
+	};
+
+	// everything a scene file describes; shared by the shader generator and the other back ends
+	struct scene {
+		unsigned SS = 1;
+		// adaptive sampling starts with SS_min² samples per pixel (but at least two) and adds more,
+		// up to SS², while the standard error of their luminance exceeds adaptive_threshold.
+		// 0 disables it.
+		unsigned SS_min = 0;
+		float adaptive_threshold = 0.01f;
+		float fovy = 60.0;
+		vec3 background{ 0.0, 0.0, 0.0 };
+		unsigned recursion = 0;
+		float rendering_distance = 50.0;
+		bool bvh = false;
+		// objects and static lights go into data textures instead of being baked into the shader
+		bool data_driven = false;
+		// shadow rays per diffuse hit towards static lights picked in proportion to their power,
+		// which keeps the lights in a data texture. 0 takes one towards every light instead.
+		unsigned light_samples = 0;
+		denoise_settings denoise;
+		std::vector< light > lights;
+		// the objects of the scene file by shape, each in the order of the file
+		std::vector< sphere > spheres;
+		std::vector< plane > planes;
+		std::vector< mesh > meshes;
+
+		bool adaptive() const;
+		// a stand-in whose shader compiles quickly however large the scene is, to show while the
+		// scene's own compiles: data driven, with one sample per pixel, no reflections and no
+		// denoising
+		scene preview() const;
+		// throws std::range_error for settings out of their range, named like in scene files
+		void validate() const;
+	};
+}
+
+#endif // !glossy_scene_hpp_included
@@ -0,0 +1,90 @@
+#ifndef glossy_scene_data_hpp_included
+#define glossy_scene_data_hpp_included
+
+#include <glossy/scene.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace glossy {
+	// width of the data textures; texel i of an array lives at ( i % width, i / width )
+	constexpr unsigned data_texture_width = 1024;
+
+	// which parts of a scene the generated shader fetches from data textures or uniforms instead of baking them into constants
+	struct data_layout {
+		bool spheres = false;
+		bool bvh = false; // over the spheres
+		bool planes = false;
+		bool lights = false; // only those with static positions, and only if lit
+		bool light_alias = false; // to sample them, see scene::light_samples
+		bool meshes = false; // always, if there are any
+		bool view = false; // the field of view and the background are uniforms
+		// bit 1 << material::type() of every material that objects may have; all of them in the
+		// data driven mode, in which the materials can change without recompiling
+		unsigned materials = 0;
+		bool lit = false; // some material is diffuse, so the shader looks for lights
+		bool reflective = false; // some material is specular, so the shader follows reflections
+		// primary rays only test the spheres binned into their screen tile, see bin_spheres.
+		// BVHs cull well enough on their own, so only linear searches use tiles.
+		bool tiles = false;
+	};
+	data_layout layout( scene const& s );
+
+	// the arrays behind the data textures; every array holds four floats per texel
+	struct scene_data {
+		// in the order of the BVH's leaves if there is one, two texels each: ( position, radius ), ( color, material type )
+		std::vector< float > spheres;
+		// two texels per node: ( min, first ), ( max, count ); see bvh::node
+		std::vector< float > bvh_nodes;
+		// three texels each: ( position, 0 ), ( normal, 0 ), ( color, material type )
+		std::vector< float > planes;
+		// two texels each: ( position, 0 ), ( color, 0 )
+		std::vector< float > lights;
+		// an alias table over the lights with probabilities proportional to their luminance, one
+		// texel each: ( probability of keeping the light, alias, pdf of the light, pdf of the alias )
+		std::vector< float > light_alias;
+
+		// the vertices of all meshes, moved and scaled, one texel each: ( position, 0 )
+		std::vector< float > mesh_vertices;
+		// in the order of the leaves of mesh_bvh, one texel each: ( three indices into mesh_vertices, index into meshes )
+		std::vector< float > mesh_triangles;
+		// a BVH over all triangles, laid out like bvh_nodes
+		std::vector< float > mesh_bvh;
+		// two texels each: ( position, 0 ), ( color, material type )
+		std::vector< float > meshes;
+	};
+
+	// indices into the mesh textures are stored in floats, which hold integers exactly up to this
+	constexpr std::size_t max_mesh_vertices = std::size_t{ 1 } << 24;
+
+	// fills the arrays that layout( s ) asks for and builds the sphere BVH
+	scene_data pack( scene const& s );
+
+	// in pixels, of the screen tiles that bin_spheres sorts spheres into
+	constexpr unsigned tile_size = 16;
+
+	// where primary rays come from, like in the shader's calc
+	struct view {
+		vec3 position;
+		vec3 at, up, right; // orthonormal
+		float fovh = 1.0f; // the tangent of half the vertical field of view
+		unsigned width = 0;
+		unsigned height = 0;
+		float rendering_distance = 0.0f;
+	};
+	// the arrays behind the tile textures
+	struct tile_lists {
+		unsigned columns = 0;
+		unsigned rows = 0;
+		// one texel per tile, row by row from the bottom: ( first, count, 0, 0 ), where first is
+		// the position of the tile's first sphere in spheres
+		std::vector< float > tiles;
+		// indices into scene_data::spheres, four per texel
+		std::vector< float > spheres;
+	};
+	// bins every sphere of sphere_data, laid out like scene_data::spheres, into the tiles that its
+	// projection may cover. spheres that are behind the camera, off screen or out of the rendering
+	// distance are left out. reuses the memory of result.
+	void bin_spheres( std::vector< float > const& sphere_data, view const& v, tile_lists& result );
+}
+
+#endif // !glossy_scene_data_hpp_included
@@ -0,0 +1,26 @@
+#ifndef glossy_scene_generator_hpp_included
+#define glossy_scene_generator_hpp_included
+
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+namespace glossy {
+	// what generate_scene puts into a scene
+	struct generator_settings {
+		std::size_t spheres = 100;
+		std::size_t lights = 1; // with constant positions
+		std::size_t animated_lights = 0; // moving with global_time
+		unsigned recursion = 0;
+		unsigned SS = 1;
+		std::uint32_t seed = 42;
+	};
+
+	// writes a scene file of randomly placed, coloured and partly specular spheres on a
+	// checkered plane, in front of the default camera and lit from above. the area grows with
+	// the number of spheres so that their density stays the same. equal settings give equal
+	// files on every platform.
+	void generate_scene( std::ostream& stream, generator_settings const& settings );
+}
+
+#endif // !glossy_scene_generator_hpp_included
@@ -0,0 +1,28 @@
+#ifndef glossy_shader_cache_hpp_included
+#define glossy_shader_cache_hpp_included
+
+#include <SFML/Graphics.hpp>
+#include <string>
+
+namespace glossy {
+	// keeps linked program binaries on disk, keyed on a hash of the shader source and the
+	// vendor, renderer and version strings of the driver. everything requires an active
+	// context, and nothing happens if the driver cannot hand out program binaries.
+	class shader_cache {
+		std::string m_directory;
+
+		std::string path( std::string const& code ) const;
+
+	public:
+		// an empty directory selects $XDG_CACHE_HOME/glossy or ~/.cache/glossy
+		explicit shader_cache( std::string directory = {} );
+
+		// replaces the program of shader with the cached binary of code; on a miss, it returns
+		// false and shader has to be compiled from source
+		bool load( sf::Shader& shader, std::string const& code ) const;
+		// stores the program that shader has linked from code; failures are not fatal
+		void store( sf::Shader const& shader, std::string const& code ) const;
+	};
+}
+
+#endif // !glossy_shader_cache_hpp_included
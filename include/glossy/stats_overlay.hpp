@@ -0,0 +1,34 @@
+#ifndef glossy_stats_overlay_hpp_included
+#define glossy_stats_overlay_hpp_included
+
+#include <glossy/frame_profiler.hpp>
+#include <glossy/stopwatch.hpp>
+#include <SFML/Graphics.hpp>
+#include <string>
+
+namespace glossy {
+	// min/avg/p99 of the frame_profiler's timings and a graph of the latest frames, drawn over the
+	// upper left corner of a target. SFML ships no font, so the text uses a built-in 3x5 one.
+	class stats_overlay {
+		sf::VertexArray m_text{ sf::Quads };
+		stopwatch m_refresh; // the text would be unreadable if it changed every frame
+		sf::Vector2f m_text_size;
+		std::string m_startup; // empty before the first frame
+
+		void add_line( std::string const& line );
+
+	public:
+		// font pixels in screen pixels
+		static constexpr float pixel = 2.0f;
+		// frame times that fill the height of the graph
+		static constexpr double graph_ms = 100.0 / 3.0;
+
+		// the time from the tracer's setup to the first frame, shown below the frame timings
+		void set_startup( double ms, bool cache_hit );
+
+		// ignores the target's view and restores it afterwards
+		void draw( sf::RenderTarget& target, frame_profiler const& profiler );
+	};
+}
+
+#endif // !glossy_stats_overlay_hpp_included
@@ -0,0 +1,49 @@
+#ifndef glossy_temporal_accumulator_hpp_included
+#define glossy_temporal_accumulator_hpp_included
+
+#include <glossy/tracer.hpp>
+#include <glossy/float_target.hpp>
+#include <SFML/Graphics.hpp>
+
+namespace glossy {
+	// temporal supersampling for shaders with shader_options::temporal: every draw call traces one
+	// jittered sample per pixel and blends it with the history of the earlier ones, which is
+	// reprojected from where the camera was to where it is. history that saw another distance
+	// than the new sample is disoccluded and dropped. while the camera stands still, the samples
+	// are averaged like the accumulator does; once it moves, the history is capped at
+	// max_history samples and clamped to the colors around the new sample, which keeps
+	// reprojection errors from smearing.
+	class temporal_accumulator {
+		float_target m_current; // the tracer's sample, with the distance to its first hit in alpha
+		float_target m_history[ 2 ]; // take turns as history and destination, laid out like m_current
+		unsigned m_latest = 0; // the history that holds the average
+		unsigned m_samples = 0; // that the average is made of
+		unsigned m_frame = 0; // selects the jitter, which goes on across resets
+		bool m_changed = false;
+		view m_previous; // of the history
+		sf::Shader m_reproject;
+		sf::Shader m_resolve;
+		sf::RectangleShape m_shape{ { 1, 1 } };
+
+	public:
+		// the history that a moving camera or a changing image keeps
+		static constexpr unsigned max_history = 8;
+
+		// requires an active context
+		temporal_accumulator();
+
+		// starts over
+		void set_resolution( unsigned int width, unsigned int height );
+		// starts over; for changes that reprojection cannot follow, e.g. of the scene or the recursion
+		void reset();
+		// keeps the history but treats it like that of a moving camera; for images that change
+		// every frame, e.g. through moving lights
+		void changed();
+		unsigned samples() const;
+
+		// the target's view has to map the unit square onto the whole target, i.e. { 0, 1, 1, -1 }
+		void draw( tracer& t, sf::RenderTarget& target );
+	};
+}
+
+#endif // !glossy_temporal_accumulator_hpp_included
@@ -0,0 +1,56 @@
+#ifndef glossy_thread_pool_hpp_included
+#define glossy_thread_pool_hpp_included
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+
+namespace glossy {
+	// a work-stealing thread pool: every worker owns a queue, works on it from the back and
+	// steals from the front of the other queues once it runs dry
+	class thread_pool {
+	public:
+		using task_t = std::function< void() >;
+
+	private:
+		struct queue {
+			std::mutex mutex;
+			std::deque< task_t > tasks;
+		};
+
+		std::vector< std::unique_ptr< queue > > m_queues;
+		std::vector< std::thread > m_threads;
+		std::atomic< std::size_t > m_queued{ 0 };
+		std::atomic< std::size_t > m_next{ 0 };
+		std::mutex m_mutex;
+		std::condition_variable m_wakeup;
+		bool m_stop = false;
+
+		void push( std::size_t index, task_t task );
+		bool pop( std::size_t index, task_t& task );
+		bool steal( std::size_t index, task_t& task );
+		void work( std::size_t index );
+
+	public:
+		// zero threads selects one thread per hardware thread
+		explicit thread_pool( unsigned threads = 0 );
+		thread_pool( thread_pool const& ) = delete;
+		thread_pool& operator=( thread_pool const& ) = delete;
+		~thread_pool();
+
+		unsigned size() const;
+
+		void submit( task_t task );
+		// runs body( 0 ) to body( count - 1 ) on the pool and returns once all of them finished;
+		// the calling thread helps out. the first exception thrown by body is rethrown.
+		void parallel_for( std::size_t count, std::function< void( std::size_t ) > const& body );
+	};
+}
+
+#endif // !glossy_thread_pool_hpp_included
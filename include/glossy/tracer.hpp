@@ -0,0 +1,142 @@
+#ifndef glossy_tracer_hpp_included
+#define glossy_tracer_hpp_included
+
+#include <glossy/scene.hpp>
+#include <glossy/json2glsl.hpp>
+#include <glossy/scene_data.hpp>
+#include <glossy/camera.hpp>
+#include <glossy/data_texture.hpp>
+#include <glossy/float_target.hpp>
+#include <glossy/gbuffer.hpp>
+#include <glossy/shader_cache.hpp>
+#include <glossy/expression.hpp>
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <memory>
+#include <future>
+#include <vector>
+
+namespace glossy {
+	// the GPU back end: owns the generated fragment shader and draws it over a render target
+	class tracer {
+		// keeps a context active while the GL resources below are created
+		sf::Context m_context;
+		std::unique_ptr< sf::Shader > m_shader;
+		sf::RectangleShape m_shape{ { 1, 1 } };
+		shader_options m_options;
+		std::string m_code;
+		std::unique_ptr< shader_cache > m_cache; // null if disabled
+		bool m_cache_hit = false;
+		bool m_animated = false;
+		bool m_adaptive = false;
+		denoise_settings m_denoise;
+		double m_setup_ms = 0.0;
+		double m_compile_ms = 0.0;
+		data_layout m_layout;
+		data_texture m_sphere_data;
+		data_texture m_bvh_nodes;
+		data_texture m_plane_data;
+		data_texture m_light_data;
+		data_texture m_light_alias;
+		data_texture m_mesh_vertices;
+		data_texture m_mesh_triangles;
+		data_texture m_mesh_bvh;
+		data_texture m_mesh_data;
+		// the spheres of the primary rays of every screen tile, binned again by draw whenever the
+		// camera, the resolution or the spheres changed
+		data_texture m_tile_data;
+		data_texture m_tile_spheres;
+		std::vector< float > m_tile_spheres_data; // scene_data::spheres
+		tile_lists m_tiles;
+		bool m_tiles_dirty = true;
+		std::unique_ptr< gbuffer > m_gbuffer; // null unless shader_options::hybrid
+		int m_sphere_count = 0;
+		int m_plane_count = 0;
+		// of the primary rays, for the tiles and the G-buffer
+		view m_view;
+		// x, y and z of every light::is_evaluable light, which set_time evaluates
+		std::vector< expression > m_light_positions;
+
+		// a recompiled shader starts without uniforms, so they are kept here
+		sf::Glsl::Vec2 m_resolution;
+		camera m_camera;
+		float m_time = 0.0f;
+		unsigned m_recursion = 0;
+		unsigned m_samples = 0;
+		sf::Glsl::Vec2 m_jitter{ 0.5f, 0.5f }; // of the sample within its pixel, for the G-buffer
+		float_target const* m_history = nullptr;
+
+		struct program {
+			std::unique_ptr< sf::Shader > shader;
+			bool cache_hit = false;
+			double compile_ms = 0.0;
+		};
+		// a shader of set_scene_async that is compiled on a worker thread, and its scene
+		struct build {
+			scene s;
+			std::string code;
+			std::future< program > result;
+		};
+		std::unique_ptr< build > m_build; // null unless a build is running
+
+		// compiles code or loads it from the cache; safe to call on any thread with an active context
+		program compile( std::string const& code ) const;
+		// switches to s and uploads its data; p is null if the current shader stays
+		void apply( scene const& s, std::string const& code, program* p );
+
+	public:
+		explicit tracer( scene const& s, shader_options const& opts = {}, bool cache = true );
+
+		// whether the image depends on set_time, i.e. whether the scene has moving lights
+		bool animated() const;
+		// whether the shader samples adaptively and reports its sample counts in alpha; see accumulator
+		bool adaptive() const;
+		shader_options const& get_options() const;
+		// the scene's filter, whose iterations are 0 unless the shader writes its guides; see denoiser
+		denoise_settings const& get_denoise() const;
+		// whether the current shader was loaded from the program binary cache
+		bool cache_hit() const;
+		// how long the constructor took to generate, compile or load the shader and upload the scene
+		double setup_ms() const;
+		// how long the latest shader took to compile and link, or to load from the cache
+		double compile_ms() const;
+
+		// uploads the objects and lights of s and only recompiles the shader if its code changes.
+		// in the data driven mode, that is only the case if the settings or animated lights change.
+		// waits for and discards a build of set_scene_async.
+		void set_scene( scene const& s );
+		// like set_scene, but a new shader is compiled on a worker thread while draw keeps using
+		// the current scene; update switches to the new one once it is ready. returns whether s
+		// took effect right away. waits for a build that is still running and discards it.
+		bool set_scene_async( scene const& s );
+		// whether set_scene_async is compiling a shader
+		bool building() const;
+		// switches to the scene of set_scene_async if its shader is ready and returns whether it
+		// did. rethrows the errors of the build, which leave the current scene in place.
+		bool update();
+
+		void set_resolution( unsigned int width, unsigned int height );
+		void set_camera( camera const& cam );
+		void set_time( float seconds );
+		// how many reflections are followed; set_scene resets it to the scene's recursion. unlike
+		// the other settings of the scene, it does not take a recompilation.
+		void set_recursion( unsigned recursion );
+		unsigned get_recursion() const;
+		// progressive shaders only: how many samples history already averages, which also
+		// selects the jitter of the next one. history has to outlive the following draw calls.
+		void set_progress( unsigned samples, float_target const& history );
+		// temporal shaders only: selects the jitter of the next sample by its index
+		void set_jitter( unsigned sample );
+		// the offset of the next sample from gl_FragCoord, if there is only one
+		sf::Glsl::Vec2 get_jitter() const;
+		// where the primary rays of the next draw call come from
+		view const& get_view() const;
+
+		// the target's view has to map the unit square onto the whole target, i.e. { 0, 1, 1, -1 }.
+		// into, if given, receives the image instead of target and has to be as large; its
+		// second and third texture receive the guides of denoiser, if the shader writes them.
+		void draw( sf::RenderTarget& target, float_target* into = nullptr );
+	};
+}
+
+#endif // !glossy_tracer_hpp_included
@@ -21,6 +21,7 @@ namespace glossy {
 	float norm_sq( vec3 v );
 	float norm( vec3 v );
 	vec3 normalize( vec3 v );
+	vec3 mul( vec3 u, vec3 v ); // component-wise
 
 	constexpr float pi = 3.14159265359f;
 	constexpr float two_pi = 6.28318530718f;
@@ -1,35 +1,63 @@
 #ifndef glossy_window_hpp_included
 #define glossy_window_hpp_included
 
+#include <glossy/options.hpp>
+#include <glossy/camera.hpp>
+#include <glossy/tracer.hpp>
+#include <glossy/accumulator.hpp>
+#include <glossy/temporal_accumulator.hpp>
+#include <glossy/denoiser.hpp>
+#include <glossy/governor.hpp>
+#include <glossy/gpu_timer.hpp>
+#include <glossy/frame_profiler.hpp>
+#include <glossy/stats_overlay.hpp>
+#include <glossy/file_watcher.hpp>
+#include <glossy/stopwatch.hpp>
 #include <SFML/Graphics.hpp>
+#include <memory>
+#include <future>
 
 namespace glossy {
 	class window {
-		sf::Shader m_shader;
+		options m_options;
+		tracer m_tracer;
+		stopwatch m_startup; // everything between the tracer's setup and the first frame
 		sf::Vector2i m_size;
 		sf::RenderWindow m_window;
 		char const* const m_title = "Glossy";
-		sf::RectangleShape m_shape{ { 1, 1 } };
-		sf::Vector3f m_pos;
-		float m_alpha = 0;
-		float m_beta = 0;
-		sf::Vector3f m_at{ 0, 0, 1 };
-		sf::Vector3f m_up{ 0, 1, 0 };
-		sf::Vector3f m_right;
+		unsigned m_fps = 0; // over the last second, for the title
+		camera m_camera;
+		std::unique_ptr< accumulator > m_accumulator; // null unless progressive or adaptive
+		std::unique_ptr< temporal_accumulator > m_temporal; // null unless temporal
+		std::unique_ptr< denoiser > m_denoiser; // null unless the tracer's scene asks for it
+		std::unique_ptr< governor > m_governor; // null without a target frame rate
+		// around the draw calls of each frame, in the governor's context if there is one
+		gpu_timer m_gpu_timer;
+		frame_profiler m_profiler;
+		stats_overlay m_overlay;
+		bool m_show_stats;
+		std::unique_ptr< file_watcher > m_watcher; // null without --watch
+		// the scene file is parsed on a worker thread, one change at a time
+		std::future< scene > m_reload;
+		bool m_reload_requested = false;
+		// whether the tracer still shows the scene's preview while its own shader compiles
+		bool m_preview = false;
+
+		window( options const& opts, scene const& s );
 
 	protected:
 		void update_resolution( unsigned int width, unsigned int height );
-
-		sf::Vector3f get_position() const;
-		void set_position( sf::Vector3f const& p );
-		void move( sf::Vector3f const& v );
-
-		void rotate_x( float angle );
-		void rotate_y( float angle );
+		void update_render_resolution();
+		void draw_frame( sf::RenderTarget& target );
 		void update_camera();
+		void update_title();
+		// starts and finishes reloads of the scene file, and swaps the preview for the scene
+		void reload();
+		// sets up the accumulator and the denoiser for the tracer's new scene
+		void scene_changed();
 
 	public:
-		window( int argc, char** argv );
+		explicit window( options const& opts );
 
 		int run();
 	};
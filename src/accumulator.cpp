@@ -0,0 +1,99 @@
+#include <glossy/accumulator.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+	// the tracer's data textures live on the units above; they are rebound before it draws
+	constexpr unsigned average_unit = 1;
+
+	char const* const resolve_code =
+		"#version 130\n"
+		"uniform sampler2D average;\n"
+		"void main() {\n"
+		"	gl_FragColor = vec4( texelFetch( average, ivec2( gl_FragCoord.xy ), 0 ).rgb, 1.0 );\n"
+		"}\n";
+}
+
+glossy::accumulator::accumulator() {
+	if( !m_resolve.loadFromMemory( resolve_code, sf::Shader::Fragment ) )
+		throw std::runtime_error{ "unable to process the accumulation shader" };
+	m_resolve.setUniform( "average", static_cast< int >( average_unit ) );
+	gl::GenBuffers( 1, &m_spp_buffer );
+}
+glossy::accumulator::~accumulator() {
+	if( m_spp_fence )
+		gl::DeleteSync( m_spp_fence );
+	gl::DeleteBuffers( 1, &m_spp_buffer );
+}
+
+void glossy::accumulator::set_resolution( unsigned int width, unsigned int height ) {
+	for( auto& target : m_targets )
+		target.resize( width, height );
+	// a pending copy has the old size
+	if( m_spp_fence )
+		gl::DeleteSync( m_spp_fence );
+	m_spp_fence = nullptr;
+	m_spp_pending = false;
+	m_pixels = std::size_t{ width } * height;
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, m_spp_buffer );
+	gl::BufferData( GL_PIXEL_PACK_BUFFER, static_cast< GLsizeiptr >( m_pixels * sizeof( float ) ), nullptr, GL_STREAM_READ );
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	reset();
+}
+void glossy::accumulator::reset() {
+	m_samples = 0;
+}
+unsigned glossy::accumulator::samples() const {
+	return m_samples;
+}
+
+double glossy::accumulator::average_spp() const {
+	// progressive shaders write an alpha of one, adaptive ones the number of samples
+	const std::vector< float > texels = m_targets[ m_current ].read();
+	double sum = 0.0;
+	for( std::size_t i = 3; i < texels.size(); i += 4 )
+		sum += texels[ i ];
+	return texels.empty() ? 0.0 : sum / ( texels.size() / 4 );
+}
+double glossy::accumulator::recent_average_spp() {
+	if( m_spp_pending ) {
+		// without fences, the copy is assumed to be done by the next call
+		if( m_spp_fence ) {
+			if( gl::ClientWaitSync( m_spp_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0 ) == GL_TIMEOUT_EXPIRED )
+				return m_recent_spp;
+			gl::DeleteSync( m_spp_fence );
+			m_spp_fence = nullptr;
+		}
+		gl::BindBuffer( GL_PIXEL_PACK_BUFFER, m_spp_buffer );
+		if( void const* data = gl::MapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY ) ) {
+			float const* alpha = static_cast< float const* >( data );
+			double sum = 0.0;
+			for( std::size_t i = 0; i < m_pixels; ++i )
+				sum += alpha[ i ];
+			m_recent_spp = sum / m_pixels;
+			gl::UnmapBuffer( GL_PIXEL_PACK_BUFFER );
+		}
+		gl::BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+		m_spp_pending = false;
+	}
+	if( m_pixels != 0 ) {
+		m_targets[ m_current ].copy( m_spp_buffer, GL_ALPHA );
+		if( gl::has_sync() )
+			m_spp_fence = gl::FenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		m_spp_pending = true;
+	}
+	return m_recent_spp;
+}
+
+void glossy::accumulator::draw( tracer& t, sf::RenderTarget& target ) {
+	float_target const& history = m_targets[ m_current ];
+	float_target& destination = m_targets[ 1 - m_current ];
+	if( t.get_options().progressive )
+		t.set_progress( m_samples, history );
+	t.draw( target, &destination );
+	m_current = 1 - m_current;
+	++m_samples;
+
+	destination.bind( average_unit );
+	target.draw( m_shape, &m_resolve );
+}
@@ -0,0 +1,357 @@
+#include <glossy/binary_scene.hpp>
+#include <glossy/mapped_file.hpp>
+#include <glossy/mesh_file.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+// layout of a file, in this order:
+//   header
+//   materials: float r[ m ], g[ m ], b[ m ]; uint32 type[ m ] (see material::type)
+//   spheres:   float x[ s ], y[ s ], z[ s ], radius[ s ]; uint32 material[ s ]
+//   planes:    float x[ p ], y[ p ], z[ p ], nx[ p ], ny[ p ], nz[ p ]; uint32 material[ p ]
+//   lights:    float r[ l ], g[ l ], b[ l ]; uint32 x[ l ], y[ l ], z[ l ] (offsets into the strings)
+//   meshes:    float x[ n ], y[ n ], z[ n ], scale[ n ]; uint32 material[ n ], file[ n ] (offset into the strings)
+//   strings:   char[ string_bytes ]
+// mesh files are referenced, not embedded, and loaded like those of JSON scenes
+
+char const* const glossy::binary_scene_extension = ".glsb";
+
+namespace {
+	using namespace glossy;
+
+	constexpr char magic[ 8 ] = { 'g', 'l', 'o', 's', 's', 'y', 's', 'c' };
+	// bump whenever the layout changes
+	constexpr std::uint32_t version = 4;
+
+	enum : std::uint32_t {
+		flag_bvh = 0x01u,
+		flag_data_driven = 0x02u
+	};
+
+	struct header {
+		char magic[ 8 ];
+		std::uint32_t version;
+		std::uint32_t SS;
+		std::uint32_t SS_min;
+		std::uint32_t recursion;
+		std::uint32_t light_samples;
+		float adaptive_threshold;
+		float fovy;
+		float rendering_distance;
+		float background[ 3 ];
+		std::uint32_t denoise_iterations;
+		float denoise_sigmas[ 4 ]; // color, normal, depth, albedo
+		std::uint32_t flags;
+		std::uint32_t material_count;
+		std::uint32_t sphere_count;
+		std::uint32_t plane_count;
+		std::uint32_t light_count;
+		std::uint32_t mesh_count;
+		std::uint32_t string_bytes;
+	};
+	static_assert( sizeof( header ) == 100, "the header must not be padded" );
+	static_assert( sizeof( float ) == 4, "floats must be 32 bit" );
+
+	// hands out the consecutive arrays of a file; the mapping is page aligned and every element
+	// is 4 bytes, so every array is aligned as well
+	class block_reader {
+		char const* m_next;
+
+	public:
+		explicit block_reader( char const* begin )
+			: m_next{ begin } {
+		}
+
+		template< typename T >
+		T const* take( std::size_t count ) {
+			static_assert( sizeof( T ) == 4, "every element of the format is 4 bytes" );
+			T const* result = reinterpret_cast< T const* >( m_next );
+			m_next += count * sizeof( T );
+			return result;
+		}
+	};
+
+	material get_material( std::uint32_t type, vec3 color ) {
+		material result;
+		result.color = color;
+		result.checkered = ( type & 0x01u ) != 0;
+		result.diffuse = ( type & 0x02u ) != 0;
+		result.specular = ( type & 0x04u ) != 0;
+		return result;
+	}
+
+	template< typename T >
+	void write( std::ofstream& file, std::vector< T > const& block ) {
+		file.write( reinterpret_cast< char const* >( block.data() ), static_cast< std::streamsize >( block.size() * sizeof( T ) ) );
+	}
+}
+
+bool glossy::is_binary_scene( std::string const& filename ) {
+	const std::size_t length = std::strlen( binary_scene_extension );
+	return filename.size() >= length && filename.compare( filename.size() - length, length, binary_scene_extension ) == 0;
+}
+
+glossy::scene glossy::binary2scene( std::string const& filename ) {
+	const mapped_file file{ filename };
+	header h;
+	if( file.size() < sizeof( h ) )
+		throw std::runtime_error{ "not a binary scene: " + filename };
+	std::memcpy( &h, file.data(), sizeof( h ) );
+	if( std::memcmp( h.magic, magic, sizeof( magic ) ) != 0 )
+		throw std::runtime_error{ "not a binary scene: " + filename };
+	if( h.version != version )
+		throw std::runtime_error{ "unsupported binary scene version " + std::to_string( h.version ) + " in " + filename + "; convert it again with glossy-pack" };
+
+	const std::uint64_t expected = sizeof( h )
+		+ std::uint64_t{ h.material_count } * 16
+		+ std::uint64_t{ h.sphere_count } * 20
+		+ std::uint64_t{ h.plane_count } * 28
+		+ std::uint64_t{ h.light_count } * 24
+		+ std::uint64_t{ h.mesh_count } * 24
+		+ h.string_bytes;
+	if( expected != file.size() )
+		throw std::runtime_error{ "truncated or corrupt binary scene: " + filename };
+
+	block_reader blocks{ file.data() + sizeof( h ) };
+	const std::size_t m = h.material_count;
+	float const* mat_r = blocks.take< float >( m );
+	float const* mat_g = blocks.take< float >( m );
+	float const* mat_b = blocks.take< float >( m );
+	std::uint32_t const* mat_type = blocks.take< std::uint32_t >( m );
+	const auto get_mat = [ & ]( std::uint32_t i ) {
+		if( i >= m )
+			throw std::runtime_error{ "invalid material index in binary scene: " + filename };
+		return get_material( mat_type[ i ], { mat_r[ i ], mat_g[ i ], mat_b[ i ] } );
+	};
+	// the strings close the file
+	char const* strings = file.data() + file.size() - h.string_bytes;
+	if( h.string_bytes != 0 && strings[ h.string_bytes - 1 ] != '\0' )
+		throw std::runtime_error{ "truncated or corrupt binary scene: " + filename };
+	const auto get_string = [ & ]( std::uint32_t offset ) {
+		if( offset >= h.string_bytes )
+			throw std::runtime_error{ "invalid string offset in binary scene: " + filename };
+		return std::string{ strings + offset };
+	};
+
+	scene s;
+	s.SS = h.SS;
+	s.SS_min = h.SS_min;
+	s.recursion = h.recursion;
+	s.light_samples = h.light_samples;
+	s.adaptive_threshold = h.adaptive_threshold;
+	s.fovy = h.fovy;
+	s.rendering_distance = h.rendering_distance;
+	s.background = { h.background[ 0 ], h.background[ 1 ], h.background[ 2 ] };
+	s.denoise.iterations = h.denoise_iterations;
+	s.denoise.sigma_color = h.denoise_sigmas[ 0 ];
+	s.denoise.sigma_normal = h.denoise_sigmas[ 1 ];
+	s.denoise.sigma_depth = h.denoise_sigmas[ 2 ];
+	s.denoise.sigma_albedo = h.denoise_sigmas[ 3 ];
+	s.bvh = ( h.flags & flag_bvh ) != 0;
+	s.data_driven = ( h.flags & flag_data_driven ) != 0;
+
+	{
+		const std::size_t n = h.sphere_count;
+		float const* x = blocks.take< float >( n );
+		float const* y = blocks.take< float >( n );
+		float const* z = blocks.take< float >( n );
+		float const* radius = blocks.take< float >( n );
+		std::uint32_t const* mat = blocks.take< std::uint32_t >( n );
+		s.spheres.resize( n );
+		for( std::size_t i = 0; i < n; ++i ) {
+			sphere& sph = s.spheres[ i ];
+			sph.position = { x[ i ], y[ i ], z[ i ] };
+			sph.radius = radius[ i ];
+			sph.mat = get_mat( mat[ i ] );
+		}
+	}
+	{
+		const std::size_t n = h.plane_count;
+		float const* x = blocks.take< float >( n );
+		float const* y = blocks.take< float >( n );
+		float const* z = blocks.take< float >( n );
+		float const* nx = blocks.take< float >( n );
+		float const* ny = blocks.take< float >( n );
+		float const* nz = blocks.take< float >( n );
+		std::uint32_t const* mat = blocks.take< std::uint32_t >( n );
+		s.planes.resize( n );
+		for( std::size_t i = 0; i < n; ++i ) {
+			plane& pl = s.planes[ i ];
+			pl.position = { x[ i ], y[ i ], z[ i ] };
+			pl.normal = { nx[ i ], ny[ i ], nz[ i ] };
+			pl.mat = get_mat( mat[ i ] );
+		}
+	}
+	{
+		const std::size_t n = h.light_count;
+		float const* r = blocks.take< float >( n );
+		float const* g = blocks.take< float >( n );
+		float const* b = blocks.take< float >( n );
+		std::uint32_t const* x = blocks.take< std::uint32_t >( n );
+		std::uint32_t const* y = blocks.take< std::uint32_t >( n );
+		std::uint32_t const* z = blocks.take< std::uint32_t >( n );
+		s.lights.resize( n );
+		for( std::size_t i = 0; i < n; ++i ) {
+			light& l = s.lights[ i ];
+			l.color = { r[ i ], g[ i ], b[ i ] };
+			l.position = { get_string( x[ i ] ), get_string( y[ i ] ), get_string( z[ i ] ) };
+		}
+	}
+	{
+		const std::size_t n = h.mesh_count;
+		float const* x = blocks.take< float >( n );
+		float const* y = blocks.take< float >( n );
+		float const* z = blocks.take< float >( n );
+		float const* scale = blocks.take< float >( n );
+		std::uint32_t const* mat = blocks.take< std::uint32_t >( n );
+		std::uint32_t const* file_name = blocks.take< std::uint32_t >( n );
+		s.meshes.resize( n );
+		for( std::size_t i = 0; i < n; ++i ) {
+			mesh& m = s.meshes[ i ];
+			m.position = { x[ i ], y[ i ], z[ i ] };
+			m.scale = scale[ i ];
+			m.mat = get_mat( mat[ i ] );
+			m.file = get_string( file_name[ i ] );
+		}
+	}
+
+	s.validate();
+	load_meshes( s, directory_of( filename ) );
+	return s;
+}
+
+void glossy::scene2binary( scene const& s, std::string const& filename ) {
+	header h{};
+	std::memcpy( h.magic, magic, sizeof( magic ) );
+	h.version = version;
+	h.SS = s.SS;
+	h.SS_min = s.SS_min;
+	h.recursion = s.recursion;
+	h.light_samples = s.light_samples;
+	h.adaptive_threshold = s.adaptive_threshold;
+	h.fovy = s.fovy;
+	h.rendering_distance = s.rendering_distance;
+	h.background[ 0 ] = s.background.x;
+	h.background[ 1 ] = s.background.y;
+	h.background[ 2 ] = s.background.z;
+	h.denoise_iterations = s.denoise.iterations;
+	h.denoise_sigmas[ 0 ] = s.denoise.sigma_color;
+	h.denoise_sigmas[ 1 ] = s.denoise.sigma_normal;
+	h.denoise_sigmas[ 2 ] = s.denoise.sigma_depth;
+	h.denoise_sigmas[ 3 ] = s.denoise.sigma_albedo;
+	h.flags = ( s.bvh ? flag_bvh : 0u ) | ( s.data_driven ? flag_data_driven : 0u );
+
+	// shapes with equal materials share an entry
+	std::map< std::tuple< float, float, float, unsigned >, std::uint32_t > material_ids;
+	std::vector< float > mat_r, mat_g, mat_b;
+	std::vector< std::uint32_t > mat_type;
+	const auto add_material = [ & ]( material const& mat ) {
+		const auto inserted = material_ids.emplace( std::make_tuple( mat.color.x, mat.color.y, mat.color.z, mat.type() ), static_cast< std::uint32_t >( mat_type.size() ) );
+		if( inserted.second ) {
+			mat_r.push_back( mat.color.x );
+			mat_g.push_back( mat.color.y );
+			mat_b.push_back( mat.color.z );
+			mat_type.push_back( mat.type() );
+		}
+		return inserted.first->second;
+	};
+
+	std::vector< float > sph_x, sph_y, sph_z, sph_radius;
+	std::vector< std::uint32_t > sph_mat;
+	for( auto const& sph : s.spheres ) {
+		sph_x.push_back( sph.position.x );
+		sph_y.push_back( sph.position.y );
+		sph_z.push_back( sph.position.z );
+		sph_radius.push_back( sph.radius );
+		sph_mat.push_back( add_material( sph.mat ) );
+	}
+
+	std::vector< float > pl_x, pl_y, pl_z, pl_nx, pl_ny, pl_nz;
+	std::vector< std::uint32_t > pl_mat;
+	for( auto const& pl : s.planes ) {
+		pl_x.push_back( pl.position.x );
+		pl_y.push_back( pl.position.y );
+		pl_z.push_back( pl.position.z );
+		pl_nx.push_back( pl.normal.x );
+		pl_ny.push_back( pl.normal.y );
+		pl_nz.push_back( pl.normal.z );
+		pl_mat.push_back( add_material( pl.mat ) );
+	}
+
+	std::vector< float > l_r, l_g, l_b;
+	std::vector< std::uint32_t > l_x, l_y, l_z;
+	std::vector< char > strings;
+	const auto add_string = [ & ]( std::string const& str ) {
+		const auto result = static_cast< std::uint32_t >( strings.size() );
+		strings.insert( strings.end(), str.begin(), str.end() );
+		strings.push_back( '\0' );
+		return result;
+	};
+	for( auto const& l : s.lights ) {
+		l_r.push_back( l.color.x );
+		l_g.push_back( l.color.y );
+		l_b.push_back( l.color.z );
+		l_x.push_back( add_string( l.position.x ) );
+		l_y.push_back( add_string( l.position.y ) );
+		l_z.push_back( add_string( l.position.z ) );
+	}
+
+	std::vector< float > m_x, m_y, m_z, m_scale;
+	std::vector< std::uint32_t > m_mat, m_file;
+	for( auto const& m : s.meshes ) {
+		m_x.push_back( m.position.x );
+		m_y.push_back( m.position.y );
+		m_z.push_back( m.position.z );
+		m_scale.push_back( m.scale );
+		m_mat.push_back( add_material( m.mat ) );
+		m_file.push_back( add_string( m.file ) );
+	}
+
+	h.material_count = static_cast< std::uint32_t >( mat_type.size() );
+	h.sphere_count = static_cast< std::uint32_t >( s.spheres.size() );
+	h.plane_count = static_cast< std::uint32_t >( s.planes.size() );
+	h.light_count = static_cast< std::uint32_t >( s.lights.size() );
+	h.mesh_count = static_cast< std::uint32_t >( s.meshes.size() );
+	h.string_bytes = static_cast< std::uint32_t >( strings.size() );
+
+	std::ofstream file{ filename, std::ofstream::binary | std::ofstream::trunc };
+	if( !file )
+		throw std::runtime_error{ "unable to write " + filename };
+	file.write( reinterpret_cast< char const* >( &h ), sizeof( h ) );
+	write( file, mat_r );
+	write( file, mat_g );
+	write( file, mat_b );
+	write( file, mat_type );
+	write( file, sph_x );
+	write( file, sph_y );
+	write( file, sph_z );
+	write( file, sph_radius );
+	write( file, sph_mat );
+	write( file, pl_x );
+	write( file, pl_y );
+	write( file, pl_z );
+	write( file, pl_nx );
+	write( file, pl_ny );
+	write( file, pl_nz );
+	write( file, pl_mat );
+	write( file, l_r );
+	write( file, l_g );
+	write( file, l_b );
+	write( file, l_x );
+	write( file, l_y );
+	write( file, l_z );
+	write( file, m_x );
+	write( file, m_y );
+	write( file, m_z );
+	write( file, m_scale );
+	write( file, m_mat );
+	write( file, m_file );
+	write( file, strings );
+	if( !file )
+		throw std::runtime_error{ "unable to write " + filename };
+}
@@ -0,0 +1,137 @@
+#include <glossy/bvh.hpp>
+#include <algorithm>
+#include <numeric>
+#include <array>
+
+namespace {
+	using namespace glossy;
+
+	constexpr unsigned bin_count = 16;
+
+	float component( vec3 const& v, unsigned axis ) {
+		return axis == 0 ? v.x : ( axis == 1 ? v.y : v.z );
+	}
+
+	struct split {
+		unsigned axis = 0;
+		unsigned bin = 0; // primitives in bins [0, bin] go left
+		float cost = std::numeric_limits< float >::infinity();
+	};
+}
+
+void glossy::aabb::grow( vec3 const& p ) {
+	min = { std::min( min.x, p.x ), std::min( min.y, p.y ), std::min( min.z, p.z ) };
+	max = { std::max( max.x, p.x ), std::max( max.y, p.y ), std::max( max.z, p.z ) };
+}
+void glossy::aabb::grow( aabb const& box ) {
+	grow( box.min );
+	grow( box.max );
+}
+glossy::vec3 glossy::aabb::centroid() const {
+	return ( min + max ) / 2.0f;
+}
+float glossy::aabb::area() const {
+	const vec3 e = max - min;
+	if( e.x < 0.0f || e.y < 0.0f || e.z < 0.0f )
+		return 0.0f;
+	return 2.0f * ( e.x * e.y + e.y * e.z + e.z * e.x );
+}
+
+glossy::bvh glossy::build_bvh( std::vector< aabb > const& boxes ) {
+	bvh result;
+	if( boxes.empty() )
+		return result;
+	result.indices.resize( boxes.size() );
+	std::iota( result.indices.begin(), result.indices.end(), 0u );
+
+	result.nodes.emplace_back();
+	result.nodes[ 0 ].first = 0;
+	result.nodes[ 0 ].count = static_cast< std::uint32_t >( boxes.size() );
+
+	struct task {
+		std::uint32_t node;
+		unsigned depth;
+	};
+	std::vector< task > tasks{ { 0, 1 } };
+	while( !tasks.empty() ) {
+		const task t = tasks.back();
+		tasks.pop_back();
+
+		const auto begin = result.indices.begin() + result.nodes[ t.node ].first;
+		const auto end = begin + result.nodes[ t.node ].count;
+		aabb bounds;
+		aabb centroids;
+		for( auto i = begin; i != end; ++i ) {
+			bounds.grow( boxes[ *i ] );
+			centroids.grow( boxes[ *i ].centroid() );
+		}
+		result.nodes[ t.node ].bounds = bounds;
+
+		const std::uint32_t count = result.nodes[ t.node ].count;
+		if( count <= 1 || t.depth >= bvh::max_depth )
+			continue;
+
+		// binned SAH: cost of a split is A_left * N_left + A_right * N_right, that of a leaf A * N
+		const auto bin_of = [ & ]( std::uint32_t prim, unsigned axis ) {
+			const float lo = component( centroids.min, axis );
+			const float extent = component( centroids.max, axis ) - lo;
+			const auto bin = static_cast< unsigned >( ( component( boxes[ prim ].centroid(), axis ) - lo ) / extent * bin_count );
+			return std::min( bin, bin_count - 1 );
+		};
+		split best;
+		for( unsigned axis = 0; axis < 3; ++axis ) {
+			if( component( centroids.max, axis ) <= component( centroids.min, axis ) )
+				continue;
+			std::array< aabb, bin_count > bin_bounds;
+			std::array< std::uint32_t, bin_count > bin_counts{};
+			for( auto i = begin; i != end; ++i ) {
+				const unsigned bin = bin_of( *i, axis );
+				bin_bounds[ bin ].grow( boxes[ *i ] );
+				++bin_counts[ bin ];
+			}
+			// right_cost[ b ] covers the bins above b
+			std::array< float, bin_count > right_cost{};
+			aabb right;
+			std::uint32_t right_count = 0;
+			for( unsigned b = bin_count - 1; b > 0; --b ) {
+				right.grow( bin_bounds[ b ] );
+				right_count += bin_counts[ b ];
+				right_cost[ b - 1 ] = right.area() * right_count;
+			}
+			aabb left;
+			std::uint32_t left_count = 0;
+			for( unsigned b = 0; b < bin_count - 1; ++b ) {
+				left.grow( bin_bounds[ b ] );
+				left_count += bin_counts[ b ];
+				const float cost = left.area() * left_count + right_cost[ b ];
+				if( left_count != 0 && left_count != count && cost < best.cost )
+					best = { axis, b, cost };
+			}
+		}
+
+		const bool splittable = best.cost < std::numeric_limits< float >::infinity();
+		if( count <= bvh::max_leaf_size && ( !splittable || best.cost >= bounds.area() * count ) )
+			continue;
+
+		std::vector< std::uint32_t >::iterator middle;
+		if( splittable )
+			middle = std::partition( begin, end, [ & ]( std::uint32_t prim ) { return bin_of( prim, best.axis ) <= best.bin; } );
+		else // all centroids coincide, any split is as good as another
+			middle = begin + count / 2;
+
+		const auto left = static_cast< std::uint32_t >( result.nodes.size() );
+		bvh::node left_node;
+		left_node.first = result.nodes[ t.node ].first;
+		left_node.count = static_cast< std::uint32_t >( middle - begin );
+		bvh::node right_node;
+		right_node.first = left_node.first + left_node.count;
+		right_node.count = count - left_node.count;
+		result.nodes[ t.node ].first = left;
+		result.nodes[ t.node ].count = 0;
+		result.nodes.push_back( left_node );
+		result.nodes.push_back( right_node );
+		tasks.push_back( { left, t.depth + 1 } );
+		tasks.push_back( { left + 1, t.depth + 1 } );
+	}
+	return result;
+}
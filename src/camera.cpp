@@ -0,0 +1,50 @@
+#include <glossy/camera.hpp>
+#include <cmath>
+
+void glossy::camera::update() {
+	const float sin_x = std::sin( m_alpha );
+	const float cos_x = std::cos( m_alpha );
+	const float sin_y = std::sin( m_beta );
+	const float cos_y = std::cos( m_beta );
+	m_at.x = sin_x *  cos_y;
+	m_at.y =          sin_y;
+	m_at.z = cos_x *  cos_y;
+	m_up.x = sin_x * -sin_y;
+	m_up.y =          cos_y;
+	m_up.z = cos_x * -sin_y;
+	m_right = cross( m_up, m_at );
+}
+
+glossy::vec3 glossy::camera::get_position() const {
+	return m_pos;
+}
+void glossy::camera::set_position( vec3 const& p ) {
+	m_pos = p;
+}
+void glossy::camera::move( vec3 const& v ) {
+	set_position( get_position() + v );
+}
+
+void glossy::camera::rotate_x( float angle ) {
+	m_alpha += angle;
+	if( m_alpha < 0.0f )
+		m_alpha += two_pi;
+	if( m_alpha >= two_pi )
+		m_alpha -= two_pi;
+	update();
+}
+void glossy::camera::rotate_y( float angle ) {
+	m_beta += angle;
+	m_beta = clamp( deg2rad( -90 ), deg2rad( 90 ), m_beta );
+	update();
+}
+
+glossy::vec3 glossy::camera::get_at() const {
+	return m_at;
+}
+glossy::vec3 glossy::camera::get_up() const {
+	return m_up;
+}
+glossy::vec3 glossy::camera::get_right() const {
+	return m_right;
+}
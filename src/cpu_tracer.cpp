@@ -0,0 +1,249 @@
+#include <glossy/cpu_tracer.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+namespace {
+	using namespace glossy;
+
+	float sq( float x ) {
+		return x * x;
+	}
+	// GLSL's mod, which unlike std::fmod never returns negative values for positive y
+	float mod( float x, float y ) {
+		return x - y * std::floor( x / y );
+	}
+	vec3 reflect( vec3 i, vec3 n ) {
+		return i - 2.0f * dot( n, i ) * n;
+	}
+}
+
+glossy::cpu_tracer::cpu_tracer( scene const& s, thread_pool& pool )
+	: m_pool( pool )
+	, m_SS{ s.SS }
+	, m_fovh{ std::tan( deg2rad( s.fovy ) / 2.0f ) }
+	, m_background{ s.background }
+	, m_recursion{ s.recursion }
+	, m_rendering_distance{ s.rendering_distance }
+	, m_denoise{ s.denoise } {
+	if( !s.meshes.empty() )
+		throw std::runtime_error{ "the CPU renderer does not support meshes" };
+	// the kernels number spheres before planes
+	m_materials.reserve( s.spheres.size() + s.planes.size() );
+	for( auto const& sph : s.spheres ) {
+		m_spheres.add( sph.position.x, sph.position.y, sph.position.z, sph.radius );
+		m_materials.push_back( sph.mat );
+	}
+	for( auto const& pl : s.planes ) {
+		m_planes.add( pl.position.x, pl.position.y, pl.position.z, pl.normal.x, pl.normal.y, pl.normal.z );
+		m_materials.push_back( pl.mat );
+	}
+	for( auto const& l : s.lights ) {
+		if( l.is_static() ) {
+			m_lights.push_back( { l.static_position(), l.color } );
+		} else if( l.is_evaluable() ) {
+			m_animated.push_back( { m_lights.size(), expression{ l.position.x }, expression{ l.position.y }, expression{ l.position.z } } );
+			m_lights.push_back( { {}, l.color } );
+		} else {
+			throw std::runtime_error{ "the CPU renderer only supports light positions that glossy::expression can evaluate" };
+		}
+	}
+	set_time( 0.0f );
+}
+
+void glossy::cpu_tracer::set_resolution( unsigned int width, unsigned int height ) {
+	m_width = width;
+	m_height = height;
+	m_pixels.assign( std::size_t{ width } * height * 4, 255 );
+	if( m_denoise.iterations != 0 ) {
+		m_image.resize( std::size_t{ width } * height );
+		m_guides.resize( std::size_t{ width } * height );
+	}
+}
+void glossy::cpu_tracer::set_camera( camera const& cam ) {
+	m_camera = cam;
+}
+void glossy::cpu_tracer::set_time( float seconds ) {
+	for( auto const& a : m_animated )
+		m_lights[ a.index ].p = { a.x( seconds ), a.y( seconds ), a.z( seconds ) };
+}
+
+glossy::vec3 glossy::cpu_tracer::pathtrace( ray const& r, unsigned depth ) const {
+	// the innermost level of the generated shader is pathtracedummy
+	if( depth > m_recursion )
+		return { 1.0f, 1.0f, 1.0f };
+	float dist = m_rendering_distance;
+	const std::int32_t id = kernels::closest_hit( { r.o.x, r.o.y, r.o.z, r.d.x, r.d.y, r.d.z }, dist, m_spheres, m_planes );
+	return shade( r, id, dist, depth );
+}
+
+glossy::vec3 glossy::cpu_tracer::shade( ray const& r, std::int32_t id, float dist, unsigned depth ) const {
+	if( id == kernels::no_hit )
+		return m_background;
+	const vec3 i = r.o + r.d * dist;
+	const std::size_t j = static_cast< std::size_t >( id );
+	if( j < m_spheres.size() ) {
+		const vec3 p{ m_spheres.x[ j ], m_spheres.y[ j ], m_spheres.z[ j ] };
+		return materialize( r, m_materials[ j ], i, i - p, normalize( i - p ), depth );
+	}
+	const std::size_t k = j - m_spheres.size();
+	const vec3 p{ m_planes.px[ k ], m_planes.py[ k ], m_planes.pz[ k ] };
+	const vec3 n{ m_planes.nx[ k ], m_planes.ny[ k ], m_planes.nz[ k ] };
+	return materialize( r, m_materials[ j ], i, i - p, normalize( n ), depth );
+}
+
+glossy::vec3 glossy::cpu_tracer::materialize( ray const& r, material const& mat, vec3 glob, vec3 rel, vec3 n, unsigned depth ) const {
+	vec3 col = mat.color;
+	vec3 result{ 0.0f, 0.0f, 0.0f };
+	float denom = 0.0f;
+	if( mat.checkered ) {
+		if( ( mod( rel.x, 2.0f ) < 1.0f ) != ( mod( rel.z, 2.0f ) < 1.0f ) )
+			col *= 0.5f;
+	}
+	if( mat.diffuse ) {
+		if( m_lights.empty() ) {
+			result += mul( col, m_background );
+		} else {
+			for( auto const& l : m_lights )
+				result += diffuse( l, col, glob, n );
+		}
+		++denom;
+	}
+	if( mat.specular ) {
+		ray ref{ glob, reflect( r.d, n ) };
+		ref.o += ref.d * 1.0e-3f;
+		result += mul( col, pathtrace( ref, depth + 1 ) );
+		++denom;
+	}
+	// the shader divides by zero here, which drivers turn into black
+	if( denom == 0.0f )
+		return result;
+	return result / denom;
+}
+
+glossy::vec3 glossy::cpu_tracer::diffuse( light_t const& l, vec3 col, vec3 p, vec3 n ) const {
+	vec3 path = l.p - p;
+	const float len = norm( path );
+	path /= len;
+	const ray lr{ p + path * 1.0e-2f, path };
+	if( !visible( lr, l ) )
+		return { 0.0f, 0.0f, 0.0f };
+	return mul( l.col, col ) / sq( len ) * dot( path, n );
+}
+
+bool glossy::cpu_tracer::visible( ray const& r, light_t const& l ) const {
+	return !kernels::any_hit( { r.o.x, r.o.y, r.o.z, r.d.x, r.d.y, r.d.z }, norm( r.o - l.p ), m_spheres, m_planes );
+}
+
+glossy::pixel_guide glossy::cpu_tracer::guide( ray const& r, std::int32_t id, float dist ) const {
+	pixel_guide result;
+	if( id == kernels::no_hit ) {
+		result.albedo = m_background;
+		return result;
+	}
+	const vec3 i = r.o + r.d * dist;
+	const std::size_t j = static_cast< std::size_t >( id );
+	vec3 rel;
+	if( j < m_spheres.size() ) {
+		rel = i - vec3{ m_spheres.x[ j ], m_spheres.y[ j ], m_spheres.z[ j ] };
+		result.normal = normalize( rel );
+	} else {
+		const std::size_t k = j - m_spheres.size();
+		rel = i - vec3{ m_planes.px[ k ], m_planes.py[ k ], m_planes.pz[ k ] };
+		result.normal = normalize( vec3{ m_planes.nx[ k ], m_planes.ny[ k ], m_planes.nz[ k ] } );
+	}
+	result.dist = dist;
+	material const& mat = m_materials[ j ];
+	result.albedo = mat.color;
+	if( mat.checkered && ( ( mod( rel.x, 2.0f ) < 1.0f ) != ( mod( rel.z, 2.0f ) < 1.0f ) ) )
+		result.albedo *= 0.5f;
+	return result;
+}
+
+glossy::cpu_tracer::ray glossy::cpu_tracer::primary_ray( vec2 screen_coord ) const {
+	const vec2 resolution{ static_cast< float >( m_width ), static_cast< float >( m_height ) };
+	const vec2 normalized = ( screen_coord - resolution / 2.0f ) * 2.0f / resolution.y * m_fovh;
+	return { m_camera.get_position(), normalize( m_camera.get_at() + normalized.x * m_camera.get_right() + normalized.y * m_camera.get_up() ) };
+}
+
+void glossy::cpu_tracer::render_tile( unsigned x0, unsigned y0, unsigned x1, unsigned y1 ) {
+	const float sub = 1.0f / m_SS;
+	// gl_FragCoord addresses pixel centers, to which the shader adds its own half-step offset
+	const float off = 0.5f + sub / 2.0f;
+	const unsigned samples = m_SS * m_SS;
+
+	thread_local kernels::rays stream;
+	stream.resize( std::size_t{ x1 - x0 } * ( y1 - y0 ) * samples );
+	std::size_t i = 0;
+	for( unsigned y = y0; y < y1; ++y )
+		for( unsigned x = x0; x < x1; ++x )
+			for( unsigned sy = 0; sy < m_SS; ++sy )
+				for( unsigned sx = 0; sx < m_SS; ++sx ) {
+					const ray r = primary_ray( { x + off + sub * sx, y + off + sub * sy } );
+					stream.set( i++, { r.o.x, r.o.y, r.o.z, r.d.x, r.d.y, r.d.z }, m_rendering_distance );
+				}
+	kernels::closest_hit( stream, m_spheres, m_planes );
+
+	i = 0;
+	for( unsigned y = y0; y < y1; ++y ) {
+		for( unsigned x = x0; x < x1; ++x ) {
+			vec3 result{ 0.0f, 0.0f, 0.0f };
+			// summed over the samples
+			pixel_guide g;
+			g.dist = 0.0f;
+			for( unsigned sample = 0; sample < samples; ++sample, ++i ) {
+				const ray r{ { stream.ox[ i ], stream.oy[ i ], stream.oz[ i ] }, { stream.dx[ i ], stream.dy[ i ], stream.dz[ i ] } };
+				result += shade( r, stream.id[ i ], stream.t[ i ], 0 );
+				if( !m_image.empty() ) {
+					const pixel_guide sample_guide = guide( r, stream.id[ i ], stream.t[ i ] );
+					g.normal += sample_guide.normal;
+					g.dist += sample_guide.dist;
+					g.albedo += sample_guide.albedo;
+				}
+			}
+			result /= static_cast< float >( samples );
+
+			if( m_image.empty() ) {
+				store( x, y, result );
+			} else {
+				const std::size_t j = std::size_t{ y } * m_width + x;
+				m_image[ j ] = result;
+				m_guides[ j ] = { g.normal / static_cast< float >( samples ), g.dist / static_cast< float >( samples ), g.albedo / static_cast< float >( samples ) };
+			}
+		}
+	}
+}
+
+void glossy::cpu_tracer::store( unsigned x, unsigned y, vec3 color ) {
+	// y counts upwards like gl_FragCoord, the pixel buffer starts at the top row
+	sf::Uint8* pixel = &m_pixels[ ( std::size_t{ m_height - 1 - y } * m_width + x ) * 4 ];
+	pixel[ 0 ] = static_cast< sf::Uint8 >( clamp( 0.0f, 1.0f, color.x ) * 255.0f + 0.5f );
+	pixel[ 1 ] = static_cast< sf::Uint8 >( clamp( 0.0f, 1.0f, color.y ) * 255.0f + 0.5f );
+	pixel[ 2 ] = static_cast< sf::Uint8 >( clamp( 0.0f, 1.0f, color.z ) * 255.0f + 0.5f );
+}
+
+void glossy::cpu_tracer::render() {
+	const unsigned tiles_x = ( m_width + tile_size - 1 ) / tile_size;
+	const unsigned tiles_y = ( m_height + tile_size - 1 ) / tile_size;
+	m_pool.parallel_for( std::size_t{ tiles_x } * tiles_y, [ & ]( std::size_t tile ) {
+		const unsigned x0 = static_cast< unsigned >( tile % tiles_x ) * tile_size;
+		const unsigned y0 = static_cast< unsigned >( tile / tiles_x ) * tile_size;
+		render_tile( x0, y0, std::min( x0 + tile_size, m_width ), std::min( y0 + tile_size, m_height ) );
+	} );
+	if( m_image.empty() )
+		return;
+	denoise( m_image, m_guides, m_width, m_height, m_denoise, m_pool );
+	m_pool.parallel_for( m_height, [ & ]( std::size_t y ) {
+		for( unsigned x = 0; x < m_width; ++x )
+			store( x, static_cast< unsigned >( y ), m_image[ y * m_width + x ] );
+	} );
+}
+
+sf::Image glossy::cpu_tracer::get_image() const {
+	sf::Image image;
+	image.create( m_width, m_height, m_pixels.data() );
+	return image;
+}
+std::vector< sf::Uint8 > const& glossy::cpu_tracer::get_pixels() const {
+	return m_pixels;
+}
@@ -0,0 +1,29 @@
+#include <glossy/data_texture.hpp>
+#include <algorithm>
+
+glossy::data_texture::data_texture() {
+	glGenTextures( 1, &m_handle );
+	glBindTexture( GL_TEXTURE_2D, m_handle );
+	// texelFetch ignores filtering, but the default filter requires mipmaps we never create
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+}
+glossy::data_texture::~data_texture() {
+	glDeleteTextures( 1, &m_handle );
+}
+
+void glossy::data_texture::upload( std::vector< float > const& texels ) {
+	const std::size_t count = std::max< std::size_t >( texels.size() / 4, 1 );
+	const std::size_t height = ( count + width - 1 ) / width;
+	std::vector< float > padded( width * height * 4, 0.0f );
+	std::copy( texels.begin(), texels.end(), padded.begin() );
+	glBindTexture( GL_TEXTURE_2D, m_handle );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA32F, width, static_cast< GLsizei >( height ), 0, GL_RGBA, GL_FLOAT, padded.data() );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+}
+void glossy::data_texture::bind( unsigned unit ) const {
+	gl::ActiveTexture( GL_TEXTURE0 + unit );
+	glBindTexture( GL_TEXTURE_2D, m_handle );
+	gl::ActiveTexture( GL_TEXTURE0 );
+}
@@ -0,0 +1,66 @@
+#include <glossy/denoise.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+	using namespace glossy;
+
+	// the B3 spline; every tap weighs the product of its column's and its row's
+	constexpr float kernel[ 3 ] = { 0.375f, 0.25f, 0.0625f };
+
+	float sq( float x ) {
+		return x * x;
+	}
+
+	// one iteration over the 5x5 taps that are step pixels apart, for row y of source. the taps
+	// beyond the edges repeat the outermost pixels.
+	void filter_row( std::vector< vec3 > const& source, std::vector< vec3 >& destination, std::vector< pixel_guide > const& guides,
+					 int width, int height, int y, int step, denoise_settings const& settings, float sigma_color ) {
+		const float inv_color = 1.0f / sq( sigma_color );
+		const float inv_normal = 1.0f / sq( settings.sigma_normal );
+		const float inv_albedo = 1.0f / sq( settings.sigma_albedo );
+		for( int x = 0; x < width; ++x ) {
+			const std::size_t center = static_cast< std::size_t >( y ) * width + x;
+			const vec3 c = source[ center ];
+			pixel_guide const& g = guides[ center ];
+			const float inv_depth = 1.0f / sq( settings.sigma_depth * std::max( std::abs( g.dist ), 1.0e-3f ) );
+			vec3 sum{ 0.0f, 0.0f, 0.0f };
+			float weights = 0.0f;
+			for( int dy = -2; dy <= 2; ++dy ) {
+				const int ty = clamp( 0, height - 1, y + dy * step );
+				for( int dx = -2; dx <= 2; ++dx ) {
+					const int tx = clamp( 0, width - 1, x + dx * step );
+					const std::size_t tap = static_cast< std::size_t >( ty ) * width + tx;
+					const vec3 ci = source[ tap ];
+					pixel_guide const& gi = guides[ tap ];
+					const float w = kernel[ std::abs( dx ) ] * kernel[ std::abs( dy ) ] * std::exp(
+						-norm_sq( ci - c ) * inv_color
+						- norm_sq( gi.normal - g.normal ) * inv_normal
+						- sq( gi.dist - g.dist ) * inv_depth
+						- norm_sq( gi.albedo - g.albedo ) * inv_albedo );
+					sum += w * ci;
+					weights += w;
+				}
+			}
+			// the center's weight is never 0
+			destination[ center ] = sum / weights;
+		}
+	}
+}
+
+void glossy::denoise( std::vector< vec3 >& image, std::vector< pixel_guide > const& guides, unsigned width, unsigned height, denoise_settings const& settings, thread_pool& pool ) {
+	std::vector< vec3 > scratch( image.size() );
+	std::vector< vec3 >* source = &image;
+	std::vector< vec3 >* destination = &scratch;
+	for( unsigned i = 0; i < settings.iterations; ++i ) {
+		const int step = 1 << i;
+		const float sigma_color = settings.sigma_color / static_cast< float >( step );
+		pool.parallel_for( height, [ & ]( std::size_t y ) {
+			filter_row( *source, *destination, guides, static_cast< int >( width ), static_cast< int >( height ), static_cast< int >( y ), step, settings, sigma_color );
+		} );
+		std::swap( source, destination );
+	}
+	if( source != &image )
+		image.swap( scratch );
+}
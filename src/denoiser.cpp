@@ -0,0 +1,105 @@
+#include <glossy/denoiser.hpp>
+#include <stdexcept>
+
+namespace {
+	using namespace glossy;
+
+	// the tracer's data textures live on the units above; they are rebound before it draws
+	enum : unsigned {
+		color_unit = 1,
+		normal_dist_unit = 2,
+		albedo_unit = 3
+	};
+
+	// one iteration over the 5x5 taps that are step pixels apart, weighted by the B3 spline and
+	// the differences to the center like denoise does. the taps beyond the edges repeat the
+	// outermost pixels.
+	char const* const filter_code =
+		"#version 130\n"
+		"uniform sampler2D color;\n"
+		"uniform sampler2D normal_dist;\n"
+		"uniform sampler2D albedo;\n"
+		"uniform vec2 resolution;\n"
+		"uniform int step;\n"
+		"uniform float sigma_color;\n"
+		"uniform float sigma_normal;\n"
+		"uniform float sigma_depth;\n"
+		"uniform float sigma_albedo;\n"
+		"const float kernel[ 3 ] = float[ 3 ]( 0.375, 0.25, 0.0625 );\n"
+		"float normsq( vec3 v ) {\n"
+		"	return dot( v, v );\n"
+		"}\n"
+		"void main() {\n"
+		"	ivec2 texel = ivec2( gl_FragCoord.xy );\n"
+		"	ivec2 last = ivec2( resolution ) - 1;\n"
+		"	vec4 c = texelFetch( color, texel, 0 );\n"
+		"	vec4 nd = texelFetch( normal_dist, texel, 0 );\n"
+		"	vec3 a = texelFetch( albedo, texel, 0 ).rgb;\n"
+		"	float depth_scale = sigma_depth * max( abs( nd.w ), 1.0e-3 );\n"
+		"	vec3 sum = vec3( 0.0 );\n"
+		"	float weights = 0.0;\n"
+		"	for( int y = -2; y <= 2; ++y ) {\n"
+		"		for( int x = -2; x <= 2; ++x ) {\n"
+		"			ivec2 i = clamp( texel + ivec2( x, y ) * step, ivec2( 0 ), last );\n"
+		"			vec3 ci = texelFetch( color, i, 0 ).rgb;\n"
+		"			vec4 ndi = texelFetch( normal_dist, i, 0 );\n"
+		"			vec3 ai = texelFetch( albedo, i, 0 ).rgb;\n"
+		"			float w = kernel[ abs( x ) ] * kernel[ abs( y ) ] * exp(\n"
+		"				-normsq( ci - c.rgb ) / ( sigma_color * sigma_color )\n"
+		"				- normsq( ndi.xyz - nd.xyz ) / ( sigma_normal * sigma_normal )\n"
+		"				- ( ndi.w - nd.w ) * ( ndi.w - nd.w ) / ( depth_scale * depth_scale )\n"
+		"				- normsq( ai - a ) / ( sigma_albedo * sigma_albedo ) );\n"
+		"			sum += w * ci;\n"
+		"			weights += w;\n"
+		"		}\n"
+		"	}\n"
+		"	// the center's weight is never 0\n"
+		"	gl_FragColor = vec4( sum / weights, c.a );\n"
+		"}\n";
+}
+
+glossy::denoiser::denoiser() {
+	if( !m_filter.loadFromMemory( filter_code, sf::Shader::Fragment ) )
+		throw std::runtime_error{ "unable to process the denoising shader" };
+	m_filter.setUniform( "color", static_cast< int >( color_unit ) );
+	m_filter.setUniform( "normal_dist", static_cast< int >( normal_dist_unit ) );
+	m_filter.setUniform( "albedo", static_cast< int >( albedo_unit ) );
+}
+
+void glossy::denoiser::set_resolution( unsigned int width, unsigned int height ) {
+	m_frame.resize( width, height );
+	for( auto& target : m_targets )
+		target.resize( width, height );
+	m_filter.setUniform( "resolution", sf::Glsl::Vec2{ static_cast< float >( width ), static_cast< float >( height ) } );
+}
+
+void glossy::denoiser::draw( tracer& t, sf::RenderTarget& target ) {
+	denoise_settings const& settings = t.get_denoise();
+	if( settings.iterations == 0 ) {
+		t.draw( target );
+		return;
+	}
+	t.draw( target, &m_frame );
+
+	m_filter.setUniform( "sigma_normal", settings.sigma_normal );
+	m_filter.setUniform( "sigma_depth", settings.sigma_depth );
+	m_filter.setUniform( "sigma_albedo", settings.sigma_albedo );
+	m_frame.bind( normal_dist_unit, 1 );
+	m_frame.bind( albedo_unit, 2 );
+	float_target const* source = &m_frame;
+	for( unsigned i = 0; i < settings.iterations; ++i ) {
+		m_filter.setUniform( "step", 1 << i );
+		m_filter.setUniform( "sigma_color", settings.sigma_color / static_cast< float >( 1u << i ) );
+		source->bind( color_unit );
+		if( i + 1 == settings.iterations ) {
+			target.draw( m_shape, &m_filter );
+		} else {
+			float_target& destination = m_targets[ i % 2 ];
+			{
+				const float_target::binding bound{ destination };
+				target.draw( m_shape, float_target::overwrite( &m_filter ) );
+			}
+			source = &destination;
+		}
+	}
+}
@@ -1,5 +1,21 @@
 #include <glossy/entities.hpp>
+#include <glossy/expression.hpp>
+#include <stdexcept>
+#include <cstdlib>
 
+namespace {
+	bool parse_constant( std::string const& component, float& value ) {
+		char* end;
+		value = std::strtof( component.c_str(), &end );
+		while( *end == ' ' )
+			++end;
+		return end != component.c_str() && *end == '\0';
+	}
+}
+
+unsigned glossy::material::type() const {
+	return ( checkered ? checkered_bit : 0u ) | ( diffuse ? diffuse_bit : 0u ) | ( specular ? specular_bit : 0u );
+}
 std::ostream& glossy::material::print( std::ostream& stream ) const {
 	stream << "material( ";
 	if( !checkered && !diffuse && !specular ) {
@@ -49,6 +65,19 @@ char const* glossy::plane::type() const {
 	return "plane";
 }
 
+bool glossy::light::is_static() const {
+	float value;
+	return ::parse_constant( position.x, value ) && ::parse_constant( position.y, value ) && ::parse_constant( position.z, value );
+}
+bool glossy::light::is_evaluable() const {
+	return !is_static() && expression::supported( position.x ) && expression::supported( position.y ) && expression::supported( position.z );
+}
+glossy::vec3 glossy::light::static_position() const {
+	vec3 result;
+	if( !::parse_constant( position.x, result.x ) || !::parse_constant( position.y, result.y ) || !::parse_constant( position.z, result.z ) )
+		throw std::runtime_error{ "light position is not constant: " + position.x + ", " + position.y + ", " + position.z };
+	return result;
+}
 std::ostream& glossy::light::print( std::ostream& stream ) const {
 	stream << "light( vec3" << position << ", vec3" << color << " )";
 	return stream;
@@ -0,0 +1,291 @@
+#include <glossy/expression.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+enum class glossy::expression::op : std::uint8_t {
+	constant, time,
+	add, sub, mul, div, neg,
+	// functions of one argument
+	sin, cos, tan, asin, acos, atan, exp, log, exp2, log2, sqrt, inversesqrt, abs, sign, floor, ceil, fract, radians, degrees,
+	// of two
+	atan2, pow, mod, min, max, step,
+	// of three
+	clamp, mix, smoothstep
+};
+
+// recursive descent with GLSL's precedences, emitting postfix code
+class glossy::expression::parser {
+	struct function {
+		char const* name;
+		unsigned arity;
+		op code;
+	};
+
+	char const* m_pos;
+	expression& m_result;
+	// one per value on the stack: whether GLSL types it int rather than float
+	std::vector< bool > m_integral;
+
+	[[noreturn]] void fail( char const* what ) const {
+		throw std::invalid_argument{ std::string{ what } + " at '" + m_pos + "'" };
+	}
+	void skip_spaces() {
+		while( std::isspace( static_cast< unsigned char >( *m_pos ) ) )
+			++m_pos;
+	}
+	bool accept( char c ) {
+		skip_spaces();
+		if( *m_pos != c )
+			return false;
+		++m_pos;
+		return true;
+	}
+	// GLSL 1.30 keeps ints where all operands are, in arithmetic and in the int overloads of
+	// abs, sign, min, max and clamp; everything else converts them to float
+	static bool keeps_ints( op code ) {
+		switch( code ) {
+		case op::add: case op::sub: case op::mul: case op::neg:
+		case op::abs: case op::sign: case op::min: case op::max: case op::clamp:
+			return true;
+		default:
+			return false;
+		}
+	}
+	void emit( op code, float value = 0.0f, bool integral = false ) {
+		const unsigned count = operands( code );
+		const bool ints = std::all_of( m_integral.end() - count, m_integral.end(), []( bool i ) { return i; } );
+		// the shader would truncate the quotient
+		if( code == op::div && ints )
+			fail( "division of integers" );
+		if( code != op::constant )
+			integral = ints && keeps_ints( code );
+		m_result.m_code.push_back( { code, value } );
+		m_integral.erase( m_integral.end() - count, m_integral.end() );
+		m_integral.push_back( integral );
+		m_result.m_depth = std::max( m_result.m_depth, m_integral.size() );
+	}
+
+	static function const* find( std::string const& name, unsigned arity ) {
+		// atan takes one or two arguments, the others a fixed number
+		static constexpr function functions[] = {
+			{ "sin", 1, op::sin }, { "cos", 1, op::cos }, { "tan", 1, op::tan },
+			{ "asin", 1, op::asin }, { "acos", 1, op::acos }, { "atan", 1, op::atan }, { "atan", 2, op::atan2 },
+			{ "exp", 1, op::exp }, { "log", 1, op::log }, { "exp2", 1, op::exp2 }, { "log2", 1, op::log2 },
+			{ "sqrt", 1, op::sqrt }, { "inversesqrt", 1, op::inversesqrt },
+			{ "abs", 1, op::abs }, { "sign", 1, op::sign }, { "floor", 1, op::floor }, { "ceil", 1, op::ceil }, { "fract", 1, op::fract },
+			{ "radians", 1, op::radians }, { "degrees", 1, op::degrees },
+			{ "pow", 2, op::pow }, { "mod", 2, op::mod }, { "min", 2, op::min }, { "max", 2, op::max }, { "step", 2, op::step },
+			{ "clamp", 3, op::clamp }, { "mix", 3, op::mix }, { "smoothstep", 3, op::smoothstep }
+		};
+		const auto f = std::find_if( std::begin( functions ), std::end( functions ), [ & ]( function const& f ) {
+			return name == f.name && arity == f.arity;
+		} );
+		return f == std::end( functions ) ? nullptr : f;
+	}
+
+	void primary() {
+		skip_spaces();
+		if( std::isdigit( static_cast< unsigned char >( *m_pos ) ) || *m_pos == '.' ) {
+			char* end;
+			const float value = std::strtof( m_pos, &end );
+			if( end == m_pos )
+				fail( "expected a number" );
+			const std::string text{ m_pos, static_cast< char const* >( end ) };
+			const bool hex = text.size() > 1 && text[ 0 ] == '0' && ( text[ 1 ] == 'x' || text[ 1 ] == 'X' );
+			bool integral = hex || text.find_first_of( ".eE" ) == std::string::npos;
+			// GLSL reads these as octal
+			if( integral && !hex && text.size() > 1 && text[ 0 ] == '0' )
+				fail( "octal numbers are not supported" );
+			m_pos = end;
+			if( *m_pos == 'f' || *m_pos == 'F' ) {
+				++m_pos;
+				integral = false;
+			}
+			emit( op::constant, value, integral );
+		} else if( std::isalpha( static_cast< unsigned char >( *m_pos ) ) || *m_pos == '_' ) {
+			char const* const begin = m_pos;
+			while( std::isalnum( static_cast< unsigned char >( *m_pos ) ) || *m_pos == '_' )
+				++m_pos;
+			const std::string name{ begin, m_pos };
+			if( name == "global_time" ) {
+				emit( op::time );
+				return;
+			}
+			if( !accept( '(' ) )
+				fail( ( "unknown variable " + name ).c_str() );
+			unsigned arity = 0;
+			if( !accept( ')' ) ) {
+				do {
+					sum();
+					++arity;
+				} while( accept( ',' ) );
+				if( !accept( ')' ) )
+					fail( "expected ')'" );
+			}
+			function const* const f = find( name, arity );
+			if( !f )
+				fail( ( "unsupported function " + name ).c_str() );
+			emit( f->code );
+		} else if( accept( '(' ) ) {
+			sum();
+			if( !accept( ')' ) )
+				fail( "expected ')'" );
+		} else {
+			fail( "expected an operand" );
+		}
+	}
+	void unary() {
+		if( accept( '-' ) ) {
+			unary();
+			emit( op::neg );
+		} else if( accept( '+' ) ) {
+			unary();
+		} else {
+			primary();
+		}
+	}
+	void product() {
+		unary();
+		for( ;; ) {
+			if( accept( '*' ) ) {
+				unary();
+				emit( op::mul );
+			} else if( accept( '/' ) ) {
+				unary();
+				emit( op::div );
+			} else {
+				return;
+			}
+		}
+	}
+	void sum() {
+		product();
+		for( ;; ) {
+			if( accept( '+' ) ) {
+				product();
+				emit( op::add );
+			} else if( accept( '-' ) ) {
+				product();
+				emit( op::sub );
+			} else {
+				return;
+			}
+		}
+	}
+
+public:
+	parser( std::string const& source, expression& result )
+		: m_pos{ source.c_str() }
+		, m_result{ result } {
+	}
+
+	void run() {
+		sum();
+		skip_spaces();
+		if( *m_pos != '\0' )
+			fail( "unexpected character" );
+	}
+};
+
+unsigned glossy::expression::operands( op code ) {
+	switch( code ) {
+	case op::constant:
+	case op::time:
+		return 0;
+	case op::add: case op::sub: case op::mul: case op::div:
+	case op::atan2: case op::pow: case op::mod: case op::min: case op::max: case op::step:
+		return 2;
+	case op::clamp: case op::mix: case op::smoothstep:
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+glossy::expression::expression()
+	: m_code{ { op::constant, 0.0f } }
+	, m_depth{ 1 } {
+}
+
+glossy::expression::expression( std::string const& source ) {
+	parser{ source, *this }.run();
+}
+
+bool glossy::expression::supported( std::string const& source ) {
+	try {
+		expression{ source };
+		return true;
+	} catch( std::invalid_argument const& ) {
+		return false;
+	}
+}
+
+float glossy::expression::operator()( float global_time ) const {
+	std::vector< float > stack;
+	stack.reserve( m_depth );
+	const auto pop = [ & ] {
+		const float result = stack.back();
+		stack.pop_back();
+		return result;
+	};
+	for( auto const& i : m_code ) {
+		if( i.code == op::constant ) {
+			stack.push_back( i.value );
+			continue;
+		} else if( i.code == op::time ) {
+			stack.push_back( global_time );
+			continue;
+		}
+		// the GLSL definitions, in single precision like on the GPU
+		const unsigned n = operands( i.code );
+		const float c = n >= 3 ? pop() : 0.0f;
+		const float b = n >= 2 ? pop() : 0.0f;
+		float& a = stack.back();
+		switch( i.code ) {
+		case op::add: a = a + b; break;
+		case op::sub: a = a - b; break;
+		case op::mul: a = a * b; break;
+		case op::div: a = a / b; break;
+		case op::neg: a = -a; break;
+		case op::sin: a = std::sin( a ); break;
+		case op::cos: a = std::cos( a ); break;
+		case op::tan: a = std::tan( a ); break;
+		case op::asin: a = std::asin( a ); break;
+		case op::acos: a = std::acos( a ); break;
+		case op::atan: a = std::atan( a ); break;
+		case op::exp: a = std::exp( a ); break;
+		case op::log: a = std::log( a ); break;
+		case op::exp2: a = std::exp2( a ); break;
+		case op::log2: a = std::log2( a ); break;
+		case op::sqrt: a = std::sqrt( a ); break;
+		case op::inversesqrt: a = 1.0f / std::sqrt( a ); break;
+		case op::abs: a = std::abs( a ); break;
+		case op::sign: a = static_cast< float >( ( a > 0.0f ) - ( a < 0.0f ) ); break;
+		case op::floor: a = std::floor( a ); break;
+		case op::ceil: a = std::ceil( a ); break;
+		case op::fract: a = a - std::floor( a ); break;
+		case op::radians: a = a * 0.017453292519943295f; break;
+		case op::degrees: a = a * 57.29577951308232f; break;
+		case op::atan2: a = std::atan2( a, b ); break;
+		case op::pow: a = std::pow( a, b ); break;
+		case op::mod: a = a - b * std::floor( a / b ); break;
+		case op::min: a = std::min( a, b ); break;
+		case op::max: a = std::max( a, b ); break;
+		case op::step: a = b < a ? 0.0f : 1.0f; break;
+		case op::clamp: a = std::min( std::max( a, b ), c ); break;
+		case op::mix: a = a * ( 1.0f - c ) + b * c; break;
+		case op::smoothstep: {
+			const float t = std::min( std::max( ( c - a ) / ( b - a ), 0.0f ), 1.0f );
+			a = t * t * ( 3.0f - 2.0f * t );
+			break;
+		}
+		default:
+			;
+		}
+	}
+	return stack.back();
+}
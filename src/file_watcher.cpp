@@ -0,0 +1,68 @@
+#include <glossy/file_watcher.hpp>
+#include <stdexcept>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <unistd.h>
+	#include <climits>
+#else // __linux__
+	#include <sys/stat.h>
+
+namespace {
+	std::time_t modified( std::string const& filename ) {
+		struct stat info;
+		return stat( filename.c_str(), &info ) == 0 ? info.st_mtime : 0;
+	}
+}
+#endif // __linux__
+
+glossy::file_watcher::file_watcher( std::string const& filename )
+	: m_filename{ filename } {
+#ifdef __linux__
+	const auto separator = filename.find_last_of( '/' );
+	const std::string directory = separator == filename.npos ? "." : filename.substr( 0, separator + 1 );
+	m_name = separator == filename.npos ? filename : filename.substr( separator + 1 );
+	m_fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if( m_fd < 0 )
+		throw std::runtime_error{ "unable to watch " + filename };
+	m_watch = inotify_add_watch( m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO );
+	if( m_watch < 0 ) {
+		close( m_fd );
+		throw std::runtime_error{ "unable to watch " + filename };
+	}
+#else // __linux__
+	m_modified = modified( filename );
+	m_poll.start();
+#endif // __linux__
+}
+
+glossy::file_watcher::~file_watcher() {
+#ifdef __linux__
+	inotify_rm_watch( m_fd, m_watch );
+	close( m_fd );
+#endif // __linux__
+}
+
+bool glossy::file_watcher::changed() {
+	bool result = false;
+#ifdef __linux__
+	// room for at least one event with the longest name
+	alignas( inotify_event ) char buffer[ sizeof( inotify_event ) + NAME_MAX + 1 ];
+	for( ssize_t size; ( size = read( m_fd, buffer, sizeof( buffer ) ) ) > 0; ) {
+		for( char const* p = buffer; p < buffer + size; ) {
+			inotify_event const& event = *reinterpret_cast< inotify_event const* >( p );
+			if( event.len != 0 && m_name == event.name )
+				result = true;
+			p += sizeof( inotify_event ) + event.len;
+		}
+	}
+#else // __linux__
+	if( m_poll.elapsed_s_flt() >= 0.5 ) {
+		m_poll.start();
+		const std::time_t time = modified( m_filename );
+		result = time != m_modified;
+		m_modified = time;
+	}
+#endif // __linux__
+	return result;
+}
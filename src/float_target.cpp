@@ -0,0 +1,74 @@
+#include <glossy/float_target.hpp>
+#include <stdexcept>
+
+glossy::float_target::binding::binding( float_target& target ) {
+	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &m_previous );
+	if( target.m_framebuffer == 0 ) {
+		gl::GenFramebuffers( 1, &target.m_framebuffer );
+		gl::BindFramebuffer( GL_FRAMEBUFFER, target.m_framebuffer );
+		std::vector< GLenum > buffers;
+		for( std::size_t i = 0; i < target.m_textures.size(); ++i ) {
+			buffers.push_back( static_cast< GLenum >( GL_COLOR_ATTACHMENT0 + i ) );
+			gl::FramebufferTexture2D( GL_FRAMEBUFFER, buffers.back(), GL_TEXTURE_2D, target.m_textures[ i ], 0 );
+		}
+		// part of the framebuffer's state
+		gl::DrawBuffers( static_cast< GLsizei >( buffers.size() ), buffers.data() );
+		if( gl::CheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE ) {
+			gl::BindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( m_previous ) );
+			throw std::runtime_error{ "floating point render targets are not supported" };
+		}
+	} else {
+		gl::BindFramebuffer( GL_FRAMEBUFFER, target.m_framebuffer );
+	}
+}
+glossy::float_target::binding::~binding() {
+	gl::BindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( m_previous ) );
+}
+
+glossy::float_target::float_target( unsigned count )
+	: m_textures( count ) {
+	glGenTextures( static_cast< GLsizei >( count ), m_textures.data() );
+	for( auto texture : m_textures ) {
+		glBindTexture( GL_TEXTURE_2D, texture );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	}
+	glBindTexture( GL_TEXTURE_2D, 0 );
+}
+glossy::float_target::~float_target() {
+	if( m_framebuffer != 0 )
+		gl::DeleteFramebuffers( 1, &m_framebuffer );
+	glDeleteTextures( static_cast< GLsizei >( m_textures.size() ), m_textures.data() );
+}
+
+void glossy::float_target::resize( unsigned int width, unsigned int height ) {
+	m_width = width;
+	m_height = height;
+	for( auto texture : m_textures ) {
+		glBindTexture( GL_TEXTURE_2D, texture );
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA32F, static_cast< GLsizei >( width ), static_cast< GLsizei >( height ), 0, GL_RGBA, GL_FLOAT, nullptr );
+	}
+	glBindTexture( GL_TEXTURE_2D, 0 );
+}
+void glossy::float_target::bind( unsigned unit, unsigned index ) const {
+	gl::ActiveTexture( GL_TEXTURE0 + unit );
+	glBindTexture( GL_TEXTURE_2D, m_textures[ index ] );
+	gl::ActiveTexture( GL_TEXTURE0 );
+}
+sf::RenderStates glossy::float_target::overwrite( sf::Shader const* shader ) {
+	return sf::RenderStates{ sf::BlendNone, sf::Transform::Identity, nullptr, shader };
+}
+std::vector< float > glossy::float_target::read( unsigned index ) const {
+	std::vector< float > result( std::size_t{ m_width } * m_height * 4 );
+	glBindTexture( GL_TEXTURE_2D, m_textures[ index ] );
+	glGetTexImage( GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, result.data() );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	return result;
+}
+void glossy::float_target::copy( GLuint pack_buffer, GLenum format, unsigned index ) const {
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, pack_buffer );
+	glBindTexture( GL_TEXTURE_2D, m_textures[ index ] );
+	glGetTexImage( GL_TEXTURE_2D, 0, format, GL_FLOAT, nullptr );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+}
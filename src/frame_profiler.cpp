@@ -0,0 +1,145 @@
+#include <glossy/frame_profiler.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+	using namespace glossy;
+
+	// frames give up on their GPU time after this many newer ones; gpu_timer skips measurements
+	// rather than waiting, and some drivers have no timer queries at all
+	constexpr std::size_t max_latency = 8;
+
+	bool ends_with( std::string const& str, std::string const& suffix ) {
+		return str.size() >= suffix.size() && str.compare( str.size() - suffix.size(), suffix.size(), suffix ) == 0;
+	}
+}
+
+char const* glossy::name( frame_profiler::span s ) {
+	switch( s ) {
+	case frame_profiler::events:
+		return "events";
+	case frame_profiler::update:
+		return "update";
+	case frame_profiler::draw:
+		return "draw";
+	case frame_profiler::display:
+		return "display";
+	default:
+		return "";
+	}
+}
+
+glossy::frame_profiler::frame_profiler( std::string const& filename )
+	: m_log{ std::make_unique< std::ofstream >( filename, std::ofstream::trunc ) }
+	, m_json{ ends_with( filename, ".json" ) || ends_with( filename, ".jsonl" ) } {
+	if( !*m_log )
+		throw std::runtime_error{ "unable to write " + filename };
+	if( !m_json ) {
+		*m_log << "frame,cpu_ms";
+		for( unsigned s = 0; s < span_count; ++s )
+			*m_log << ',' << name( static_cast< span >( s ) ) << "_ms";
+		*m_log << ",gpu_ms\n";
+	}
+}
+
+glossy::frame_profiler::~frame_profiler() {
+	for( auto const& f : m_pending )
+		complete( f );
+}
+
+std::uint64_t glossy::frame_profiler::current() const {
+	return m_next - 1;
+}
+
+void glossy::frame_profiler::begin_frame() {
+	++m_next;
+	m_frame_timer.start();
+	m_span_used.fill( false );
+}
+void glossy::frame_profiler::begin( span s ) {
+	m_span_timers[ s ].start();
+	m_span_used[ s ] = true;
+}
+void glossy::frame_profiler::end( span s ) {
+	m_span_timers[ s ].stop();
+}
+void glossy::frame_profiler::end_frame() {
+	frame f;
+	f.index = current();
+	f.cpu_ms = static_cast< double >( m_frame_timer.elapsed_ms_flt() );
+	for( unsigned s = 0; s < span_count; ++s ) {
+		if( m_span_used[ s ] )
+			f.span_ms[ s ] = static_cast< double >( m_span_timers[ s ].elapsed_ms_flt() );
+	}
+	m_pending.push_back( f );
+	while( m_pending.size() > max_latency ) {
+		complete( m_pending.front() );
+		m_pending.pop_front();
+	}
+}
+
+void glossy::frame_profiler::set_gpu_ms( std::uint64_t index, double ms ) {
+	while( !m_pending.empty() && m_pending.front().index <= index ) {
+		frame& f = m_pending.front();
+		if( f.index == index )
+			f.gpu_ms = ms;
+		complete( f );
+		m_pending.pop_front();
+	}
+}
+
+void glossy::frame_profiler::complete( frame const& f ) {
+	m_history.push_back( f );
+	if( m_history.size() > history )
+		m_history.pop_front();
+	if( !m_log )
+		return;
+
+	std::ostream& log = *m_log;
+	if( m_json ) {
+		log << "{\"frame\":" << f.index << ",\"cpu_ms\":" << f.cpu_ms;
+		for( unsigned s = 0; s < span_count; ++s )
+			log << ",\"" << name( static_cast< span >( s ) ) << "_ms\":" << f.span_ms[ s ];
+		log << ",\"gpu_ms\":";
+		if( f.gpu_ms >= 0.0 )
+			log << f.gpu_ms;
+		else
+			log << "null";
+		log << "}\n";
+	} else {
+		log << f.index << ',' << f.cpu_ms;
+		for( unsigned s = 0; s < span_count; ++s )
+			log << ',' << f.span_ms[ s ];
+		log << ',';
+		if( f.gpu_ms >= 0.0 )
+			log << f.gpu_ms;
+		log << '\n';
+	}
+}
+
+glossy::frame_stats glossy::frame_profiler::cpu_stats() const {
+	std::vector< double > samples;
+	samples.reserve( m_history.size() );
+	for( auto const& f : m_history )
+		samples.push_back( f.cpu_ms );
+	return frame_stats{ std::move( samples ) };
+}
+glossy::frame_stats glossy::frame_profiler::gpu_stats() const {
+	std::vector< double > samples;
+	samples.reserve( m_history.size() );
+	for( auto const& f : m_history )
+		if( f.gpu_ms >= 0.0 )
+			samples.push_back( f.gpu_ms );
+	return frame_stats{ std::move( samples ) };
+}
+glossy::frame_stats glossy::frame_profiler::span_stats( span s ) const {
+	std::vector< double > samples;
+	samples.reserve( m_history.size() );
+	for( auto const& f : m_history )
+		samples.push_back( f.span_ms[ s ] );
+	return frame_stats{ std::move( samples ) };
+}
+std::deque< glossy::frame_profiler::frame > const& glossy::frame_profiler::frames() const {
+	return m_history;
+}
@@ -0,0 +1,72 @@
+#include <glossy/frame_readback.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+glossy::frame_readback::frame_readback( unsigned int width, unsigned int height, sink done, unsigned depth )
+	: m_width{ width }
+	, m_height{ height }
+	, m_sink{ std::move( done ) }
+	, m_slots( depth ) {
+	const std::size_t bytes = std::size_t{ width } * height * 4;
+	for( auto& s : m_slots ) {
+		gl::GenBuffers( 1, &s.buffer );
+		gl::BindBuffer( GL_PIXEL_PACK_BUFFER, s.buffer );
+		gl::BufferData( GL_PIXEL_PACK_BUFFER, static_cast< GLsizeiptr >( bytes ), nullptr, GL_STREAM_READ );
+	}
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+}
+glossy::frame_readback::~frame_readback() {
+	for( auto& s : m_slots ) {
+		if( s.fence )
+			gl::DeleteSync( s.fence );
+		gl::DeleteBuffers( 1, &s.buffer );
+	}
+}
+
+void glossy::frame_readback::collect( slot& s ) {
+	if( s.fence ) {
+		// flushing makes sure that the fence reaches the GPU at all
+		GLenum status;
+		do {
+			status = gl::ClientWaitSync( s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000u );
+		} while( status == GL_TIMEOUT_EXPIRED );
+		gl::DeleteSync( s.fence );
+		s.fence = nullptr;
+	}
+	s.used = false;
+
+	std::vector< sf::Uint8 > pixels( std::size_t{ m_width } * m_height * 4 );
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, s.buffer );
+	void const* data = gl::MapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
+	if( data ) {
+		std::memcpy( pixels.data(), data, pixels.size() );
+		gl::UnmapBuffer( GL_PIXEL_PACK_BUFFER );
+	}
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	if( !data )
+		throw std::runtime_error{ "unable to map a pixel buffer" };
+	m_sink( s.frame, std::move( pixels ) );
+}
+
+void glossy::frame_readback::read( unsigned frame ) {
+	slot& s = m_slots[ m_next ];
+	m_next = ( m_next + 1 ) % m_slots.size();
+	if( s.used )
+		collect( s );
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, s.buffer );
+	glReadPixels( 0, 0, static_cast< GLsizei >( m_width ), static_cast< GLsizei >( m_height ), GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+	gl::BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	if( gl::has_sync() )
+		s.fence = gl::FenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	s.frame = frame;
+	s.used = true;
+}
+void glossy::frame_readback::flush() {
+	// m_next is the oldest
+	for( std::size_t i = 0; i < m_slots.size(); ++i ) {
+		slot& s = m_slots[ ( m_next + i ) % m_slots.size() ];
+		if( s.used )
+			collect( s );
+	}
+}
@@ -0,0 +1,23 @@
+#include <glossy/frame_stats.hpp>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+glossy::frame_stats::frame_stats( std::vector< double > samples )
+	: count{ samples.size() } {
+	if( samples.empty() )
+		return;
+	std::sort( samples.begin(), samples.end() );
+	const auto percentile = [ & ]( double p ) {
+		const auto rank = static_cast< std::size_t >( std::ceil( p * samples.size() ) );
+		return samples[ std::min( std::max( rank, std::size_t{ 1 } ), samples.size() ) - 1 ];
+	};
+	min = samples.front();
+	median = percentile( 0.5 );
+	p99 = percentile( 0.99 );
+	mean = std::accumulate( samples.begin(), samples.end(), 0.0 ) / samples.size();
+}
+
+std::ostream& glossy::operator<<( std::ostream& stream, frame_stats const& stats ) {
+	return stream << "min " << stats.min << " ms, median " << stats.median << " ms, p99 " << stats.p99 << " ms, mean " << stats.mean << " ms (" << stats.count << " frames)";
+}
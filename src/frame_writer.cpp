@@ -0,0 +1,62 @@
+#include <glossy/frame_writer.hpp>
+#include <SFML/Graphics.hpp>
+#include <stdexcept>
+#include <utility>
+
+glossy::frame_writer::frame_writer( std::string pattern, unsigned threads, unsigned max_pending )
+	: m_pattern{ std::move( pattern ) }
+	, m_max_pending{ max_pending }
+	, m_pool{ threads } {
+	if( m_pattern.find( '#' ) == std::string::npos )
+		throw std::invalid_argument{ "the file names of frames need a # for the frame number" };
+	if( m_max_pending == 0 )
+		m_max_pending = 2 * m_pool.size();
+}
+glossy::frame_writer::~frame_writer() {
+	std::unique_lock< std::mutex > lock{ m_mutex };
+	m_done.wait( lock, [ this ]{ return m_pending == 0; } );
+}
+
+std::string glossy::frame_writer::file_name( std::string const& pattern, unsigned frame ) {
+	const std::size_t last = pattern.rfind( '#' );
+	if( last == std::string::npos )
+		return pattern;
+	std::size_t first = last;
+	while( first != 0 && pattern[ first - 1 ] == '#' )
+		--first;
+	const std::size_t width = last + 1 - first;
+	std::string number = std::to_string( frame );
+	if( number.size() < width )
+		number.insert( 0, width - number.size(), '0' );
+	return pattern.substr( 0, first ) + number + pattern.substr( last + 1 );
+}
+
+void glossy::frame_writer::write( unsigned frame, unsigned int width, unsigned int height, std::vector< sf::Uint8 > pixels, bool bottom_up ) {
+	{
+		std::unique_lock< std::mutex > lock{ m_mutex };
+		m_done.wait( lock, [ this ]{ return m_pending < m_max_pending; } );
+		++m_pending;
+	}
+	const std::string name = file_name( m_pattern, frame );
+	m_pool.submit( [ this, name, width, height, pixels = std::move( pixels ), bottom_up ]{
+		sf::Image image;
+		image.create( width, height, pixels.data() );
+		// gl_FragCoord has its origin in the lower left corner, images in the upper left one
+		if( bottom_up )
+			image.flipVertically();
+		const bool saved = image.saveToFile( name );
+
+		// notified under the lock, so that the destructor cannot finish before this does
+		std::lock_guard< std::mutex > lock{ m_mutex };
+		if( !saved && m_error.empty() )
+			m_error = "unable to save " + name;
+		--m_pending;
+		m_done.notify_all();
+	} );
+}
+void glossy::frame_writer::finish() {
+	std::unique_lock< std::mutex > lock{ m_mutex };
+	m_done.wait( lock, [ this ]{ return m_pending == 0; } );
+	if( !m_error.empty() )
+		throw std::runtime_error{ m_error };
+}
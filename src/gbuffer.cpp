@@ -0,0 +1,205 @@
+#include <glossy/gbuffer.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	using namespace glossy;
+
+	// the declarations that both stages share
+	const std::string common_code =
+		"#version 130\n"
+		"uniform sampler2D sphere_data;\n"
+		"uniform sampler2D plane_data;\n"
+		"uniform int sphere_count;\n"
+		"uniform vec2 resolution;\n"
+		"uniform vec3 pos;\n"
+		"uniform vec3 at;\n"
+		"uniform vec3 up;\n"
+		"uniform vec3 right;\n"
+		"uniform float fovh;\n"
+		"uniform float rendering_distance;\n"
+		"vec4 fetch( sampler2D data, int i ) {\n"
+		"	return texelFetch( data, ivec2( i % " + std::to_string( data_texture_width ) + ", i / " + std::to_string( data_texture_width ) + " ), 0 );\n"
+		"}\n";
+
+	// the spheres' quads are bounded by the tangents through the camera like in bin_spheres,
+	// with two pixels of slack for samples away from the pixels' centers
+	char const* const vertex_code =
+		"flat out int object;\n"
+		"void main() {\n"
+		"	object = int( gl_Vertex.x );\n"
+		"	vec2 lo = vec2( -1.0 );\n"
+		"	vec2 hi = vec2( 1.0 );\n"
+		"	if( object < sphere_count ) {\n"
+		"		vec4 s = fetch( sphere_data, 2 * object );\n"
+		"		vec3 d = s.xyz - pos;\n"
+		"		vec3 c = vec3( dot( d, right ), dot( d, up ), dot( d, at ) );\n"
+		"		if( c.z + s.w <= 0.0 || length( d ) - s.w > rendering_distance ) {\n"
+		"			gl_Position = vec4( 2.0, 2.0, 0.0, 1.0 );\n"
+		"			return;\n"
+		"		}\n"
+		"		// around the camera, the sphere may cover anything\n"
+		"		if( c.z - s.w > 1.0e-4 ) {\n"
+		"			vec2 l = sqrt( c.xy * c.xy + c.z * c.z - s.w * s.w );\n"
+		"			float denom = c.z * c.z - s.w * s.w;\n"
+		"			vec2 scale = vec2( resolution.y / resolution.x, 1.0 ) / fovh;\n"
+		"			vec2 slack = 4.0 / resolution;\n"
+		"			lo = ( c.xy * c.z - s.w * l ) / denom * scale - slack;\n"
+		"			hi = ( c.xy * c.z + s.w * l ) / denom * scale + slack;\n"
+		"		}\n"
+		"	}\n"
+		"	gl_Position = vec4( mix( lo, hi, gl_Vertex.yz * 0.5 + 0.5 ), 0.0, 1.0 );\n"
+		"}\n";
+
+	// the intersections are those of the tracer, so that both agree on every hit
+	char const* const fragment_code =
+		"uniform vec2 sample_offset;\n"
+		"flat in int object;\n"
+		"void main() {\n"
+		"	vec2 normalized = ( gl_FragCoord.xy + sample_offset - resolution / 2.0 ) * 2.0 / resolution.y * fovh;\n"
+		"	vec3 d = normalize( at + normalized.x * right + normalized.y * up );\n"
+		"	vec3 p;\n"
+		"	vec3 n;\n"
+		"	vec4 mat;\n"
+		"	float dist;\n"
+		"	if( object < sphere_count ) {\n"
+		"		vec4 s = fetch( sphere_data, 2 * object );\n"
+		"		mat = fetch( sphere_data, 2 * object + 1 );\n"
+		"		p = s.xyz;\n"
+		"		float ang = dot( d, pos - p );\n"
+		"		float radicand = ang * ang - dot( pos - p, pos - p ) + s.w * s.w;\n"
+		"		if( radicand < 0.0 )\n"
+		"			discard;\n"
+		"		radicand = sqrt( radicand );\n"
+		"		float far = -ang + radicand;\n"
+		"		float near = -ang - radicand;\n"
+		"		if( far < 0.0 )\n"
+		"			discard;\n"
+		"		dist = near < 0.0 ? far : near;\n"
+		"		n = normalize( pos + d * dist - p );\n"
+		"	} else {\n"
+		"		int i = object - sphere_count;\n"
+		"		p = fetch( plane_data, 3 * i ).xyz;\n"
+		"		n = fetch( plane_data, 3 * i + 1 ).xyz;\n"
+		"		mat = fetch( plane_data, 3 * i + 2 );\n"
+		"		float denom = dot( d, n );\n"
+		"		if( denom == 0.0 )\n"
+		"			discard;\n"
+		"		dist = dot( p - pos, n ) / denom;\n"
+		"		if( dist <= 0.0 )\n"
+		"			discard;\n"
+		"	}\n"
+		"	if( dist >= rendering_distance )\n"
+		"		discard;\n"
+		"	vec3 i = pos + d * dist;\n"
+		"	vec3 rel = i - p;\n"
+		"	gl_FragDepth = dist / rendering_distance;\n"
+		"	gl_FragData[ 0 ] = vec4( i, rel.x );\n"
+		"	gl_FragData[ 1 ] = vec4( n, rel.z );\n"
+		"	gl_FragData[ 2 ] = mat;\n"
+		"}\n";
+}
+
+glossy::gbuffer::gbuffer( unsigned sphere_data_unit, unsigned plane_data_unit ) {
+	if( !m_shader.loadFromMemory( common_code + vertex_code, common_code + fragment_code ) )
+		throw std::runtime_error{ "unable to process the G-buffer shader" };
+	m_shader.setUniform( "sphere_data", static_cast< int >( sphere_data_unit ) );
+	m_shader.setUniform( "plane_data", static_cast< int >( plane_data_unit ) );
+
+	glGenTextures( target_count, m_textures );
+	for( auto texture : m_textures ) {
+		glBindTexture( GL_TEXTURE_2D, texture );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	}
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	gl::GenRenderbuffers( 1, &m_depth );
+}
+glossy::gbuffer::~gbuffer() {
+	if( m_framebuffer != 0 )
+		gl::DeleteFramebuffers( 1, &m_framebuffer );
+	gl::DeleteRenderbuffers( 1, &m_depth );
+	glDeleteTextures( target_count, m_textures );
+}
+
+void glossy::gbuffer::resize( unsigned int width, unsigned int height ) {
+	m_width = width;
+	m_height = height;
+	for( auto texture : m_textures ) {
+		glBindTexture( GL_TEXTURE_2D, texture );
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA32F, static_cast< GLsizei >( width ), static_cast< GLsizei >( height ), 0, GL_RGBA, GL_FLOAT, nullptr );
+	}
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	gl::BindRenderbuffer( GL_RENDERBUFFER, m_depth );
+	gl::RenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, static_cast< GLsizei >( width ), static_cast< GLsizei >( height ) );
+	gl::BindRenderbuffer( GL_RENDERBUFFER, 0 );
+}
+void glossy::gbuffer::bind( unsigned first ) const {
+	for( unsigned i = 0; i < target_count; ++i ) {
+		gl::ActiveTexture( GL_TEXTURE0 + first + i );
+		glBindTexture( GL_TEXTURE_2D, m_textures[ i ] );
+	}
+	gl::ActiveTexture( GL_TEXTURE0 );
+}
+
+void glossy::gbuffer::draw( sf::RenderTarget& target, view const& v, sf::Glsl::Vec2 sample_offset, int sphere_count, int plane_count ) {
+	m_shader.setUniform( "sphere_count", sphere_count );
+	m_shader.setUniform( "resolution", sf::Glsl::Vec2{ static_cast< float >( v.width ), static_cast< float >( v.height ) } );
+	m_shader.setUniform( "pos", v.position );
+	m_shader.setUniform( "at", v.at );
+	m_shader.setUniform( "up", v.up );
+	m_shader.setUniform( "right", v.right );
+	m_shader.setUniform( "fovh", v.fovh );
+	m_shader.setUniform( "rendering_distance", v.rendering_distance );
+	m_shader.setUniform( "sample_offset", sample_offset );
+
+	const std::size_t vertex_count = 6 * static_cast< std::size_t >( sphere_count + plane_count );
+	if( m_corners.size() != 3 * vertex_count ) {
+		static const float corners[ 12 ] = { -1, -1, 1, -1, 1, 1, -1, -1, 1, 1, -1, 1 };
+		m_corners.resize( 3 * vertex_count );
+		for( std::size_t i = 0; i < vertex_count; ++i ) {
+			m_corners[ 3 * i ] = static_cast< float >( i / 6 );
+			m_corners[ 3 * i + 1 ] = corners[ 2 * ( i % 6 ) ];
+			m_corners[ 3 * i + 2 ] = corners[ 2 * ( i % 6 ) + 1 ];
+		}
+	}
+
+	GLint previous = 0;
+	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &previous );
+	if( m_framebuffer == 0 ) {
+		gl::GenFramebuffers( 1, &m_framebuffer );
+		gl::BindFramebuffer( GL_FRAMEBUFFER, m_framebuffer );
+		for( unsigned i = 0; i < target_count; ++i )
+			gl::FramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_textures[ i ], 0 );
+		gl::FramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth );
+		if( gl::CheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE ) {
+			gl::BindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( previous ) );
+			throw std::runtime_error{ "floating point G-buffers are not supported" };
+		}
+	} else {
+		gl::BindFramebuffer( GL_FRAMEBUFFER, m_framebuffer );
+	}
+	static const GLenum buffers[ target_count ] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+	gl::DrawBuffers( target_count, buffers );
+
+	// SFML draws through client-side arrays, so this does too; the material type of the
+	// background is -1
+	glViewport( 0, 0, static_cast< GLsizei >( m_width ), static_cast< GLsizei >( m_height ) );
+	glClearColor( 0.0f, 0.0f, 0.0f, -1.0f );
+	glClearDepth( 1.0 );
+	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+	glDisable( GL_BLEND );
+	glEnable( GL_DEPTH_TEST );
+	glDepthFunc( GL_LESS );
+	sf::Shader::bind( &m_shader );
+	glDisableClientState( GL_COLOR_ARRAY );
+	glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glVertexPointer( 3, GL_FLOAT, 0, m_corners.data() );
+	glDrawArrays( GL_TRIANGLES, 0, static_cast< GLsizei >( vertex_count ) );
+	sf::Shader::bind( nullptr );
+	glDisable( GL_DEPTH_TEST );
+
+	gl::BindFramebuffer( GL_FRAMEBUFFER, static_cast< GLuint >( previous ) );
+	target.resetGLStates();
+}
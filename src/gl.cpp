@@ -0,0 +1,102 @@
+#include <glossy/gl.hpp>
+#include <SFML/Window.hpp>
+#include <stdexcept>
+#include <string>
+
+PFNGLACTIVETEXTUREPROC glossy::gl::ActiveTexture = nullptr;
+PFNGLGETPROGRAMIVPROC glossy::gl::GetProgramiv = nullptr;
+PFNGLGENFRAMEBUFFERSPROC glossy::gl::GenFramebuffers = nullptr;
+PFNGLDELETEFRAMEBUFFERSPROC glossy::gl::DeleteFramebuffers = nullptr;
+PFNGLBINDFRAMEBUFFERPROC glossy::gl::BindFramebuffer = nullptr;
+PFNGLFRAMEBUFFERTEXTURE2DPROC glossy::gl::FramebufferTexture2D = nullptr;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC glossy::gl::CheckFramebufferStatus = nullptr;
+PFNGLDRAWBUFFERSPROC glossy::gl::DrawBuffers = nullptr;
+PFNGLGENRENDERBUFFERSPROC glossy::gl::GenRenderbuffers = nullptr;
+PFNGLDELETERENDERBUFFERSPROC glossy::gl::DeleteRenderbuffers = nullptr;
+PFNGLBINDRENDERBUFFERPROC glossy::gl::BindRenderbuffer = nullptr;
+PFNGLRENDERBUFFERSTORAGEPROC glossy::gl::RenderbufferStorage = nullptr;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC glossy::gl::FramebufferRenderbuffer = nullptr;
+PFNGLGENQUERIESPROC glossy::gl::GenQueries = nullptr;
+PFNGLDELETEQUERIESPROC glossy::gl::DeleteQueries = nullptr;
+PFNGLBEGINQUERYPROC glossy::gl::BeginQuery = nullptr;
+PFNGLENDQUERYPROC glossy::gl::EndQuery = nullptr;
+PFNGLGETQUERYOBJECTIVPROC glossy::gl::GetQueryObjectiv = nullptr;
+PFNGLGENBUFFERSPROC glossy::gl::GenBuffers = nullptr;
+PFNGLDELETEBUFFERSPROC glossy::gl::DeleteBuffers = nullptr;
+PFNGLBINDBUFFERPROC glossy::gl::BindBuffer = nullptr;
+PFNGLBUFFERDATAPROC glossy::gl::BufferData = nullptr;
+PFNGLMAPBUFFERPROC glossy::gl::MapBuffer = nullptr;
+PFNGLUNMAPBUFFERPROC glossy::gl::UnmapBuffer = nullptr;
+PFNGLGETQUERYOBJECTUI64VPROC glossy::gl::GetQueryObjectui64v = nullptr;
+PFNGLGETPROGRAMBINARYPROC glossy::gl::GetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glossy::gl::ProgramBinary = nullptr;
+PFNGLFENCESYNCPROC glossy::gl::FenceSync = nullptr;
+PFNGLCLIENTWAITSYNCPROC glossy::gl::ClientWaitSync = nullptr;
+PFNGLDELETESYNCPROC glossy::gl::DeleteSync = nullptr;
+
+namespace {
+	template< typename fun_t >
+	bool try_load( fun_t& fun, char const* name ) {
+		fun = reinterpret_cast< fun_t >( sf::Context::getFunction( name ) );
+		return fun != nullptr;
+	}
+	template< typename fun_t >
+	void load( fun_t& fun, char const* name ) {
+		if( !try_load( fun, name ) )
+			throw std::runtime_error{ std::string{ "OpenGL function not available: " } + name };
+	}
+}
+
+void glossy::gl::load() {
+	static bool loaded = false;
+	if( loaded )
+		return;
+	::load( ActiveTexture, "glActiveTexture" );
+	::load( GetProgramiv, "glGetProgramiv" );
+	::load( GenFramebuffers, "glGenFramebuffers" );
+	::load( DeleteFramebuffers, "glDeleteFramebuffers" );
+	::load( BindFramebuffer, "glBindFramebuffer" );
+	::load( FramebufferTexture2D, "glFramebufferTexture2D" );
+	::load( CheckFramebufferStatus, "glCheckFramebufferStatus" );
+	::load( DrawBuffers, "glDrawBuffers" );
+	::load( GenRenderbuffers, "glGenRenderbuffers" );
+	::load( DeleteRenderbuffers, "glDeleteRenderbuffers" );
+	::load( BindRenderbuffer, "glBindRenderbuffer" );
+	::load( RenderbufferStorage, "glRenderbufferStorage" );
+	::load( FramebufferRenderbuffer, "glFramebufferRenderbuffer" );
+	::load( GenQueries, "glGenQueries" );
+	::load( DeleteQueries, "glDeleteQueries" );
+	::load( BeginQuery, "glBeginQuery" );
+	::load( EndQuery, "glEndQuery" );
+	::load( GetQueryObjectiv, "glGetQueryObjectiv" );
+	::load( GenBuffers, "glGenBuffers" );
+	::load( DeleteBuffers, "glDeleteBuffers" );
+	::load( BindBuffer, "glBindBuffer" );
+	::load( BufferData, "glBufferData" );
+	::load( MapBuffer, "glMapBuffer" );
+	::load( UnmapBuffer, "glUnmapBuffer" );
+	::try_load( GetQueryObjectui64v, "glGetQueryObjectui64v" );
+	// drivers may hand out entry points they cannot serve, so the format count has the final say
+	GLint formats = 0;
+	if( ::try_load( GetProgramBinary, "glGetProgramBinary" ) && ::try_load( ProgramBinary, "glProgramBinary" ) )
+		glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+	if( formats == 0 ) {
+		GetProgramBinary = nullptr;
+		ProgramBinary = nullptr;
+	}
+	if( !::try_load( FenceSync, "glFenceSync" ) || !::try_load( ClientWaitSync, "glClientWaitSync" ) || !::try_load( DeleteSync, "glDeleteSync" ) ) {
+		FenceSync = nullptr;
+		ClientWaitSync = nullptr;
+		DeleteSync = nullptr;
+	}
+	loaded = true;
+}
+bool glossy::gl::has_timer_query() {
+	return GetQueryObjectui64v != nullptr;
+}
+bool glossy::gl::has_program_binary() {
+	return GetProgramBinary && ProgramBinary;
+}
+bool glossy::gl::has_sync() {
+	return FenceSync && ClientWaitSync && DeleteSync;
+}
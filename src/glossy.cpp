@@ -1,12 +1,24 @@
 #include <iostream>
 #include <exception>
+#include <glossy/options.hpp>
+#include <glossy/headless.hpp>
 #include <glossy/window.hpp>
 
 int main( int argc, char** argv )
 try {
 	using namespace glossy;
-	window w{ argc, argv };
+	const options opts = parse_options( argc, argv );
+	if( opts.help ) {
+		std::cout << usage;
+		return 0;
+	}
+	if( opts.headless ) {
+		headless h{ opts };
+		return h.run();
+	}
+	window w{ opts };
 	return w.run();
 } catch( std::exception const& e ) {
 	std::cerr << e.what() << '\n';
+	return 1;
 }
@@ -0,0 +1,89 @@
+#include <glossy/governor.hpp>
+#include <glossy/util.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+glossy::governor::governor( double target_ms )
+	: m_target_ms{ target_ms } {
+	m_frame_timer.start();
+}
+
+void glossy::governor::update_view() {
+	const sf::Vector2u render_size = get_render_size();
+	const float width = static_cast< float >( render_size.x ) / m_size.x;
+	const float height = static_cast< float >( render_size.y ) / m_size.y;
+	// SFML's viewports start at the top, gl_FragCoord at the bottom
+	sf::View view{ { 0, 1, 1, -1 } };
+	view.setViewport( { 0, 1 - height, width, height } );
+	m_offscreen.setView( view );
+}
+
+void glossy::governor::set_resolution( unsigned int width, unsigned int height ) {
+	m_size = { width, height };
+	if( !m_offscreen.create( width, height ) )
+		throw std::runtime_error{ "unable to create the offscreen render target" };
+	m_offscreen.setSmooth( true );
+	update_view();
+}
+sf::Vector2u glossy::governor::get_render_size() const {
+	return {
+		std::max( 1u, static_cast< unsigned >( m_size.x * m_scale + 0.5f ) ),
+		std::max( 1u, static_cast< unsigned >( m_size.y * m_scale + 0.5f ) )
+	};
+}
+float glossy::governor::get_scale() const {
+	return m_scale;
+}
+
+void glossy::governor::report( double gpu_ms ) {
+	// only the latest result matters
+	m_reported_ms = gpu_ms;
+}
+
+bool glossy::governor::adjust( double ms ) {
+	// leave some slack so that the scale settles instead of changing every frame
+	if( ms <= 0.0 || ( ms < m_target_ms * 1.05 && ms > m_target_ms * 0.85 ) )
+		return false;
+	// the time is roughly proportional to the number of pixels, i.e. to the square of the scale
+	const float ideal = m_scale * static_cast< float >( std::sqrt( m_target_ms / ms ) );
+	const float scale = clamp( min_scale, 1.0f, m_scale + ( ideal - m_scale ) * 0.5f );
+	if( std::abs( scale - m_scale ) < 0.01f )
+		return false;
+	m_scale = scale;
+	update_view();
+	return true;
+}
+
+bool glossy::governor::draw( sf::RenderTarget& target, std::function< void( sf::RenderTarget& ) > const& render ) {
+	m_offscreen.setActive( true );
+	m_offscreen.clear();
+	render( m_offscreen );
+	m_offscreen.display();
+
+	double ms = 0.0;
+	bool measured = false;
+	if( gpu_timer::is_supported() ) {
+		ms = m_reported_ms;
+		measured = ms > 0.0;
+		m_reported_ms = 0.0;
+	} else {
+		ms = static_cast< double >( m_frame_timer.elapsed_ms_flt() );
+		m_frame_timer.start();
+		measured = true;
+	}
+
+	// the offscreen texture is upright, so the rendered part is at its bottom
+	const sf::Vector2u render_size = get_render_size();
+	sf::Sprite sprite{ m_offscreen.getTexture(), {
+		0, static_cast< int >( m_size.y - render_size.y ),
+		static_cast< int >( render_size.x ), static_cast< int >( render_size.y )
+	} };
+	sprite.setScale( static_cast< float >( m_size.x ) / render_size.x, static_cast< float >( m_size.y ) / render_size.y );
+	const sf::View view = target.getView();
+	target.setView( sf::View{ { 0, 0, static_cast< float >( m_size.x ), static_cast< float >( m_size.y ) } } );
+	target.draw( sprite );
+	target.setView( view );
+
+	return measured && adjust( ms );
+}
@@ -0,0 +1,46 @@
+#include <glossy/gpu_timer.hpp>
+
+glossy::gpu_timer::~gpu_timer() {
+	if( m_queries[ 0 ] != 0 )
+		gl::DeleteQueries( latency, m_queries.data() );
+}
+
+bool glossy::gpu_timer::is_supported() {
+	return gl::has_timer_query();
+}
+
+void glossy::gpu_timer::begin( std::uint64_t tag ) {
+	if( !is_supported() || m_pending == latency )
+		return;
+	if( m_queries[ 0 ] == 0 )
+		gl::GenQueries( latency, m_queries.data() );
+	m_tags[ m_next ] = tag;
+	gl::BeginQuery( GL_TIME_ELAPSED, m_queries[ m_next ] );
+}
+void glossy::gpu_timer::end() {
+	if( !is_supported() || m_pending == latency )
+		return;
+	gl::EndQuery( GL_TIME_ELAPSED );
+	m_next = ( m_next + 1 ) % latency;
+	++m_pending;
+}
+
+bool glossy::gpu_timer::poll( double& ms ) {
+	std::uint64_t tag;
+	return poll( ms, tag );
+}
+bool glossy::gpu_timer::poll( double& ms, std::uint64_t& tag ) {
+	if( m_pending == 0 )
+		return false;
+	const unsigned oldest = ( m_next + latency - m_pending ) % latency;
+	GLint available = GL_FALSE;
+	gl::GetQueryObjectiv( m_queries[ oldest ], GL_QUERY_RESULT_AVAILABLE, &available );
+	if( available == GL_FALSE )
+		return false;
+	GLuint64 ns = 0;
+	gl::GetQueryObjectui64v( m_queries[ oldest ], GL_QUERY_RESULT, &ns );
+	--m_pending;
+	ms = static_cast< double >( ns ) / 1.0e6;
+	tag = m_tags[ oldest ];
+	return true;
+}
@@ -0,0 +1,162 @@
+#include <glossy/headless.hpp>
+#include <glossy/frame_stats.hpp>
+#include <glossy/stopwatch.hpp>
+#include <SFML/OpenGL.hpp>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+
+glossy::headless::headless( options const& opts )
+	: headless{ opts, load_scene( opts ) } {
+}
+glossy::headless::headless( options const& opts, scene const& s )
+	: m_options{ opts }
+	, m_SS{ s.SS } {
+	// there is no desktop to derive a size from
+	if( m_options.width == 0 ) {
+		m_options.width = 1280;
+		m_options.height = 720;
+	}
+	if( m_options.cpu ) {
+		m_pool = std::make_unique< thread_pool >( m_options.threads );
+		m_cpu_tracer = std::make_unique< cpu_tracer >( s, *m_pool );
+		m_cpu_tracer->set_resolution( m_options.width, m_options.height );
+		m_cpu_tracer->set_camera( m_camera );
+	} else {
+		m_tracer = std::make_unique< tracer >( s, get_shader_options( m_options ), m_options.shader_cache );
+		m_target = std::make_unique< sf::RenderTexture >();
+		if( !m_target->create( m_options.width, m_options.height ) )
+			throw std::runtime_error{ "unable to create the offscreen render target" };
+		m_target->setView( sf::View{ { 0, 1, 1, -1 } } );
+		m_tracer->set_resolution( m_options.width, m_options.height );
+		m_tracer->set_camera( m_camera );
+		if( m_options.progressive || m_tracer->adaptive() ) {
+			m_accumulator = std::make_unique< accumulator >();
+			m_accumulator->set_resolution( m_options.width, m_options.height );
+		}
+		if( m_options.temporal ) {
+			m_temporal = std::make_unique< temporal_accumulator >();
+			m_temporal->set_resolution( m_options.width, m_options.height );
+		}
+		if( m_tracer->get_denoise().iterations != 0 ) {
+			m_denoiser = std::make_unique< denoiser >();
+			m_denoiser->set_resolution( m_options.width, m_options.height );
+		}
+		// every frame adds a single sample per pixel
+		if( m_options.progressive || m_options.temporal || m_options.hybrid )
+			m_SS = 1;
+	}
+	if( !m_options.sequence.empty() ) {
+		m_writer = std::make_unique< frame_writer >( m_options.sequence );
+		if( m_target ) {
+			m_target->setActive( true );
+			m_readback = std::make_unique< frame_readback >( m_options.width, m_options.height, [ this ]( unsigned frame, std::vector< sf::Uint8 > pixels ) {
+				m_writer->write( frame, m_options.width, m_options.height, std::move( pixels ), true );
+			} );
+		}
+	}
+}
+
+void glossy::headless::render_frame( unsigned frame ) {
+	// a fixed time step keeps animated scenes reproducible
+	const float time = static_cast< float >( frame ) / static_cast< float >( m_options.fps );
+	if( m_cpu_tracer ) {
+		m_cpu_tracer->set_time( time );
+		m_cpu_tracer->render();
+		if( m_writer )
+			m_writer->write( frame, m_options.width, m_options.height, m_cpu_tracer->get_pixels(), false );
+		return;
+	}
+	m_tracer->set_time( time );
+	if( m_accumulator && m_tracer->animated() )
+		m_accumulator->reset();
+	if( m_temporal && m_tracer->animated() )
+		m_temporal->changed();
+	m_target->clear();
+	if( m_accumulator )
+		m_accumulator->draw( *m_tracer, *m_target );
+	else if( m_temporal )
+		m_temporal->draw( *m_tracer, *m_target );
+	else if( m_denoiser )
+		m_denoiser->draw( *m_tracer, *m_target );
+	else
+		m_tracer->draw( *m_target );
+	m_target->display();
+	if( m_readback ) {
+		// queued behind the frame, so the GPU goes on with the next one. the frames are only
+		// finished by the time they are mapped, a few frames later, so the times below are those
+		// of the whole pipeline.
+		m_target->setActive( true );
+		m_readback->read( frame );
+	} else {
+		// without this we would only measure how fast the driver queues commands
+		glFinish();
+	}
+}
+
+sf::Image glossy::headless::capture() const {
+	if( m_cpu_tracer )
+		return m_cpu_tracer->get_image();
+	sf::Image image = m_target->getTexture().copyToImage();
+	// gl_FragCoord has its origin in the lower left corner, images in the upper left one
+	image.flipVertically();
+	return image;
+}
+
+int glossy::headless::run() {
+	std::vector< double > times;
+	times.reserve( m_options.frames );
+	stopwatch sequence_timer;
+	sequence_timer.start();
+
+	for( unsigned frame = 0; frame < m_options.frames; ++frame ) {
+		stopwatch frame_timer;
+		frame_timer.start();
+		render_frame( frame );
+		frame_timer.stop();
+
+		const double ms = static_cast< double >( frame_timer.elapsed_ms_flt() );
+		std::cout << "frame " << frame << ": " << ms << " ms\n";
+		times.push_back( ms );
+	}
+	if( m_writer ) {
+		if( m_readback ) {
+			m_target->setActive( true );
+			m_readback->flush();
+		}
+		m_writer->finish();
+	}
+	sequence_timer.stop();
+
+	const double first_frame = times.empty() ? 0.0 : times.front();
+	// the first frame pays for lazy driver initialization and is not representative
+	if( times.size() > 1 )
+		times.erase( times.begin() );
+	const frame_stats stats{ times };
+	double spp = m_SS * m_SS;
+	if( m_tracer && m_tracer->adaptive() ) {
+		m_target->setActive( true );
+		spp = m_accumulator->average_spp();
+	}
+	const double rays = static_cast< double >( m_options.width ) * m_options.height * spp;
+	std::cout << m_options.width << 'x' << m_options.height << ", " << spp << " primary rays per pixel";
+	if( m_tracer && m_tracer->adaptive() )
+		std::cout << " on average";
+	if( m_pool )
+		std::cout << ", " << m_pool->size() << " CPU threads";
+	std::cout << '\n' << stats << '\n';
+	std::cout << rays / ( stats.mean * 1.0e3 ) << " Mrays/s\n";
+	if( m_writer ) {
+		const double seconds = static_cast< double >( sequence_timer.elapsed_s_flt() );
+		std::cout << "sustained " << m_options.frames / seconds << " frames per second over " << m_options.frames
+				  << " frames, including saving them to " << m_options.sequence << '\n';
+	}
+	if( m_tracer )
+		std::cout << "time to first frame: " << m_tracer->setup_ms() + first_frame << " ms (shader cache " << ( m_tracer->cache_hit() ? "hit" : "miss" ) << ")\n";
+
+	if( !m_options.out.empty() ) {
+		if( !capture().saveToFile( m_options.out ) )
+			throw std::runtime_error{ "unable to save " + m_options.out };
+	}
+	return 0;
+}
@@ -2,8 +2,12 @@
 #include <glossy/json2glsl.hpp>
 #include <glossy/entities.hpp>
 #include <glossy/util.hpp>
+#include <glossy/bvh.hpp>
+#include <glossy/scene_data.hpp>
+#include <glossy/mesh_file.hpp>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <utility>
@@ -17,218 +21,543 @@ using namespace nlohmann;
 namespace {
 	using namespace glossy;
 
-	using obj_t = std::unique_ptr< object >;
-	using objs_t = std::vector< std::unique_ptr< object > >;
-
 	using lights_t = std::vector< light >;
 
-	template< typename iter_t >
-	bool discard( iter_t const& iter, std::string const& name ) {
-		return iter.key() == name;
-	}
-	template< typename iter_t >
-	bool read( iter_t const& iter, bool& variable, std::string const& name ) {
-		const bool result = iter.key() == name;
-		if( result ) {
-			if( !iter->is_boolean() )
-				throw std::runtime_error{ name + " must be of type bool" };
-			variable = iter->template get< bool >();
-		}
-		return result;
-	}
-	template< typename iter_t >
-	bool read( iter_t const& iter, unsigned& variable, std::string const& name ) {
-		const bool result = iter.key() == name;
-		if( result ) {
-			if( !iter->is_number_unsigned() )
-				throw std::runtime_error{ name + " must be of type unsigned" };
-			variable = iter->template get< unsigned >();
-		}
-		return result;
-	}
-	template< typename iter_t >
-	bool read( iter_t const& iter, float& variable, std::string const& name ) {
-		const bool result = iter.key() == name;
-		if( result ) {
-			if( !iter->is_number_float() )
-				throw std::runtime_error{ name + " must be of type float" };
-			variable = iter->template get< float >();
-		}
-		return result;
-	}
-	template< typename iter_t >
-	bool read( iter_t const& iter, vec3& variable, std::string const& name ) {
-		const bool result = iter.key() == name;
-		if( result ) {
-			if( !iter->is_array() || iter->size() != 3 )
-				throw std::runtime_error{ name + " must be of type vec3" };
-			for( std::size_t i = 0; i < 3; ++i ) {
-				auto& source = ( *iter )[ i ];
-				auto& target = ( i == 0 ? variable.x : ( i == 1 ? variable.y : variable.z ) );
-				if( source.is_number() )
-					target = source.template get< float >();
-				else
-					throw std::runtime_error{ name + "'s components must be numbers" };
+	// scenes with at least this many spheres get a BVH unless they say otherwise
+	constexpr std::size_t bvh_threshold = 32;
+
+	// fills a scene from the events of a SAX parse (see json::sax_parse) rather than from a
+	// document tree, so that reading a scene takes little more memory than the scene itself,
+	// however many objects it has. the nesting of the file is tracked on a stack of frames.
+	class scene_reader {
+		enum class context {
+			document, root, denoise, lights, light, objects, object, material, vec3, strvec3
+		};
+		struct frame {
+			context what;
+			std::string key; // of the next value, in JSON objects
+		};
+
+		// an object whose shape may only be known at its end
+		struct entity {
+			std::string shape;
+			vec3 position{ 0.0, 0.0, 0.0 };
+			material mat;
+			float radius = 1.0;
+			vec3 normal{ 0.0, 1.0, 0.0 };
+			std::string file;
+			float scale = 1.0;
+			bool has_radius = false;
+			bool has_normal = false;
+			bool has_scale = false;
+		};
+
+		scene& m_scene;
+		bool m_bvh_given = false;
+		std::vector< frame > m_stack;
+		light m_light;
+		entity m_entity;
+		// the array that is being read in the vec3 or strvec3 context
+		std::string m_vector_name;
+		vec3* m_vector = nullptr;
+		strvec3* m_strvector = nullptr;
+		unsigned m_component = 0;
+
+		frame& top() {
+			return m_stack.back();
+		}
+		void push( context what ) {
+			m_stack.push_back( { what, {} } );
+		}
+		void pop() {
+			m_stack.pop_back();
+		}
+
+		static char const* requirement( context where, std::string const& key ) {
+			switch( where ) {
+			case context::root:
+				if( key == "SS" || key == "SS_min" || key == "recursion" || key == "light_samples" )
+					return "of type unsigned";
+				if( key == "adaptive_threshold" || key == "fovy" || key == "rendering_distance" )
+					return "of type float";
+				if( key == "background" )
+					return "of type vec3";
+				if( key == "lights" || key == "objects" )
+					return "an array";
+				if( key == "denoise" )
+					return "of type object";
+				return "of type bool";
+			case context::denoise:
+				return key == "iterations" ? "of type unsigned" : "of type float";
+			case context::light:
+				return key == "position" ? "of type strvec3" : "of type vec3";
+			case context::object:
+				if( key == "shape" || key == "file" )
+					return "a string";
+				if( key == "radius" || key == "scale" )
+					return "of type float";
+				if( key == "material" )
+					return "of type object";
+				return "of type vec3";
+			case context::material:
+				return key == "color" ? "of type vec3" : "of type bool";
+			default:
+				return "valid";
 			}
 		}
-		return result;
-	}
-	template< typename iter_t >
-	bool read( iter_t const& iter, strvec3& variable, std::string const& name ) {
-		const bool result = iter.key() == name;
-		if( result ) {
-			if( !iter->is_array() || iter->size() != 3 )
-				throw std::runtime_error{ name + " must be of type strvec3" };
-			for( std::size_t i = 0; i < 3; ++i ) {
-				auto& source = ( *iter )[ i ];
-				auto& target = ( i == 0 ? variable.x : ( i == 1 ? variable.y : variable.z ) );
-				if( source.is_number() )
-					target = std::to_string( source.template get< float >() );
-				else if( source.is_string() )
-					target = source.template get< std::string >();
-				else
-					throw std::runtime_error{ name + "'s components must be primitives" };
+		// throws the error for a value that does not belong where it is
+		[[noreturn]] void mismatch() {
+			switch( top().what ) {
+			case context::document:
+				throw std::runtime_error{ "the scene must be an object" };
+			case context::lights:
+				throw std::runtime_error{ "lights must only contain valid objects" };
+			case context::objects:
+				throw std::runtime_error{ "objects must only contain valid objects" };
+			case context::vec3:
+				throw std::runtime_error{ m_vector_name + "'s components must be numbers" };
+			case context::strvec3:
+				throw std::runtime_error{ m_vector_name + "'s components must be primitives" };
+			default:
+				throw std::runtime_error{ top().key + " must be " + requirement( top().what, top().key ) };
 			}
 		}
-		return result;
-	}
-	template< typename iter_t >
-	bool read( iter_t const& iter, material& variable, std::string const& name ) {
-		const bool result = iter.key() == name;
-		if( result ) {
-			if( !iter->is_object() )
-				throw std::runtime_error{ name + " must be of type object" };
-			for( auto i = iter->cbegin(); i != iter->cend(); ++i ) {
-				read( i, variable.color, "color" ) ||
-				read( i, variable.checkered, "checkered" ) ||
-				read( i, variable.diffuse, "diffuse" ) ||
-				read( i, variable.specular, "specular" ) ||
-				( throw std::runtime_error{ "unrecognized material property: " + i.key() }, false );
+
+		void begin_vector( vec3& target ) {
+			m_vector_name = top().key;
+			m_vector = &target;
+			m_component = 0;
+			push( context::vec3 );
+		}
+		void begin_vector( strvec3& target ) {
+			m_vector_name = top().key;
+			m_strvector = &target;
+			m_component = 0;
+			push( context::strvec3 );
+		}
+		// the next component of vec
+		template< typename vector_t >
+		auto component( vector_t& vec ) -> decltype( vec.x )& {
+			if( m_component >= 3 )
+				throw std::runtime_error{ m_vector_name + ( top().what == context::vec3 ? " must be of type vec3" : " must be of type strvec3" ) };
+			auto& result = m_component == 0 ? vec.x : ( m_component == 1 ? vec.y : vec.z );
+			++m_component;
+			return result;
+		}
+		// stores value if it is a component of a vector
+		bool number( float value ) {
+			if( top().what == context::vec3 )
+				component( *m_vector ) = value;
+			else if( top().what == context::strvec3 )
+				component( *m_strvector ) = std::to_string( value );
+			else
+				return false;
+			return true;
+		}
+
+		void end_entity() {
+			if( m_entity.shape.empty() )
+				throw std::runtime_error{ "objects must define the shape property" };
+			const bool is_sphere = m_entity.shape == "sphere";
+			const bool is_plane = m_entity.shape == "plane";
+			const bool is_mesh = m_entity.shape == "mesh";
+			if( m_entity.has_radius && !is_sphere )
+				throw std::runtime_error{ "unrecognized object property: radius" };
+			if( m_entity.has_normal && !is_plane )
+				throw std::runtime_error{ "unrecognized object property: normal" };
+			if( ( m_entity.has_scale || !m_entity.file.empty() ) && !is_mesh )
+				throw std::runtime_error{ std::string{ "unrecognized object property: " } + ( m_entity.has_scale ? "scale" : "file" ) };
+			if( is_sphere ) {
+				sphere result;
+				result.position = m_entity.position;
+				result.mat = m_entity.mat;
+				result.radius = m_entity.radius;
+				m_scene.spheres.push_back( result );
+			} else if( is_plane ) {
+				plane result;
+				result.position = m_entity.position;
+				result.mat = m_entity.mat;
+				result.normal = m_entity.normal;
+				m_scene.planes.push_back( result );
+			} else {
+				if( m_entity.file.empty() )
+					throw std::runtime_error{ "meshes must define the file property" };
+				mesh result;
+				result.position = m_entity.position;
+				result.mat = m_entity.mat;
+				result.file = m_entity.file;
+				result.scale = m_entity.scale;
+				m_scene.meshes.push_back( std::move( result ) );
 			}
 		}
-		return result;
-	}
-	bool read( json const& j, obj_t& variable ) {
-		if( !j.is_object() )
-			return false;
-		const auto shape_iter = j.find( "shape" );
-		if( shape_iter == j.end() )
-			throw std::runtime_error{ "objects must define the shape property" };
-		if( !shape_iter->is_string() )
-			throw std::runtime_error{ "shape must be a string" };
-		const auto&& shape = shape_iter->get< std::string >();
-		bool is_sphere = false;
-		bool is_plane = false;
-		if( ( is_sphere = ( shape == "sphere" ) ) ) // -Wparentheses
-			variable = std::make_unique< sphere >();
-		else if( ( is_plane = ( shape == "plane" ) ) ) // -Wparentheses
-			variable = std::make_unique< plane >();
-		else
-			throw std::runtime_error{ "unrecognized shape: " + shape };
-		for( auto i = j.cbegin(); i != j.cend(); ++i ) {
-			discard( i, "shape" ) ||
-			read( i, variable->position, "position" ) ||
-			( is_sphere && read( i, static_cast< sphere* >( &*variable )->radius, "radius" ) ) ||
-			( is_plane && read( i, static_cast< plane* >( &*variable )->normal, "normal" ) ) ||
-			read( i, variable->mat, "material" ) ||
-			( throw std::runtime_error{ "unrecognized object property: " + i.key() }, false );
+
+	public:
+		explicit scene_reader( scene& s )
+			: m_scene( s ) {
+			// deeper than any valid scene
+			m_stack.reserve( 8 );
+			push( context::document );
 		}
 
-		return true;
-	}
-	bool read( json const& j, light& variable ) {
-		if( !j.is_object() )
-			return false;
-		for( auto i = j.cbegin(); i != j.cend(); ++i ) {
-			read( i, variable.position, "position" ) ||
-			read( i, variable.color, "color" ) ||
-			( throw std::runtime_error{ "unrecognized light property: " + i.key() }, false );
+		// whether the file decides about the BVH itself
+		bool bvh_given() const {
+			return m_bvh_given;
 		}
 
-		return true;
-	}
-	template< typename iter_t, typename T >
-	bool read( iter_t const& iter, std::vector< T >& container, std::string const& name ) {
-		const bool result = iter.key() == name;
-		if( result ) {
-			if( !iter->is_array() )
-				throw std::runtime_error{ name + " must be an array" };
-			for( auto const& i : *iter ) {
-				T entity;
-				if( !read( i, entity ) )
-					throw std::runtime_error{ name + " must only contain valid objects" };
-				container.emplace_back( std::move( entity ) );
+		bool null() {
+			mismatch();
+		}
+		bool boolean( bool value ) {
+			frame const& f = top();
+			if( f.what == context::root && f.key == "bvh" ) {
+				m_scene.bvh = value;
+				m_bvh_given = true;
+			} else if( f.what == context::root && f.key == "data_driven" ) {
+				m_scene.data_driven = value;
+			} else if( f.what == context::material && f.key == "checkered" ) {
+				m_entity.mat.checkered = value;
+			} else if( f.what == context::material && f.key == "diffuse" ) {
+				m_entity.mat.diffuse = value;
+			} else if( f.what == context::material && f.key == "specular" ) {
+				m_entity.mat.specular = value;
+			} else {
+				mismatch();
 			}
+			return true;
+		}
+		bool number_integer( json::number_integer_t value ) {
+			if( !number( static_cast< float >( value ) ) )
+				mismatch();
+			return true;
+		}
+		bool number_unsigned( json::number_unsigned_t value ) {
+			frame const& f = top();
+			if( f.what == context::root && f.key == "SS" )
+				m_scene.SS = static_cast< unsigned >( value );
+			else if( f.what == context::root && f.key == "SS_min" )
+				m_scene.SS_min = static_cast< unsigned >( value );
+			else if( f.what == context::root && f.key == "recursion" )
+				m_scene.recursion = static_cast< unsigned >( value );
+			else if( f.what == context::root && f.key == "light_samples" )
+				m_scene.light_samples = static_cast< unsigned >( value );
+			else if( f.what == context::denoise && f.key == "iterations" )
+				m_scene.denoise.iterations = static_cast< unsigned >( value );
+			else if( !number( static_cast< float >( value ) ) )
+				mismatch();
+			return true;
+		}
+		bool number_float( json::number_float_t value, std::string const& ) {
+			frame const& f = top();
+			const float v = static_cast< float >( value );
+			if( f.what == context::root && f.key == "adaptive_threshold" ) {
+				m_scene.adaptive_threshold = v;
+			} else if( f.what == context::root && f.key == "fovy" ) {
+				m_scene.fovy = v;
+			} else if( f.what == context::root && f.key == "rendering_distance" ) {
+				m_scene.rendering_distance = v;
+			} else if( f.what == context::denoise && f.key == "sigma_color" ) {
+				m_scene.denoise.sigma_color = v;
+			} else if( f.what == context::denoise && f.key == "sigma_normal" ) {
+				m_scene.denoise.sigma_normal = v;
+			} else if( f.what == context::denoise && f.key == "sigma_depth" ) {
+				m_scene.denoise.sigma_depth = v;
+			} else if( f.what == context::denoise && f.key == "sigma_albedo" ) {
+				m_scene.denoise.sigma_albedo = v;
+			} else if( f.what == context::object && f.key == "radius" ) {
+				m_entity.radius = v;
+				m_entity.has_radius = true;
+			} else if( f.what == context::object && f.key == "scale" ) {
+				m_entity.scale = v;
+				m_entity.has_scale = true;
+			} else if( !number( v ) ) {
+				mismatch();
+			}
+			return true;
+		}
+		bool string( std::string& value ) {
+			frame const& f = top();
+			if( f.what == context::strvec3 ) {
+				component( *m_strvector ) = value;
+			} else if( f.what == context::object && f.key == "shape" ) {
+				if( value != "sphere" && value != "plane" && value != "mesh" )
+					throw std::runtime_error{ "unrecognized shape: " + value };
+				m_entity.shape = value;
+			} else if( f.what == context::object && f.key == "file" ) {
+				m_entity.file = value;
+			} else {
+				mismatch();
+			}
+			return true;
+		}
+		template< typename binary_t >
+		bool binary( binary_t& ) {
+			mismatch();
+		}
+
+		bool start_object( std::size_t ) {
+			frame const& f = top();
+			if( f.what == context::document ) {
+				push( context::root );
+			} else if( f.what == context::root && f.key == "denoise" ) {
+				push( context::denoise );
+			} else if( f.what == context::lights ) {
+				m_light = light{};
+				push( context::light );
+			} else if( f.what == context::objects ) {
+				m_entity = entity{};
+				push( context::object );
+			} else if( f.what == context::object && f.key == "material" ) {
+				push( context::material );
+			} else {
+				mismatch();
+			}
+			return true;
+		}
+		bool key( std::string& name ) {
+			frame& f = top();
+			const bool known = [ & ] {
+				switch( f.what ) {
+				case context::root:
+					return
+						name == "SS" || name == "SS_min" || name == "adaptive_threshold" || name == "fovy" ||
+						name == "background" || name == "recursion" || name == "rendering_distance" ||
+						name == "lights" || name == "objects" || name == "bvh" || name == "data_driven" ||
+						name == "light_samples" || name == "denoise";
+				case context::denoise:
+					return
+						name == "iterations" || name == "sigma_color" || name == "sigma_normal" ||
+						name == "sigma_depth" || name == "sigma_albedo";
+				case context::light:
+					return name == "position" || name == "color";
+				case context::object:
+					return
+						name == "shape" || name == "position" || name == "radius" || name == "normal" ||
+						name == "file" || name == "scale" || name == "material";
+				default: // material
+					return name == "color" || name == "checkered" || name == "diffuse" || name == "specular";
+				}
+			}();
+			if( !known ) {
+				switch( f.what ) {
+				case context::root:
+					throw std::runtime_error{ "unrecognized option: " + name };
+				case context::denoise:
+					throw std::runtime_error{ "unrecognized denoise property: " + name };
+				case context::light:
+					throw std::runtime_error{ "unrecognized light property: " + name };
+				case context::object:
+					throw std::runtime_error{ "unrecognized object property: " + name };
+				default:
+					throw std::runtime_error{ "unrecognized material property: " + name };
+				}
+			}
+			f.key = name;
+			return true;
+		}
+		bool end_object() {
+			if( top().what == context::light )
+				m_scene.lights.push_back( m_light );
+			else if( top().what == context::object )
+				end_entity();
+			pop();
+			return true;
 		}
-		return result;
+
+		bool start_array( std::size_t ) {
+			frame const& f = top();
+			if( f.what == context::root && f.key == "lights" )
+				push( context::lights );
+			else if( f.what == context::root && f.key == "objects" )
+				push( context::objects );
+			else if( f.what == context::root && f.key == "background" )
+				begin_vector( m_scene.background );
+			else if( f.what == context::light && f.key == "position" )
+				begin_vector( m_light.position );
+			else if( f.what == context::light && f.key == "color" )
+				begin_vector( m_light.color );
+			else if( f.what == context::object && f.key == "position" )
+				begin_vector( m_entity.position );
+			else if( f.what == context::object && f.key == "normal" ) {
+				m_entity.has_normal = true;
+				begin_vector( m_entity.normal );
+			} else if( f.what == context::material && f.key == "color" )
+				begin_vector( m_entity.mat.color );
+			else
+				mismatch();
+			return true;
+		}
+		bool end_array() {
+			if( ( top().what == context::vec3 || top().what == context::strvec3 ) && m_component != 3 )
+				throw std::runtime_error{ m_vector_name + ( top().what == context::vec3 ? " must be of type vec3" : " must be of type strvec3" ) };
+			pop();
+			return true;
+		}
+
+		template< typename exception_t >
+		bool parse_error( std::size_t, std::string const&, exception_t const& error ) {
+			throw std::runtime_error{ error.what() };
+		}
+	};
+}
+
+namespace {
+	// mesh files are relative to directory
+	scene read_scene( std::istream& stream, std::string const& directory ) {
+		scene s;
+		scene_reader reader{ s };
+		json::sax_parse( stream, &reader );
+		if( !reader.bvh_given() )
+			s.bvh = s.spheres.size() >= bvh_threshold;
+
+		s.validate();
+		load_meshes( s, directory );
+		return s;
 	}
 }
 
-std::string glossy::json2glsl( std::string const& filename ) {
-	return json2glsl( filename.c_str() );
+glossy::scene glossy::json2scene( std::string const& filename ) {
+	return json2scene( filename.c_str() );
 }
-std::string glossy::json2glsl( char const* filename ) {
+glossy::scene glossy::json2scene( char const* filename ) {
 	std::ifstream file{ filename };
 	if( !file )
 		throw std::runtime_error{ "unable to load file" };
-	return json2glsl( file );
+	return read_scene( file, directory_of( filename ) );
 }
-std::string glossy::json2glsl( std::istream& stream ) {
-	json j;
-	stream >> j;
-
-	unsigned SS = 1;
-	float fovy = 60.0;
-	vec3 background{ 0.0, 0.0, 0.0 };
-	unsigned recursion = 0;
-	float rendering_distance = 50.0;
+glossy::scene glossy::json2scene( std::istream& stream ) {
+	return read_scene( stream, {} );
+}
+
+std::string glossy::scene2glsl( scene const& s, shader_options const& opts ) {
+	if( opts.hybrid && !s.data_driven )
+		throw std::invalid_argument{ "the hybrid mode needs a data driven scene" };
+	// the G-buffer has one sample per pixel
+	const unsigned SS = opts.hybrid ? 1 : s.SS;
+	const bool adaptive = s.adaptive() && !opts.progressive && !opts.hybrid && !opts.temporal;
+	// the denoiser filters single frames; accumulated ones converge on their own
+	const bool guides = s.denoise.iterations != 0 && !opts.progressive && !opts.temporal && !adaptive;
+	const float fovy = s.fovy;
+	const vec3 background = s.background;
+	const float rendering_distance = s.rendering_distance;
+	data_layout data = layout( s );
+	// the primary rays of the hybrid mode are not traced
+	data.tiles = data.tiles && !opts.hybrid;
+
+	// whatever is not fetched from the data textures (see scene_data) is baked into constants,
+	// obj0 and on, spheres first
+	const std::size_t baked_spheres = data.spheres ? 0 : s.spheres.size();
+	const std::size_t baked_objects = baked_spheres + ( data.planes ? 0 : s.planes.size() );
 	lights_t lights;
-	objs_t objects;
-
-	for( auto i = j.cbegin(); i != j.cend(); ++i ) {
-		read( i, SS, "SS" ) ||
-		read( i, fovy, "fovy" ) ||
-		read( i, background, "background" ) ||
-		read( i, recursion, "recursion" ) ||
-		read( i, rendering_distance, "rendering_distance" ) ||
-		read( i, lights, "lights" ) ||
-		read( i, objects, "objects" ) ||
-		( throw std::runtime_error{ "unrecognized option: " + i.key() }, false );
+	if( data.lit ) {
+		for( auto const& l : s.lights )
+			if( !data.lights || !l.is_static() )
+				lights.push_back( l );
 	}
-
-	if( SS == 0 )
-		throw std::range_error{ "SS must be positive" };
-	if( fovy <= 0.0 || fovy >= 180.0 )
-		throw std::range_error{ "fovy must be in (0, 180)" };
-	if( background.x < 0.0 || background.x > 1.0 )
-		throw std::range_error{ "background.r must be in [0, 1]" };
-	if( background.y < 0.0 || background.y > 1.0 )
-		throw std::range_error{ "background.g must be in [0, 1]" };
-	if( background.z < 0.0 || background.z > 1.0 )
-		throw std::range_error{ "background.b must be in [0, 1]" };
-	if( rendering_distance <= 0.0 )
-		throw std::range_error{ "rendering_distance must be positive" };
+	// whether shadow rays are cast at all; diffuse materials without lights reflect the background
+	const bool shadows = !lights.empty() || data.lights;
+	// the positions of these are computed by the tracer every frame, see light::is_evaluable
+	const auto evaluated_lights = static_cast< std::size_t >( std::count_if( lights.begin(), lights.end(), []( light const& l ) { return l.is_evaluable(); } ) );
 
 	const auto gen_eval_funs = [ & ]( std::ostream& stream, char const* type ) -> decltype( auto ) {
+		if( shadows )
+			stream <<
+				"bool eval_occ( ray r, float dist, const " << type << " obj ) {\n"
+				"	float d = intersect( r, obj );\n"
+				"	return d != no_hit && d < dist;\n"
+				"}\n";
 		stream <<
-			"bool eval_occ( ray r, float dist, const " << type << " obj ) {\n"
+			"void eval( ray r, inout hit h, const " << type << " obj ) {\n"
 			"	float d = intersect( r, obj );\n"
-			"	return d != no_hit && d < dist;\n"
+			"	if( d != no_hit && d < h.dist && d < " << rendering_distance << " )\n"
+			"		h = make_hit( r, d, obj );\n"
 			"}\n";
-		for( unsigned i = 0; i <= recursion; ++i ) {
-		stream <<
-			"void eval" << i << "( ray r, inout vec3 color, inout float dist, const " << type << " obj ) {\n"
-			"	float d = intersect( r, obj );\n"
-			"	if( d != no_hit && d < dist && d < " << rendering_distance << " ) {\n"
-			"		vec3 i = propagate( r, d );\n"
-			"		color = materialize" << i << "( r, obj.mat, i, i - obj.p, normal( i, obj ) );\n"
-			"		dist = d;\n"
-			"	}\n"
-			"}\n";
-		}
 		return stream;
 	};
 
+	// the searches over objects in the data textures: closest_<type> returns the index of the closest
+	// hit closer than dist (or -1) and updates dist, occluded_<type>s tells whether there is any
+	const auto gen_search_head = [ & ]( std::ostream& stream, std::string const& type, bool any ) {
+		if( any )
+			stream << "bool occluded_" << type << "s( ray r, float dist ) {\n";
+		else
+			stream << "int closest_" << type << "( ray r, inout float dist ) {\n"
+					  "	int result = -1;\n";
+	};
+	const auto gen_search_hit = [ & ]( std::ostream& stream, bool any, std::string const& indent ) {
+		if( any )
+			stream << indent << "if( d < dist )\n"
+				   << indent << "	return true;\n";
+		else
+			stream << indent << "if( d < dist ) {\n"
+				   << indent << "	dist = d;\n"
+				   << indent << "	result = i;\n"
+				   << indent << "}\n";
+	};
+	const auto gen_search_tail = [ & ]( std::ostream& stream, bool any ) {
+		stream << ( any ? "	return false;\n" : "	return result;\n" )
+			   << "}\n";
+	};
+	const auto gen_linear_search = [ & ]( std::ostream& stream, std::string const& type, bool any ) {
+		gen_search_head( stream, type, any );
+		stream << "	for( int i = 0; i < " << type << "_count; ++i ) {\n"
+				  "		float d = intersect( r, get_" << type << "( i ) );\n";
+		gen_search_hit( stream, any, "\t\t" );
+		stream << "	}\n";
+		gen_search_tail( stream, any );
+	};
+	// a depth-first traversal with a short stack; bvh::max_depth bounds its size. leaf computes
+	// the distance d to primitive i.
+	const auto gen_bvh_search = [ & ]( std::ostream& stream, std::string const& type, char const* nodes, std::vector< std::string > const& leaf, bool any ) {
+		gen_search_head( stream, type, any );
+		stream << "	if( " << type << "_count == 0 )\n"
+				  "		return " << ( any ? "false" : "-1" ) << ";\n"
+				  "	vec3 inv_d = 1.0 / r.d;\n"
+				  "	int stack[ " << bvh::max_depth << " ];\n"
+				  "	int sp = 0;\n"
+				  "	int node = 0;\n"
+				  "	while( true ) {\n"
+				  "		vec4 lo = fetch( " << nodes << ", 2 * node );\n"
+				  "		vec4 hi = fetch( " << nodes << ", 2 * node + 1 );\n"
+				  "		if( hit_box( r, inv_d, lo.xyz, hi.xyz, dist ) ) {\n"
+				  "			int first = int( lo.w );\n"
+				  "			int count = int( hi.w );\n"
+				  "			if( count == 0 ) {\n"
+				  "				stack[ sp++ ] = first + 1;\n"
+				  "				node = first;\n"
+				  "				continue;\n"
+				  "			}\n"
+				  "			for( int i = first; i < first + count; ++i ) {\n";
+		for( auto const& line : leaf )
+			stream << "\t\t\t\t" << line << '\n';
+		gen_search_hit( stream, any, "\t\t\t\t" );
+		stream << "			}\n"
+				  "		}\n"
+				  "		if( sp == 0 )\n"
+				  "			break;\n"
+				  "		node = stack[ --sp ];\n"
+				  "	}\n";
+		gen_search_tail( stream, any );
+	};
+	const auto gen_hit_box = [ & ]( std::ostream& stream ) {
+		stream << "bool hit_box( ray r, vec3 inv_d, vec3 lo, vec3 hi, float dist ) {\n"
+				  "	vec3 t0 = ( lo - r.o ) * inv_d;\n"
+				  "	vec3 t1 = ( hi - r.o ) * inv_d;\n"
+				  "	vec3 near = min( t0, t1 );\n"
+				  "	vec3 far = max( t0, t1 );\n"
+				  "	float enter = max( max( near.x, near.y ), max( near.z, 0.0 ) );\n"
+				  "	float leave = min( min( far.x, far.y ), far.z );\n"
+				  "	return enter <= leave && enter < dist;\n"
+				  "}\n";
+	};
+	const auto gen_data_eval_funs = [ & ]( std::ostream& stream, std::string const& type ) {
+		stream << "void eval_" << type << "s( ray r, inout hit h ) {\n"
+				  "	float d = min( h.dist, " << rendering_distance << " );\n"
+				  "	int id = closest_" << type << "( r, d );\n"
+				  "	if( id >= 0 )\n"
+				  "		h = make_hit( r, d, get_" << type << "( id ) );\n"
+				  "}\n";
+	};
+
 	std::ostringstream code;
 	code << "#version 130\n\n";
 
@@ -238,16 +567,68 @@ std::string glossy::json2glsl( std::istream& stream ) {
 	code << "uniform vec3 pos;\n";
 	code << "uniform vec3 at;\n";
 	code << "uniform vec3 up;\n";
-	code << "uniform vec3 right;\n\n";
+	code << "uniform vec3 right;\n";
+	if( data.reflective )
+		code << "uniform int recursion;\n";
+	if( opts.progressive || opts.temporal )
+		code << "uniform vec2 jitter;\n";
+	if( opts.progressive )
+		code << "uniform float samples;\n"
+				"uniform sampler2D history;\n";
+	if( opts.hybrid )
+		code << "uniform sampler2D gbuffer_position;\n"
+				"uniform sampler2D gbuffer_normal;\n"
+				"uniform sampler2D gbuffer_material;\n";
+	if( data.spheres )
+		code << "uniform sampler2D sphere_data;\n"
+				"uniform int sphere_count;\n";
+	if( data.tiles )
+		code << "uniform sampler2D tile_data;\n"
+				"uniform sampler2D tile_spheres;\n"
+				"uniform int tile_columns;\n";
+	if( data.bvh )
+		code << "uniform sampler2D bvh_nodes;\n";
+	if( data.planes )
+		code << "uniform sampler2D plane_data;\n"
+				"uniform int plane_count;\n";
+	if( data.lights )
+		code << "uniform sampler2D light_data;\n"
+				"uniform int light_count;\n";
+	if( data.light_alias )
+		code << "uniform sampler2D light_alias;\n";
+	if( data.meshes )
+		code << "uniform sampler2D mesh_vertices;\n"
+				"uniform sampler2D mesh_triangles;\n"
+				"uniform sampler2D mesh_bvh;\n"
+				"uniform sampler2D mesh_data;\n"
+				"uniform int triangle_count;\n";
+	if( evaluated_lights != 0 )
+		code << "uniform vec3 light_positions[ " << evaluated_lights << " ];\n";
+	if( data.view )
+		code << "uniform float fovh;\n"
+				"uniform vec3 background;\n";
+	code << '\n';
 
 	// constants
 	code << "const int SS = " << SS << ";\n";
-	code << "const float fovy = " << deg2rad( fovy ) << ";\n";
-	code << "const float fovh = " << std::tan( deg2rad( fovy ) / 2.0 ) << ";\n";
+	if( adaptive ) {
+		// a variance needs at least two samples
+		code << "const int spp_min = " << std::max( s.SS_min * s.SS_min, 2u ) << ";\n";
+		code << "const int spp_max = " << SS * SS << ";\n";
+		code << "const float adaptive_threshold = " << s.adaptive_threshold << ";\n";
+	}
+	if( !data.view ) {
+		code << "const float fovy = " << deg2rad( fovy ) << ";\n";
+		code << "const float fovh = " << std::tan( deg2rad( fovy ) / 2.0 ) << ";\n";
+	}
 	code << "const float no_hit = 1.0 / 0.0;\n";
+	if( data.light_alias )
+		code << "const int light_samples = " << s.light_samples << ";\n";
 
 	// background color
-	code << "const vec3 background = vec3" << background << ";\n\n";
+	if( !data.view )
+		code << "const vec3 background = vec3" << background << ";\n";
+	code << '\n';
 
 	// util funs
 	code << "float sq( float x ) {\n"
@@ -260,7 +641,22 @@ std::string glossy::json2glsl( std::istream& stream ) {
 			"	float temp = x;\n"
 			"	x = y;\n"
 			"	y = temp;\n"
-			"}\n\n";
+			"}\n";
+	if( data.light_alias ) {
+		// a PCG step and output permutation; calc seeds it for every sample
+		code << "uint rng_state;\n"
+				"float rand() {\n"
+				"	rng_state = rng_state * 747796405u + 2891336453u;\n"
+				"	uint word = ( ( rng_state >> ( ( rng_state >> 28u ) + 4u ) ) ^ rng_state ) * 277803737u;\n"
+				"	return float( ( ( word >> 22u ) ^ word ) >> 8u ) / 16777216.0;\n"
+				"}\n";
+	}
+	if( data.spheres || data.planes || data.lights || data.meshes ) {
+		code << "vec4 fetch( sampler2D data, int i ) {\n"
+				"	return texelFetch( data, ivec2( i % " << data_texture_width << ", i / " << data_texture_width << " ), 0 );\n"
+				"}\n";
+	}
+	code << '\n';
 
 	// ray class
 	code << "struct ray {\n"
@@ -271,42 +667,61 @@ std::string glossy::json2glsl( std::istream& stream ) {
 			"	return r.o + r.d * dist;\n"
 			"}\n\n";
 
-	// light class
-	code << "struct light {\n"
-			"	vec3 p;\n"
-			"	vec3 col;\n"
-			"};\n";
+	if( shadows ) {
+		// light class
+		code << "struct light {\n"
+				"	vec3 p;\n"
+				"	vec3 col;\n"
+				"};\n";
 
-	// light description
-	if( !lights.empty() ) {
-		code << "light lights[ " << lights.size() << " ] = light[ " << lights.size() << " ](";
-		for( std::size_t i = 0;; ) {
-			code << "\n\t";
-			lights[ i ].print( code );
-			if( ++i >= lights.size() )
-				break;
-			code << ",";
-		}
-		code << "\n);\n\n";
-	}
+		// light description
+		if( !lights.empty() ) {
+			code << "light lights[ " << lights.size() << " ] = light[ " << lights.size() << " ](";
+			for( std::size_t i = 0, evaluated = 0;; ) {
+				code << "\n\t";
+				if( lights[ i ].is_evaluable() )
+					code << "light( light_positions[ " << evaluated++ << " ], vec3" << lights[ i ].color << " )";
+				else
+					lights[ i ].print( code );
+				if( ++i >= lights.size() )
+					break;
+				code << ",";
+			}
+			code << "\n);\n\n";
+		}
+		if( data.lights ) {
+			code << "light get_light( int i ) {\n"
+					"	return light( fetch( light_data, 2 * i ).xyz, fetch( light_data, 2 * i + 1 ).rgb );\n"
+					"}\n\n";
+		}
+		if( data.light_alias ) {
+			// one random number picks the slot and, with its fraction, the slot's light or its alias
+			code << "int sample_light( out float pdf ) {\n"
+					"	float u = rand() * float( light_count );\n"
+					"	int i = min( int( u ), light_count - 1 );\n"
+					"	vec4 slot = fetch( light_alias, i );\n"
+					"	if( fract( u ) < slot.x ) {\n"
+					"		pdf = slot.z;\n"
+					"		return i;\n"
+					"	}\n"
+					"	pdf = slot.w;\n"
+					"	return int( slot.y );\n"
+					"}\n\n";
+		}
 
-	// forwards
-	for( unsigned i = 0; i <= recursion; ++i )
-		code << "vec3 pathtrace" << i << "( ray r );\n";
-	code << "vec3 pathtracedummy( ray r ) {\n"
-			"	return vec3( 1.0, 1.0, 1.0 );\n"
-			"}\n"
-			"bool visible( ray r, light l );\n\n";
-
-	// diffuse lighting
-	code << "vec3 diffuse( light l, vec3 col, vec3 p, vec3 n ) {\n"
-			"	vec3 path = l.p - p;\n"
-			"	float len = length( path );\n"
-			"	path /= len;\n"
-			"	ray lr = ray( p, path );\n"
-			"	lr.o = propagate( lr, 1.0e-2 );\n"
-			"	return float( visible( lr, l ) ) * l.col * col / sq( len ) * dot( path, n );\n"
-			"}\n\n";
+		// forwards
+		code << "bool visible( ray r, light l );\n\n";
+
+		// diffuse lighting
+		code << "vec3 diffuse( light l, vec3 col, vec3 p, vec3 n ) {\n"
+				"	vec3 path = l.p - p;\n"
+				"	float len = length( path );\n"
+				"	path /= len;\n"
+				"	ray lr = ray( p, path );\n"
+				"	lr.o = propagate( lr, 1.0e-2 );\n"
+				"	return float( visible( lr, l ) ) * l.col * col / sq( len ) * dot( path, n );\n"
+				"}\n\n";
+	}
 
 	// material class
 	code << "struct material {\n"
@@ -317,42 +732,113 @@ std::string glossy::json2glsl( std::istream& stream ) {
 			"const uint mat_diffuse   = 0x02u;\n"
 			"const uint mat_specular  = 0x04u;\n\n";
 
-	// materialize funs
-	std::string materialize_name;
-	std::string materialize_tail_name = "0";
-	for( unsigned i = 0; i <= recursion; ++i ) {
-		materialize_name = std::move( materialize_tail_name );
-		if( i != recursion )
-			materialize_tail_name = std::to_string( i + 1 );
-		else
-			materialize_tail_name = "dummy";
-		code << "vec3 materialize" << materialize_name << "( ray r, const material mat, vec3 glob, vec3 rel, vec3 n ) {\n"
-				"	vec3 col = mat.col;\n"
+	code << "struct hit {\n"
+			"	float dist;\n"
+			"	material mat;\n"
+			"	vec3 glob;\n"
+			"	vec3 rel;\n"
+			"	vec3 n;\n"
+			"};\n";
+
+	// the light that a diffuse surface of color col reflects at h
+	if( data.lit ) {
+		code << "vec3 shade_diffuse( hit h, vec3 col ) {\n";
+		if( lights.empty() && !data.lights ) {
+			code << "	return col * background;\n";
+		} else {
+			code << "	vec3 diff = vec3( 0.0 );\n";
+			if( !lights.empty() )
+				code << "	for( int i = 0; i < lights.length(); ++i )\n"
+						"		diff += diffuse( lights[ i ], col, h.glob, h.n );\n";
+			if( data.light_alias ) {
+				// dividing by the probability of each pick keeps the estimate unbiased
+				code << "	if( light_count > 0 ) {\n"
+						"		for( int k = 0; k < light_samples; ++k ) {\n"
+						"			float pdf;\n"
+						"			int i = sample_light( pdf );\n"
+						"			diff += diffuse( get_light( i ), col, h.glob, h.n ) / ( pdf * float( light_samples ) );\n"
+						"		}\n"
+						"	}\n";
+			} else if( data.lights ) {
+				code << "	for( int i = 0; i < light_count; ++i )\n"
+						"		diff += diffuse( get_light( i ), col, h.glob, h.n );\n";
+			}
+			if( data.lights && lights.empty() )
+				code << "	if( light_count == 0 )\n"
+						"		diff = col * background;\n";
+			code << "	return diff;\n";
+		}
+		code << "}\n";
+	}
+
+	// materialize fun: the light leaving a hit towards the ray's origin except for reflections,
+	// whose share is returned in weight (zero unless the material is specular)
+	const char* const checker = "( mod( h.rel.x, 2.0 ) < 1.0 ) ^^ ( mod( h.rel.z, 2.0 ) < 1.0 )";
+	if( s.data_driven ) {
+		// the materials come from the data textures and may be anything
+		code << "vec3 materialize( ray r, hit h, out vec3 weight ) {\n"
+				"	vec3 col = h.mat.col;\n"
 				"	vec3 result = vec3( 0.0 );\n"
 				"	float denom = 0.0;\n"
-				"	if( ( mat.type & mat_checkered ) != 0u ) {\n"
-				"		if( ( mod( rel.x, 2.0 ) < 1.0 ) ^^ ( mod( rel.z, 2.0 ) < 1.0 ) )\n"
-				"			col *= 0.5;"
+				"	weight = vec3( 0.0 );\n"
+				"	if( ( h.mat.type & mat_checkered ) != 0u ) {\n"
+				"		if( " << checker << " )\n"
+				"			col *= 0.5;\n"
 				"	}\n"
-				"	if( ( mat.type & mat_diffuse ) != 0u ) {\n";
-		if( lights.empty() ) {
-			code << "		result += col * background;\n";
-		} else {
-			code << "		vec3 diff = vec3( 0.0 );\n"
-					"		for( int i = 0; i < lights.length(); ++i )\n"
-					"			diff += diffuse( lights[ i ], col, glob, n );\n"
-					"		result += diff * 1.0;\n";
-		}
-		code << "		++denom;\n"
+				"	if( ( h.mat.type & mat_diffuse ) != 0u ) {\n"
+				"		result += shade_diffuse( h, col );\n"
+				"		++denom;\n"
 				"	}\n"
-				"	if( ( mat.type & mat_specular ) != 0u ) {\n"
-				"		ray ref = ray( glob, reflect( r.d, n ) );\n"
-				"		ref.o += ref.d * 1.0e-3;\n"
-				"		result += col * pathtrace" << materialize_tail_name << "( ref );\n"
+				"	if( ( h.mat.type & mat_specular ) != 0u ) {\n"
+				"		weight = col;\n"
 				"		++denom;\n"
 				"	}\n"
+				"	if( denom == 0.0 )\n"
+				"		return vec3( 0.0 );\n"
+				"	weight /= denom;\n"
 				"	return result / denom;\n"
 				"}\n\n";
+	} else {
+		// one function without branches per material that occurs, with the diffuse and the
+		// specular share folded into constants, and a dispatch over them
+		std::vector< unsigned > types;
+		for( unsigned type = 0; type < material::type_count; ++type )
+			if( data.materials & ( 1u << type ) )
+				types.push_back( type );
+		const auto name = []( unsigned type ) {
+			std::string result = "materialize";
+			if( type & material::checkered_bit )
+				result += "_checkered";
+			if( type & material::diffuse_bit )
+				result += "_diffuse";
+			if( type & material::specular_bit )
+				result += "_specular";
+			return type == 0 ? result + "_black" : result;
+		};
+		for( unsigned type : types ) {
+			const bool diffuse = type & material::diffuse_bit;
+			const bool specular = type & material::specular_bit;
+			const std::string share = diffuse && specular ? " * 0.5" : "";
+			code << "vec3 " << name( type ) << "( ray r, hit h, out vec3 weight ) {\n";
+			if( diffuse || specular )
+				code << "	vec3 col = h.mat.col;\n";
+			if( ( type & material::checkered_bit ) && ( diffuse || specular ) )
+				code << "	if( " << checker << " )\n"
+						"		col *= 0.5;\n";
+			code << "	weight = " << ( specular ? "col" + share : "vec3( 0.0 )" ) << ";\n"
+				 << "	return " << ( diffuse ? "shade_diffuse( h, col )" + share : "vec3( 0.0 )" ) << ";\n"
+				 << "}\n";
+		}
+		code << "vec3 materialize( ray r, hit h, out vec3 weight ) {\n";
+		for( std::size_t i = 0; i + 1 < types.size(); ++i )
+			code << "	if( h.mat.type == " << types[ i ] << "u )\n"
+					"		return " << name( types[ i ] ) << "( r, h, weight );\n";
+		if( types.empty() )
+			code << "	weight = vec3( 0.0 );\n"
+					"	return vec3( 0.0 );\n";
+		else
+			code << "	return " << name( types.back() ) << "( r, h, weight );\n";
+		code << "}\n\n";
 	}
 
 	// sphere class
@@ -382,8 +868,57 @@ std::string glossy::json2glsl( std::istream& stream ) {
 			"}\n"
 			"vec3 normal( vec3 i, const sphere obj ) {\n"
 			"	return normalize( i - obj.p );\n"
+			"}\n"
+			"hit make_hit( ray r, float d, const sphere obj ) {\n"
+			"	vec3 i = propagate( r, d );\n"
+			"	return hit( d, obj.mat, i, i - obj.p, normal( i, obj ) );\n"
 			"}\n";
-	gen_eval_funs( code, "sphere" ) << '\n';
+	gen_eval_funs( code, "sphere" );
+
+	// searches over the spheres in the data textures, through the BVH if there is one
+	if( data.spheres ) {
+		code << "sphere get_sphere( int i ) {\n"
+				"	vec4 a = fetch( sphere_data, 2 * i );\n"
+				"	vec4 b = fetch( sphere_data, 2 * i + 1 );\n"
+				"	return sphere( a.xyz, a.w, material( uint( b.w ), b.rgb ) );\n"
+				"}\n";
+		if( data.bvh ) {
+			const std::vector< std::string > leaf{
+				"vec4 a = fetch( sphere_data, 2 * i );",
+				"float d = intersect( r, sphere( a.xyz, a.w, material( 0u, vec3( 0.0 ) ) ) );"
+			};
+			gen_hit_box( code );
+			gen_bvh_search( code, "sphere", "bvh_nodes", leaf, false );
+			if( shadows )
+				gen_bvh_search( code, "sphere", "bvh_nodes", leaf, true );
+		} else {
+			gen_linear_search( code, "sphere", false );
+			if( shadows )
+				gen_linear_search( code, "sphere", true );
+		}
+		gen_data_eval_funs( code, "sphere" );
+		if( data.tiles ) {
+			// the spheres that the primary rays of the current pixel's tile may hit, see bin_spheres
+			code << "int tile;\n"
+					"int closest_tile_sphere( ray r, inout float dist ) {\n"
+					"	int result = -1;\n"
+					"	vec4 t = fetch( tile_data, tile );\n"
+					"	int first = int( t.x );\n"
+					"	for( int k = first; k < first + int( t.y ); ++k ) {\n"
+					"		int i = int( fetch( tile_spheres, k / 4 )[ k % 4 ] );\n"
+					"		float d = intersect( r, get_sphere( i ) );\n";
+			gen_search_hit( code, false, "\t\t" );
+			code << "	}\n";
+			gen_search_tail( code, false );
+			code << "void eval_tile_spheres( ray r, inout hit h ) {\n"
+					"	float d = min( h.dist, " << rendering_distance << " );\n"
+					"	int id = closest_tile_sphere( r, d );\n"
+					"	if( id >= 0 )\n"
+					"		h = make_hit( r, d, get_sphere( id ) );\n"
+					"}\n";
+		}
+	}
+	code << '\n';
 
 	// plane class
 	code << "struct plane {\n"
@@ -400,54 +935,254 @@ std::string glossy::json2glsl( std::istream& stream ) {
 			"	}\n"
 			"	return no_hit;\n"
 			"}\n"
+			// normalized in advance, see below and scene_data
 			"vec3 normal( vec3 i, const plane obj ) {\n"
-			"	return normalize( obj.n );\n"
+			"	return obj.n;\n"
+			"}\n"
+			"hit make_hit( ray r, float d, const plane obj ) {\n"
+			"	vec3 i = propagate( r, d );\n"
+			"	return hit( d, obj.mat, i, i - obj.p, normal( i, obj ) );\n"
 			"}\n";
-	gen_eval_funs( code, "plane" ) << '\n';
+	gen_eval_funs( code, "plane" );
+	if( data.planes ) {
+		code << "plane get_plane( int i ) {\n"
+				"	vec4 b = fetch( plane_data, 3 * i + 2 );\n"
+				"	return plane( fetch( plane_data, 3 * i ).xyz, fetch( plane_data, 3 * i + 1 ).xyz, material( uint( b.w ), b.rgb ) );\n"
+				"}\n";
+		gen_linear_search( code, "plane", false );
+		if( shadows )
+			gen_linear_search( code, "plane", true );
+		gen_data_eval_funs( code, "plane" );
+	}
+	code << '\n';
+
+	// triangle class; triangles only come from the meshes in the data textures, through their BVH
+	if( data.meshes ) {
+		code << "struct triangle {\n"
+				"	vec3 a;\n"
+				"	vec3 b;\n"
+				"	vec3 c;\n"
+				"	vec3 p; // of the mesh\n"
+				"	material mat;\n"
+				"};\n"
+				// Möller–Trumbore, with the edge vectors divided by the determinant up front
+				"float intersect( ray r, vec3 a, vec3 b, vec3 c ) {\n"
+				"	vec3 e1 = b - a;\n"
+				"	vec3 e2 = c - a;\n"
+				"	vec3 p = cross( r.d, e2 );\n"
+				"	float det = dot( e1, p );\n"
+				"	if( abs( det ) < 1.0e-12 )\n"
+				"		return no_hit;\n"
+				"	vec3 s = ( r.o - a ) / det;\n"
+				"	float u = dot( s, p );\n"
+				"	if( u < 0.0 || u > 1.0 )\n"
+				"		return no_hit;\n"
+				"	vec3 q = cross( s, e1 );\n"
+				"	float v = dot( r.d, q );\n"
+				"	if( v < 0.0 || u + v > 1.0 )\n"
+				"		return no_hit;\n"
+				"	float t = dot( e2, q );\n"
+				"	return t > 0.0 ? t : no_hit;\n"
+				"}\n"
+				"float intersect( ray r, const triangle obj ) {\n"
+				"	return intersect( r, obj.a, obj.b, obj.c );\n"
+				"}\n"
+				"vec3 normal( vec3 i, const triangle obj ) {\n"
+				"	return normalize( cross( obj.b - obj.a, obj.c - obj.a ) );\n"
+				"}\n"
+				// meshes need not be closed or consistently wound, so triangles face the ray
+				"hit make_hit( ray r, float d, const triangle obj ) {\n"
+				"	vec3 i = propagate( r, d );\n"
+				"	vec3 n = normal( i, obj );\n"
+				"	return hit( d, obj.mat, i, i - obj.p, faceforward( n, r.d, n ) );\n"
+				"}\n"
+				"triangle get_triangle( int i ) {\n"
+				"	vec4 t = fetch( mesh_triangles, i );\n"
+				"	int m = 2 * int( t.w );\n"
+				"	vec4 b = fetch( mesh_data, m + 1 );\n"
+				"	return triangle(\n"
+				"		fetch( mesh_vertices, int( t.x ) ).xyz, fetch( mesh_vertices, int( t.y ) ).xyz, fetch( mesh_vertices, int( t.z ) ).xyz,\n"
+				"		fetch( mesh_data, m ).xyz, material( uint( b.w ), b.rgb ) );\n"
+				"}\n";
+		// the leaves only need the vertices
+		const std::vector< std::string > leaf{
+			"vec4 t = fetch( mesh_triangles, i );",
+			"float d = intersect( r, fetch( mesh_vertices, int( t.x ) ).xyz, fetch( mesh_vertices, int( t.y ) ).xyz, fetch( mesh_vertices, int( t.z ) ).xyz );"
+		};
+		if( !data.bvh )
+			gen_hit_box( code );
+		gen_bvh_search( code, "triangle", "mesh_bvh", leaf, false );
+		if( shadows )
+			gen_bvh_search( code, "triangle", "mesh_bvh", leaf, true );
+		gen_data_eval_funs( code, "triangle" );
+		code << '\n';
+	}
 
 	// scene description
-	for( std::size_t i = 0; i < objects.size(); ++i ) {
-		code << "const " << objects[ i ]->type() << " obj" << i << " = ";
-		objects[ i ]->print( code );
+	for( std::size_t i = 0; i < baked_objects; ++i ) {
+		if( i < baked_spheres ) {
+			code << "const sphere obj" << i << " = ";
+			s.spheres[ i ].print( code );
+		} else {
+			plane pl = s.planes[ i - baked_spheres ];
+			pl.normal /= norm( pl.normal );
+			code << "const plane obj" << i << " = ";
+			pl.print( code );
+		}
 		code << ";\n";
 	}
-	code << '\n';
+	if( baked_objects != 0 )
+		code << '\n';
 
-	// pathtracing funs
-	for( unsigned i = 0; i <= recursion; ++i ) {
-		code << "vec3 pathtrace" << i << "( ray r ) {\n"
-				"	vec3 col = background;\n"
-				"	float dist = no_hit;\n";
-		for( std::size_t j = 0; j < objects.size(); ++j ) {
-			code << "	eval" << i << "( r, col, dist, obj" << j << " );\n";
+	// the first hit of the current pixel's primary ray, see gbuffer. materials only look at
+	// the x and z of rel, so that is all it keeps.
+	if( opts.hybrid ) {
+		code << "hit gbuffer_hit() {\n"
+				"	ivec2 texel = ivec2( gl_FragCoord.xy );\n"
+				"	vec4 a = texelFetch( gbuffer_position, texel, 0 );\n"
+				"	vec4 b = texelFetch( gbuffer_normal, texel, 0 );\n"
+				"	vec4 c = texelFetch( gbuffer_material, texel, 0 );\n"
+				"	hit h;\n"
+				"	h.dist = no_hit;\n"
+				"	if( c.w >= 0.0 )\n"
+				"		h = hit( distance( a.xyz, pos ), material( uint( c.w ), c.rgb ), a.xyz, vec3( a.w, 0.0, b.w ), b.xyz );\n"
+				"	return h;\n"
+				"}\n\n";
+	}
+
+	// pathtracing fun: follows reflections for up to recursion bounces, carrying the share of
+	// the pixel's color that the current ray contributes. without specular materials, nothing
+	// reflects and only the first hit counts. reflected rays may go anywhere, so they test all
+	// spheres rather than those of the tile. in the hybrid mode, the first hit of the spheres
+	// and planes comes from the G-buffer, and only meshes are traced in front of it.
+	const auto gen_closest_hit = [ & ]( std::string const& indent, bool reflected ) {
+		code << indent << "hit h;\n";
+		if( opts.hybrid && reflected ) {
+			code << indent << "if( bounce == 0 ) {\n"
+				 << indent << "	h = gbuffer_hit();\n"
+				 << indent << "} else {\n"
+				 << indent << "	h.dist = no_hit;\n"
+				 << indent << "	eval_spheres( r, h );\n"
+				 << indent << "	eval_planes( r, h );\n"
+				 << indent << "}\n";
+		} else if( opts.hybrid ) {
+			code << indent << "h = gbuffer_hit();\n";
+		} else {
+			code << indent << "h.dist = no_hit;\n";
+			if( data.tiles && reflected )
+				code << indent << "if( bounce == 0 )\n"
+					 << indent << "	eval_tile_spheres( r, h );\n"
+					 << indent << "else\n"
+					 << indent << "	eval_spheres( r, h );\n";
+			else if( data.tiles )
+				code << indent << "eval_tile_spheres( r, h );\n";
+			else if( data.spheres )
+				code << indent << "eval_spheres( r, h );\n";
+			if( data.planes )
+				code << indent << "eval_planes( r, h );\n";
 		}
-		code << "	return col;\n"
+		if( data.meshes )
+			code << indent << "eval_triangles( r, h );\n";
+		for( std::size_t j = 0; j < baked_objects; ++j )
+			code << indent << "eval( r, h, obj" << j << " );\n";
+	};
+	// temporal shaders also report how far away the first hit is
+	if( opts.temporal )
+		code << "float primary_dist;\n";
+	// and shaders for the denoiser its guides: the normal, distance and albedo of the first hit,
+	// where misses have a distance of -1 and the background as albedo
+	if( guides )
+		code << "vec4 guide_normal_dist;\n"
+				"vec3 guide_albedo;\n"
+				"void set_guides( hit h ) {\n"
+				"	if( h.dist == no_hit ) {\n"
+				"		guide_normal_dist = vec4( 0.0, 0.0, 0.0, -1.0 );\n"
+				"		guide_albedo = background;\n"
+				"		return;\n"
+				"	}\n"
+				"	guide_normal_dist = vec4( h.n, h.dist );\n"
+				"	guide_albedo = h.mat.col;\n"
+				"	if( ( h.mat.type & mat_checkered ) != 0u && ( " << checker << " ) )\n"
+				"		guide_albedo *= 0.5;\n"
 				"}\n";
+	code << "vec3 pathtrace( ray r ) {\n";
+	if( data.reflective ) {
+		code << "	vec3 result = vec3( 0.0 );\n"
+				"	vec3 throughput = vec3( 1.0 );\n"
+				"	for( int bounce = 0; bounce <= recursion; ++bounce ) {\n";
+		gen_closest_hit( "\t\t", true );
+		if( opts.temporal )
+			code << "		if( bounce == 0 )\n"
+					"			primary_dist = h.dist;\n";
+		if( guides )
+			code << "		if( bounce == 0 )\n"
+					"			set_guides( h );\n";
+		code << "		if( h.dist == no_hit )\n"
+				"			return result + throughput * background;\n"
+				"		vec3 weight;\n"
+				"		result += throughput * materialize( r, h, weight );\n"
+				"		if( weight == vec3( 0.0 ) )\n"
+				"			return result;\n"
+				"		throughput *= weight;\n"
+				"		r = ray( h.glob, reflect( r.d, h.n ) );\n"
+				"		r.o += r.d * 1.0e-3;\n"
+				"	}\n"
+				"	// reflections beyond the last bounce are white\n"
+				"	return result + throughput;\n";
+	} else {
+		gen_closest_hit( "\t", false );
+		if( opts.temporal )
+			code << "	primary_dist = h.dist;\n";
+		if( guides )
+			code << "	set_guides( h );\n";
+		code << "	if( h.dist == no_hit )\n"
+				"		return background;\n"
+				"	vec3 weight;\n"
+				"	return materialize( r, h, weight );\n";
 	}
-	code << '\n';
+	code << "}\n\n";
 
 	// visibility checker function
-	if( objects.empty() ) {
-		code << "bool visible( ray r, light l ) {\n"
-				"	return true;\n"
-				"}\n\n";
-	} else {
-		code << "bool visible( ray r, light l ) {\n"
-				"	float dist = length( r.o - l.p );\n"
-				"	return";
-		std::size_t i;
-		for( i = 0; i < objects.size() - 1; ++i )
-			code << "\n\t\t!eval_occ( r, dist, obj" << i << " ) &&";
-		code << "\n\t\t!eval_occ( r, dist, obj" << i << " );\n";
-		code << "}\n\n";
+	if( shadows ) {
+		std::vector< std::string > occluders;
+		if( data.spheres )
+			occluders.push_back( "occluded_spheres( r, dist )" );
+		if( data.planes )
+			occluders.push_back( "occluded_planes( r, dist )" );
+		if( data.meshes )
+			occluders.push_back( "occluded_triangles( r, dist )" );
+		for( std::size_t i = 0; i < baked_objects; ++i )
+			occluders.push_back( "eval_occ( r, dist, obj" + std::to_string( i ) + " )" );
+		if( occluders.empty() ) {
+			code << "bool visible( ray r, light l ) {\n"
+					"	return true;\n"
+					"}\n\n";
+		} else {
+			code << "bool visible( ray r, light l ) {\n"
+					"	float dist = length( r.o - l.p );\n"
+					"	return";
+			std::size_t i;
+			for( i = 0; i < occluders.size() - 1; ++i )
+				code << "\n\t\t!" << occluders[ i ] << " &&";
+			code << "\n\t\t!" << occluders[ i ] << ";\n";
+			code << "}\n\n";
+		}
 	}
 
-	code << "vec3 calc( vec2 screen_coord ) {\n"
-			"	vec2 normalized = ( screen_coord - resolution / 2.0 ) * 2.0 / resolution.y * fovh;\n"
+	code << "vec3 calc( vec2 screen_coord ) {\n";
+	if( data.tiles )
+		code << "	tile = int( gl_FragCoord.y ) / " << tile_size << " * tile_columns + int( gl_FragCoord.x ) / " << tile_size << ";\n";
+	if( data.light_alias ) {
+		// every sample of a pixel, and in progressive mode every frame, picks other lights
+		code << "	uvec2 seed = uvec2( screen_coord * 256.0 );\n"
+				"	rng_state = seed.x * 1973u + seed.y * 9277u" << ( opts.progressive ? " + uint( samples ) * 26699u" : "" ) << ";\n"
+				"	rand();\n";
+	}
+	code << "	vec2 normalized = ( screen_coord - resolution / 2.0 ) * 2.0 / resolution.y * fovh;\n"
 			"	ray pixelray;\n"
 			"	pixelray.o = pos;\n"
 			"	pixelray.d = normalize( at + normalized.x * right + normalized.y * up );\n"
-			"	return pathtrace0( pixelray );\n"
+			"	return pathtrace( pixelray );\n"
 			"}\n\n";
 
 	const vec2 sub{ 1.0f / SS, 1.0f / SS };
@@ -457,20 +1192,78 @@ std::string glossy::json2glsl( std::istream& stream ) {
 	code << "void main() {\n"
 			"	vec3 result = vec3( 0.0 );\n";
 
-	if( SS != 1 ) {
+	if( opts.temporal ) {
+		code << "	result += calc( gl_FragCoord.xy + jitter );\n"
+				"	gl_FragColor = vec4( result, primary_dist == no_hit ? -1.0 : primary_dist );\n";
+	} else if( opts.progressive ) {
+		// the first sample must not look at the history, which may hold anything, including NaNs
+		code << "	result += calc( gl_FragCoord.xy + jitter );\n"
+				"	if( samples > 0.0 )\n"
+				"		result = mix( texelFetch( history, ivec2( gl_FragCoord.xy ), 0 ).rgb, result, 1.0 / ( samples + 1.0 ) );\n"
+				"	gl_FragColor = vec4( result, 1.0 );\n";
+	} else if( adaptive ) {
+		// the R2 sequence spreads any number of leading samples evenly over the pixel. every
+		// spp_min samples, the pixel stops once the standard error of the luminance, i.e.
+		// sqrt( variance / n ), falls below the threshold. alpha tells the accumulator how many
+		// samples were taken.
+		code << "	float lum = 0.0;\n"
+				"	float lum_sq = 0.0;\n"
+				"	int n = 0;\n"
+				"	for( ; n < spp_max; ++n ) {\n"
+				"		if( n >= spp_min && n % spp_min == 0 ) {\n"
+				"			float mean = lum / float( n );\n"
+				"			float variance = max( lum_sq / float( n ) - sq( mean ), 0.0 );\n"
+				"			if( variance < sq( adaptive_threshold ) * float( n ) )\n"
+				"				break;\n"
+				"		}\n"
+				"		vec3 c = calc( gl_FragCoord.xy + fract( vec2( 0.5 ) + float( n ) * vec2( 0.7548776662, 0.5698402910 ) ) );\n"
+				"		result += c;\n"
+				"		float l = dot( clamp( c, 0.0, 1.0 ), vec3( 0.2126, 0.7152, 0.0722 ) );\n"
+				"		lum += l;\n"
+				"		lum_sq += sq( l );\n"
+				"	}\n"
+				"	gl_FragColor = vec4( result / float( n ), float( n ) );\n";
+	} else if( SS != 1 ) {
+		if( guides )
+			code << "	vec4 normal_dist = vec4( 0.0 );\n"
+					"	vec3 albedo = vec3( 0.0 );\n";
 		code << "	for( int y = 0; y < SS; ++y ) {\n"
 				"		for( int x = 0; x < SS; ++x ) {\n"
 				"			vec2 subpix = gl_FragCoord.xy + vec2" << off << " + vec2" << sub << " * vec2( x, y );\n"
-				"			result += calc( subpix );\n"
-				"		}\n"
-				"	}\n"
-				"	gl_FragColor = vec4( result / sq( SS ), 1.0 );\n";
+				"			result += calc( subpix );\n";
+		if( guides )
+			code << "			normal_dist += guide_normal_dist;\n"
+					"			albedo += guide_albedo;\n";
+		code << "		}\n"
+				"	}\n";
+		// the guides go into the targets after the image's, see denoiser
+		if( guides )
+			code << "	gl_FragData[ 0 ] = vec4( result / sq( SS ), 1.0 );\n"
+					"	gl_FragData[ 1 ] = normal_dist / sq( SS );\n"
+					"	gl_FragData[ 2 ] = vec4( albedo / sq( SS ), 1.0 );\n";
+		else
+			code << "	gl_FragColor = vec4( result / sq( SS ), 1.0 );\n";
 	} else {
 		code << "	vec2 subpix = gl_FragCoord.xy + vec2" << off << ";\n"
-				"	result += calc( subpix );\n"
-				"	gl_FragColor = vec4( result, 1.0 );\n";
+				"	result += calc( subpix );\n";
+		if( guides )
+			code << "	gl_FragData[ 0 ] = vec4( result, 1.0 );\n"
+					"	gl_FragData[ 1 ] = guide_normal_dist;\n"
+					"	gl_FragData[ 2 ] = vec4( guide_albedo, 1.0 );\n";
+		else
+			code << "	gl_FragColor = vec4( result, 1.0 );\n";
 	}
 	code << "}\n";
 
 	return code.str();
 }
+
+std::string glossy::json2glsl( std::string const& filename ) {
+	return scene2glsl( json2scene( filename ) );
+}
+std::string glossy::json2glsl( char const* filename ) {
+	return scene2glsl( json2scene( filename ) );
+}
+std::string glossy::json2glsl( std::istream& stream ) {
+	return scene2glsl( json2scene( stream ) );
+}
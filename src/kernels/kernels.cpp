@@ -0,0 +1,369 @@
+#include <glossy/kernels.hpp>
+#include <cmath>
+// the AVX2 path multiplies and adds in one step, which is an instruction set of its own
+#if defined( __AVX2__ ) && defined( __FMA__ )
+	#define glossy_kernels_avx2
+#endif
+#if defined( glossy_kernels_avx2 ) || defined( __AVX512F__ )
+	#include <immintrin.h>
+#endif
+
+namespace {
+	using namespace glossy::kernels;
+
+	// every stream is padded to a multiple of this, the widest packet we know of
+	constexpr std::size_t padding = 16;
+
+	// the shader's intersect( ray, sphere ); returns infinity on a miss
+	float intersect( ray const& r, spheres const& s, std::size_t j ) {
+		const float ocx = r.ox - s.x[ j ];
+		const float ocy = r.oy - s.y[ j ];
+		const float ocz = r.oz - s.z[ j ];
+		const float ang = r.dx * ocx + r.dy * ocy + r.dz * ocz;
+		float radicand = ang * ang - ( ocx * ocx + ocy * ocy + ocz * ocz ) + s.r[ j ] * s.r[ j ];
+		if( radicand < 0.0f )
+			return INFINITY;
+		radicand = std::sqrt( radicand );
+		const float near = -ang - radicand;
+		const float far = -ang + radicand;
+		if( far < 0.0f )
+			return INFINITY;
+		return near < 0.0f ? far : near;
+	}
+	// the shader's intersect( ray, plane ); returns infinity on a miss
+	float intersect_plane( ray const& r, planes const& p, std::size_t j ) {
+		const float denom = r.dx * p.nx[ j ] + r.dy * p.ny[ j ] + r.dz * p.nz[ j ];
+		if( denom != 0.0f ) {
+			const float result = ( ( p.px[ j ] - r.ox ) * p.nx[ j ] + ( p.py[ j ] - r.oy ) * p.ny[ j ] + ( p.pz[ j ] - r.oz ) * p.nz[ j ] ) / denom;
+			if( result > 0.0f )
+				return result;
+		}
+		return INFINITY;
+	}
+
+	ray get( rays const& r, std::size_t i ) {
+		return { r.ox[ i ], r.oy[ i ], r.oz[ i ], r.dx[ i ], r.dy[ i ], r.dz[ i ] };
+	}
+
+	void closest_hit_scalar( rays& r, spheres const& s, planes const& p ) {
+		for( std::size_t i = 0; i < r.size(); ++i )
+			r.id[ i ] = closest_hit( get( r, i ), r.t[ i ], s, p );
+	}
+	void any_hit_scalar( rays const& r, spheres const& s, planes const& p, std::vector< std::uint8_t >& occluded ) {
+		for( std::size_t i = 0; i < r.size(); ++i )
+			occluded[ i ] = any_hit( get( r, i ), r.t[ i ], s, p );
+	}
+
+#ifdef glossy_kernels_avx2
+	// distances of the hits (garbage elsewhere) and the mask of lanes that hit
+	struct hit8 {
+		__m256 dist;
+		__m256 mask;
+	};
+	struct packet8 {
+		__m256 ox, oy, oz, dx, dy, dz;
+
+		packet8( rays const& r, std::size_t i )
+			: ox{ _mm256_loadu_ps( &r.ox[ i ] ) }
+			, oy{ _mm256_loadu_ps( &r.oy[ i ] ) }
+			, oz{ _mm256_loadu_ps( &r.oz[ i ] ) }
+			, dx{ _mm256_loadu_ps( &r.dx[ i ] ) }
+			, dy{ _mm256_loadu_ps( &r.dy[ i ] ) }
+			, dz{ _mm256_loadu_ps( &r.dz[ i ] ) } {
+		}
+
+		hit8 intersect( spheres const& s, std::size_t j ) const {
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 ocx = _mm256_sub_ps( ox, _mm256_set1_ps( s.x[ j ] ) );
+			const __m256 ocy = _mm256_sub_ps( oy, _mm256_set1_ps( s.y[ j ] ) );
+			const __m256 ocz = _mm256_sub_ps( oz, _mm256_set1_ps( s.z[ j ] ) );
+			const __m256 ang = _mm256_fmadd_ps( dx, ocx, _mm256_fmadd_ps( dy, ocy, _mm256_mul_ps( dz, ocz ) ) );
+			const __m256 normsq = _mm256_fmadd_ps( ocx, ocx, _mm256_fmadd_ps( ocy, ocy, _mm256_mul_ps( ocz, ocz ) ) );
+			const __m256 radicand = _mm256_fmadd_ps( ang, ang, _mm256_fmsub_ps( _mm256_set1_ps( s.r[ j ] ), _mm256_set1_ps( s.r[ j ] ), normsq ) );
+			const __m256 root = _mm256_sqrt_ps( _mm256_max_ps( radicand, zero ) );
+			const __m256 near = _mm256_sub_ps( _mm256_sub_ps( zero, ang ), root );
+			const __m256 far = _mm256_sub_ps( root, ang );
+			const __m256 dist = _mm256_blendv_ps( near, far, _mm256_cmp_ps( near, zero, _CMP_LT_OQ ) );
+			const __m256 hit = _mm256_and_ps( _mm256_cmp_ps( radicand, zero, _CMP_GE_OQ ), _mm256_cmp_ps( far, zero, _CMP_GE_OQ ) );
+			return { dist, hit };
+		}
+		hit8 intersect( planes const& p, std::size_t j ) const {
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 nx = _mm256_set1_ps( p.nx[ j ] );
+			const __m256 ny = _mm256_set1_ps( p.ny[ j ] );
+			const __m256 nz = _mm256_set1_ps( p.nz[ j ] );
+			const __m256 denom = _mm256_fmadd_ps( dx, nx, _mm256_fmadd_ps( dy, ny, _mm256_mul_ps( dz, nz ) ) );
+			const __m256 num = _mm256_fmadd_ps( _mm256_sub_ps( _mm256_set1_ps( p.px[ j ] ), ox ), nx,
+				_mm256_fmadd_ps( _mm256_sub_ps( _mm256_set1_ps( p.py[ j ] ), oy ), ny,
+				_mm256_mul_ps( _mm256_sub_ps( _mm256_set1_ps( p.pz[ j ] ), oz ), nz ) ) );
+			const __m256 dist = _mm256_div_ps( num, denom );
+			const __m256 hit = _mm256_and_ps( _mm256_cmp_ps( denom, zero, _CMP_NEQ_OQ ), _mm256_cmp_ps( dist, zero, _CMP_GT_OQ ) );
+			return { dist, hit };
+		}
+	};
+
+	void closest_hit_avx2( rays& r, spheres const& s, planes const& p ) {
+		for( std::size_t i = 0; i < r.ox.size(); i += 8 ) {
+			const packet8 packet{ r, i };
+			__m256 t = _mm256_loadu_ps( &r.t[ i ] );
+			__m256 id = _mm256_castsi256_ps( _mm256_set1_epi32( no_hit ) );
+			const auto update = [ & ]( hit8 const& hit, std::size_t j ) {
+				const __m256 closer = _mm256_and_ps( hit.mask, _mm256_cmp_ps( hit.dist, t, _CMP_LT_OQ ) );
+				t = _mm256_blendv_ps( t, hit.dist, closer );
+				id = _mm256_blendv_ps( id, _mm256_castsi256_ps( _mm256_set1_epi32( static_cast< int >( j ) ) ), closer );
+			};
+			for( std::size_t j = 0; j < s.size(); ++j )
+				update( packet.intersect( s, j ), j );
+			for( std::size_t j = 0; j < p.size(); ++j )
+				update( packet.intersect( p, j ), s.size() + j );
+			_mm256_storeu_ps( &r.t[ i ], t );
+			_mm256_storeu_si256( reinterpret_cast< __m256i* >( &r.id[ i ] ), _mm256_castps_si256( id ) );
+		}
+	}
+	void any_hit_avx2( rays const& r, spheres const& s, planes const& p, std::vector< std::uint8_t >& occluded ) {
+		for( std::size_t i = 0; i < r.ox.size(); i += 8 ) {
+			const packet8 packet{ r, i };
+			const __m256 t = _mm256_loadu_ps( &r.t[ i ] );
+			__m256 occ = _mm256_setzero_ps();
+			const auto update = [ & ]( hit8 const& hit ) {
+				occ = _mm256_or_ps( occ, _mm256_and_ps( hit.mask, _mm256_cmp_ps( hit.dist, t, _CMP_LT_OQ ) ) );
+				return _mm256_movemask_ps( occ ) == 0xFF;
+			};
+			bool done = false;
+			for( std::size_t j = 0; j < s.size() && !done; ++j )
+				done = update( packet.intersect( s, j ) );
+			for( std::size_t j = 0; j < p.size() && !done; ++j )
+				done = update( packet.intersect( p, j ) );
+			const int mask = _mm256_movemask_ps( occ );
+			for( std::size_t k = 0; k < 8; ++k )
+				occluded[ i + k ] = ( mask >> k ) & 1;
+		}
+	}
+#endif // glossy_kernels_avx2
+
+#ifdef __AVX512F__
+	struct hit16 {
+		__m512 dist;
+		__mmask16 mask;
+	};
+	struct packet16 {
+		__m512 ox, oy, oz, dx, dy, dz;
+
+		packet16( rays const& r, std::size_t i )
+			: ox{ _mm512_loadu_ps( &r.ox[ i ] ) }
+			, oy{ _mm512_loadu_ps( &r.oy[ i ] ) }
+			, oz{ _mm512_loadu_ps( &r.oz[ i ] ) }
+			, dx{ _mm512_loadu_ps( &r.dx[ i ] ) }
+			, dy{ _mm512_loadu_ps( &r.dy[ i ] ) }
+			, dz{ _mm512_loadu_ps( &r.dz[ i ] ) } {
+		}
+
+		hit16 intersect( spheres const& s, std::size_t j ) const {
+			const __m512 zero = _mm512_setzero_ps();
+			const __m512 ocx = _mm512_sub_ps( ox, _mm512_set1_ps( s.x[ j ] ) );
+			const __m512 ocy = _mm512_sub_ps( oy, _mm512_set1_ps( s.y[ j ] ) );
+			const __m512 ocz = _mm512_sub_ps( oz, _mm512_set1_ps( s.z[ j ] ) );
+			const __m512 ang = _mm512_fmadd_ps( dx, ocx, _mm512_fmadd_ps( dy, ocy, _mm512_mul_ps( dz, ocz ) ) );
+			const __m512 normsq = _mm512_fmadd_ps( ocx, ocx, _mm512_fmadd_ps( ocy, ocy, _mm512_mul_ps( ocz, ocz ) ) );
+			const __m512 radicand = _mm512_fmadd_ps( ang, ang, _mm512_fmsub_ps( _mm512_set1_ps( s.r[ j ] ), _mm512_set1_ps( s.r[ j ] ), normsq ) );
+			const __mmask16 real = _mm512_cmp_ps_mask( radicand, zero, _CMP_GE_OQ );
+			const __m512 root = _mm512_maskz_sqrt_ps( real, radicand );
+			const __m512 near = _mm512_sub_ps( _mm512_sub_ps( zero, ang ), root );
+			const __m512 far = _mm512_sub_ps( root, ang );
+			const __m512 dist = _mm512_mask_blend_ps( _mm512_cmp_ps_mask( near, zero, _CMP_LT_OQ ), near, far );
+			const __mmask16 hit = real & _mm512_cmp_ps_mask( far, zero, _CMP_GE_OQ );
+			return { dist, hit };
+		}
+		hit16 intersect( planes const& p, std::size_t j ) const {
+			const __m512 zero = _mm512_setzero_ps();
+			const __m512 nx = _mm512_set1_ps( p.nx[ j ] );
+			const __m512 ny = _mm512_set1_ps( p.ny[ j ] );
+			const __m512 nz = _mm512_set1_ps( p.nz[ j ] );
+			const __m512 denom = _mm512_fmadd_ps( dx, nx, _mm512_fmadd_ps( dy, ny, _mm512_mul_ps( dz, nz ) ) );
+			const __m512 num = _mm512_fmadd_ps( _mm512_sub_ps( _mm512_set1_ps( p.px[ j ] ), ox ), nx,
+				_mm512_fmadd_ps( _mm512_sub_ps( _mm512_set1_ps( p.py[ j ] ), oy ), ny,
+				_mm512_mul_ps( _mm512_sub_ps( _mm512_set1_ps( p.pz[ j ] ), oz ), nz ) ) );
+			const __m512 dist = _mm512_div_ps( num, denom );
+			const __mmask16 hit = _mm512_cmp_ps_mask( denom, zero, _CMP_NEQ_OQ ) & _mm512_cmp_ps_mask( dist, zero, _CMP_GT_OQ );
+			return { dist, hit };
+		}
+	};
+
+	void closest_hit_avx512( rays& r, spheres const& s, planes const& p ) {
+		for( std::size_t i = 0; i < r.ox.size(); i += 16 ) {
+			const packet16 packet{ r, i };
+			__m512 t = _mm512_loadu_ps( &r.t[ i ] );
+			__m512i id = _mm512_set1_epi32( no_hit );
+			const auto update = [ & ]( hit16 const& hit, std::size_t j ) {
+				const __mmask16 closer = hit.mask & _mm512_cmp_ps_mask( hit.dist, t, _CMP_LT_OQ );
+				t = _mm512_mask_mov_ps( t, closer, hit.dist );
+				id = _mm512_mask_mov_epi32( id, closer, _mm512_set1_epi32( static_cast< int >( j ) ) );
+			};
+			for( std::size_t j = 0; j < s.size(); ++j )
+				update( packet.intersect( s, j ), j );
+			for( std::size_t j = 0; j < p.size(); ++j )
+				update( packet.intersect( p, j ), s.size() + j );
+			_mm512_storeu_ps( &r.t[ i ], t );
+			_mm512_storeu_si512( &r.id[ i ], id );
+		}
+	}
+	void any_hit_avx512( rays const& r, spheres const& s, planes const& p, std::vector< std::uint8_t >& occluded ) {
+		for( std::size_t i = 0; i < r.ox.size(); i += 16 ) {
+			const packet16 packet{ r, i };
+			const __m512 t = _mm512_loadu_ps( &r.t[ i ] );
+			__mmask16 occ = 0;
+			for( std::size_t j = 0; j < s.size() && occ != 0xFFFF; ++j ) {
+				const auto hit = packet.intersect( s, j );
+				occ |= hit.mask & _mm512_cmp_ps_mask( hit.dist, t, _CMP_LT_OQ );
+			}
+			for( std::size_t j = 0; j < p.size() && occ != 0xFFFF; ++j ) {
+				const auto hit = packet.intersect( p, j );
+				occ |= hit.mask & _mm512_cmp_ps_mask( hit.dist, t, _CMP_LT_OQ );
+			}
+			for( std::size_t k = 0; k < 16; ++k )
+				occluded[ i + k ] = ( occ >> k ) & 1;
+		}
+	}
+#endif // __AVX512F__
+}
+
+char const* glossy::kernels::name( isa set ) {
+	switch( set ) {
+	case isa::avx2:
+		return "AVX2";
+	case isa::avx512:
+		return "AVX-512";
+	default:
+		return "scalar";
+	}
+}
+std::size_t glossy::kernels::width( isa set ) {
+	switch( set ) {
+	case isa::avx2:
+		return 8;
+	case isa::avx512:
+		return 16;
+	default:
+		return 1;
+	}
+}
+std::vector< glossy::kernels::isa > glossy::kernels::available() {
+	std::vector< isa > result{ isa::scalar };
+#ifdef glossy_kernels_avx2
+	result.push_back( isa::avx2 );
+#endif // glossy_kernels_avx2
+#ifdef __AVX512F__
+	result.push_back( isa::avx512 );
+#endif // __AVX512F__
+	return result;
+}
+glossy::kernels::isa glossy::kernels::native() {
+	return available().back();
+}
+
+void glossy::kernels::spheres::add( float px, float py, float pz, float radius ) {
+	x.push_back( px );
+	y.push_back( py );
+	z.push_back( pz );
+	r.push_back( radius );
+}
+std::size_t glossy::kernels::spheres::size() const {
+	return x.size();
+}
+
+void glossy::kernels::planes::add( float x, float y, float z, float normal_x, float normal_y, float normal_z ) {
+	px.push_back( x );
+	py.push_back( y );
+	pz.push_back( z );
+	nx.push_back( normal_x );
+	ny.push_back( normal_y );
+	nz.push_back( normal_z );
+}
+std::size_t glossy::kernels::planes::size() const {
+	return px.size();
+}
+
+void glossy::kernels::rays::resize( std::size_t count ) {
+	m_size = count;
+	const std::size_t padded = ( count + padding - 1 ) / padding * padding;
+	for( auto* v : { &ox, &oy, &oz, &dx, &dy, &dz } )
+		v->resize( padded, 0.0f );
+	// a maximum distance of zero keeps the padding from ever hitting anything
+	t.assign( padded, 0.0f );
+	id.assign( padded, no_hit );
+}
+std::size_t glossy::kernels::rays::size() const {
+	return m_size;
+}
+void glossy::kernels::rays::set( std::size_t i, ray const& r, float max_dist ) {
+	ox[ i ] = r.ox;
+	oy[ i ] = r.oy;
+	oz[ i ] = r.oz;
+	dx[ i ] = r.dx;
+	dy[ i ] = r.dy;
+	dz[ i ] = r.dz;
+	t[ i ] = max_dist;
+	id[ i ] = no_hit;
+}
+
+void glossy::kernels::closest_hit( rays& r, spheres const& s, planes const& p, isa set ) {
+	switch( set ) {
+#ifdef glossy_kernels_avx2
+	case isa::avx2:
+		closest_hit_avx2( r, s, p );
+		break;
+#endif // glossy_kernels_avx2
+#ifdef __AVX512F__
+	case isa::avx512:
+		closest_hit_avx512( r, s, p );
+		break;
+#endif // __AVX512F__
+	default:
+		closest_hit_scalar( r, s, p );
+	}
+}
+void glossy::kernels::any_hit( rays const& r, spheres const& s, planes const& p, std::vector< std::uint8_t >& occluded, isa set ) {
+	occluded.resize( r.ox.size() );
+	switch( set ) {
+#ifdef glossy_kernels_avx2
+	case isa::avx2:
+		any_hit_avx2( r, s, p, occluded );
+		break;
+#endif // glossy_kernels_avx2
+#ifdef __AVX512F__
+	case isa::avx512:
+		any_hit_avx512( r, s, p, occluded );
+		break;
+#endif // __AVX512F__
+	default:
+		any_hit_scalar( r, s, p, occluded );
+	}
+}
+
+std::int32_t glossy::kernels::closest_hit( ray const& r, float& t, spheres const& s, planes const& p ) {
+	std::int32_t result = no_hit;
+	for( std::size_t j = 0; j < s.size(); ++j ) {
+		const float d = intersect( r, s, j );
+		if( d < t ) {
+			t = d;
+			result = static_cast< std::int32_t >( j );
+		}
+	}
+	for( std::size_t j = 0; j < p.size(); ++j ) {
+		const float d = intersect_plane( r, p, j );
+		if( d < t ) {
+			t = d;
+			result = static_cast< std::int32_t >( s.size() + j );
+		}
+	}
+	return result;
+}
+bool glossy::kernels::any_hit( ray const& r, float t, spheres const& s, planes const& p ) {
+	for( std::size_t j = 0; j < s.size(); ++j )
+		if( intersect( r, s, j ) < t )
+			return true;
+	for( std::size_t j = 0; j < p.size(); ++j )
+		if( intersect_plane( r, p, j ) < t )
+			return true;
+	return false;
+}
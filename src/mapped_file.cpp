@@ -0,0 +1,85 @@
+#include <glossy/mapped_file.hpp>
+#include <stdexcept>
+
+#if defined( _WIN32 ) || defined( WIN32 )
+	#define glossy_windows
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN 1
+	#endif // !WIN32_LEAN_AND_MEAN
+	#ifndef NOMINMAX
+		#define NOMINMAX 1
+	#endif // !NOMINMAX
+	#include <windows.h>
+#else // glossy_windows
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif // glossy_windows
+
+glossy::mapped_file::mapped_file( std::string const& filename ) {
+#ifdef glossy_windows
+	const HANDLE file = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( file == INVALID_HANDLE_VALUE )
+		throw std::runtime_error{ "unable to load file: " + filename };
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( file, &size ) ) {
+		CloseHandle( file );
+		throw std::runtime_error{ "unable to load file: " + filename };
+	}
+	m_size = static_cast< std::size_t >( size.QuadPart );
+	m_file = file;
+	if( m_size == 0 )
+		return;
+	const HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if( mapping )
+		m_data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( !m_data ) {
+		if( mapping )
+			CloseHandle( mapping );
+		CloseHandle( file );
+		throw std::runtime_error{ "unable to map file: " + filename };
+	}
+	m_mapping = mapping;
+#else // glossy_windows
+	const int fd = open( filename.c_str(), O_RDONLY );
+	if( fd < 0 )
+		throw std::runtime_error{ "unable to load file: " + filename };
+	struct stat info;
+	if( fstat( fd, &info ) != 0 ) {
+		close( fd );
+		throw std::runtime_error{ "unable to load file: " + filename };
+	}
+	m_size = static_cast< std::size_t >( info.st_size );
+	if( m_size != 0 ) {
+		void* data = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data == MAP_FAILED ) {
+			close( fd );
+			throw std::runtime_error{ "unable to map file: " + filename };
+		}
+		m_data = data;
+	}
+	// the mapping keeps the file alive
+	close( fd );
+#endif // glossy_windows
+}
+glossy::mapped_file::~mapped_file() {
+#ifdef glossy_windows
+	if( m_data )
+		UnmapViewOfFile( m_data );
+	if( m_mapping )
+		CloseHandle( m_mapping );
+	if( m_file )
+		CloseHandle( m_file );
+#else // glossy_windows
+	if( m_data )
+		munmap( const_cast< void* >( m_data ), m_size );
+#endif // glossy_windows
+}
+
+char const* glossy::mapped_file::data() const {
+	return static_cast< char const* >( m_data );
+}
+std::size_t glossy::mapped_file::size() const {
+	return m_size;
+}
@@ -0,0 +1,554 @@
+#include <glossy/mesh_file.hpp>
+#include <glossy/mapped_file.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+	using namespace glossy;
+
+	// enough chunks per thread to even out lines of different lengths
+	constexpr std::size_t chunks_per_thread = 4;
+	// files below this size are not worth splitting
+	constexpr std::size_t min_chunk_bytes = 1 << 16;
+
+	bool is_blank( char c ) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+	void skip_blanks( char const*& p, char const* end ) {
+		while( p != end && is_blank( *p ) )
+			++p;
+	}
+	void skip_line( char const*& p, char const* end ) {
+		p = std::find( p, end, '\n' );
+		if( p != end )
+			++p;
+	}
+
+	// std::strtod and friends need a terminating character, which a mapped file does not have;
+	// these also skip the locale and are a lot faster
+	bool parse_int( char const*& p, char const* end, std::int64_t& value ) {
+		skip_blanks( p, end );
+		bool negative = false;
+		if( p != end && ( *p == '-' || *p == '+' ) )
+			negative = *p++ == '-';
+		if( p == end || !std::isdigit( static_cast< unsigned char >( *p ) ) )
+			return false;
+		value = 0;
+		while( p != end && std::isdigit( static_cast< unsigned char >( *p ) ) )
+			value = value * 10 + ( *p++ - '0' );
+		if( negative )
+			value = -value;
+		return true;
+	}
+	// mantissa * 10^exponent, exactly for the exponents that come up in practice
+	double scale( double mantissa, int exponent ) {
+		static const double powers[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+		constexpr int max_exact = 22;
+		if( exponent >= 0 )
+			return mantissa * ( exponent <= max_exact ? powers[ exponent ] : std::pow( 10.0, exponent ) );
+		return mantissa / ( -exponent <= max_exact ? powers[ -exponent ] : std::pow( 10.0, -exponent ) );
+	}
+	bool parse_number( char const*& p, char const* end, double& value ) {
+		skip_blanks( p, end );
+		bool negative = false;
+		if( p != end && ( *p == '-' || *p == '+' ) )
+			negative = *p++ == '-';
+		std::uint64_t mantissa = 0;
+		int exponent = 0;
+		bool digits = false;
+		for( ; p != end && std::isdigit( static_cast< unsigned char >( *p ) ); ++p, digits = true ) {
+			if( mantissa < std::numeric_limits< std::uint64_t >::max() / 10 )
+				mantissa = mantissa * 10 + static_cast< unsigned >( *p - '0' );
+			else
+				++exponent;
+		}
+		if( p != end && *p == '.' ) {
+			for( ++p; p != end && std::isdigit( static_cast< unsigned char >( *p ) ); ++p, digits = true ) {
+				if( mantissa < std::numeric_limits< std::uint64_t >::max() / 10 ) {
+					mantissa = mantissa * 10 + static_cast< unsigned >( *p - '0' );
+					--exponent;
+				}
+			}
+		}
+		if( !digits )
+			return false;
+		if( p != end && ( *p == 'e' || *p == 'E' ) ) {
+			std::int64_t e;
+			++p;
+			if( !parse_int( p, end, e ) )
+				return false;
+			exponent += static_cast< int >( std::max< std::int64_t >( -1000, std::min< std::int64_t >( 1000, e ) ) );
+		}
+		value = scale( static_cast< double >( mantissa ), exponent );
+		if( negative )
+			value = -value;
+		return true;
+	}
+
+	// splits [begin, end) into about count pieces that end after a newline
+	std::vector< char const* > split_lines( char const* begin, char const* end, std::size_t count ) {
+		std::vector< char const* > result{ begin };
+		const std::size_t size = static_cast< std::size_t >( end - begin );
+		for( std::size_t i = 1; i < count; ++i ) {
+			char const* p = std::max( result.back(), begin + size / count * i );
+			skip_line( p, end );
+			if( p != end && p != result.back() )
+				result.push_back( p );
+		}
+		result.push_back( end );
+		return result;
+	}
+	std::size_t chunk_count( std::size_t bytes, thread_pool const& pool ) {
+		return std::max< std::size_t >( 1, std::min( pool.size() * chunks_per_thread, bytes / min_chunk_bytes ) );
+	}
+
+	std::runtime_error mesh_error( std::string const& filename, std::string const& what ) {
+		return std::runtime_error{ filename + ": " + what };
+	}
+
+	// OBJ
+
+	struct obj_chunk {
+		std::vector< vec3 > vertices;
+		std::vector< std::int64_t > corners; // three per triangle
+		// the entries of corners that count relative to this chunk's first vertex, because the
+		// file counted backwards from the latest vertex; the others are already absolute
+		std::vector< std::size_t > relative;
+	};
+
+	void parse_obj( char const* p, char const* end, obj_chunk& chunk, std::string const& filename ) {
+		std::vector< std::int64_t > face;
+		std::vector< bool > face_relative;
+		while( p != end ) {
+			skip_blanks( p, end );
+			if( end - p >= 2 && p[ 0 ] == 'v' && is_blank( p[ 1 ] ) ) {
+				++p;
+				double x, y, z;
+				if( !parse_number( p, end, x ) || !parse_number( p, end, y ) || !parse_number( p, end, z ) )
+					throw mesh_error( filename, "invalid vertex" );
+				chunk.vertices.push_back( { static_cast< float >( x ), static_cast< float >( y ), static_cast< float >( z ) } );
+			} else if( end - p >= 2 && p[ 0 ] == 'f' && is_blank( p[ 1 ] ) ) {
+				++p;
+				face.clear();
+				face_relative.clear();
+				while( true ) {
+					skip_blanks( p, end );
+					if( p == end || *p == '\n' || *p == '#' )
+						break;
+					std::int64_t index;
+					if( !parse_int( p, end, index ) || index == 0 )
+						throw mesh_error( filename, "invalid face" );
+					// texture coordinates and normals
+					while( p != end && !is_blank( *p ) && *p != '\n' )
+						++p;
+					if( index > 0 ) {
+						face.push_back( index - 1 );
+						face_relative.push_back( false );
+					} else {
+						face.push_back( static_cast< std::int64_t >( chunk.vertices.size() ) + index );
+						face_relative.push_back( true );
+					}
+				}
+				if( face.size() < 3 )
+					throw mesh_error( filename, "faces need at least three vertices" );
+				for( std::size_t i = 1; i + 1 < face.size(); ++i ) {
+					for( std::size_t j : { std::size_t{ 0 }, i, i + 1 } ) {
+						if( face_relative[ j ] )
+							chunk.relative.push_back( chunk.corners.size() );
+						chunk.corners.push_back( face[ j ] );
+					}
+				}
+			}
+			skip_line( p, end );
+		}
+	}
+
+	void load_obj( mesh& m, mapped_file const& file, std::string const& filename, thread_pool& pool ) {
+		const std::vector< char const* > bounds = split_lines( file.data(), file.data() + file.size(), chunk_count( file.size(), pool ) );
+		std::vector< obj_chunk > chunks( bounds.size() - 1 );
+		pool.parallel_for( chunks.size(), [ & ]( std::size_t i ) {
+			parse_obj( bounds[ i ], bounds[ i + 1 ], chunks[ i ], filename );
+		} );
+
+		std::size_t vertex_count = 0;
+		std::size_t corner_count = 0;
+		for( auto const& chunk : chunks ) {
+			vertex_count += chunk.vertices.size();
+			corner_count += chunk.corners.size();
+		}
+		if( vertex_count > std::numeric_limits< std::uint32_t >::max() )
+			throw mesh_error( filename, "too many vertices" );
+		m.vertices.clear();
+		m.vertices.reserve( vertex_count );
+		m.indices.clear();
+		m.indices.reserve( corner_count );
+		for( auto& chunk : chunks ) {
+			const auto offset = static_cast< std::int64_t >( m.vertices.size() );
+			for( std::size_t i : chunk.relative )
+				chunk.corners[ i ] += offset;
+			for( std::int64_t corner : chunk.corners ) {
+				if( corner < 0 || corner >= static_cast< std::int64_t >( vertex_count ) )
+					throw mesh_error( filename, "face references a missing vertex" );
+				m.indices.push_back( static_cast< std::uint32_t >( corner ) );
+			}
+			m.vertices.insert( m.vertices.end(), chunk.vertices.begin(), chunk.vertices.end() );
+			chunk = obj_chunk{};
+		}
+	}
+
+	// PLY
+
+	enum class ply_type {
+		int8, uint8, int16, uint16, int32, uint32, float32, float64
+	};
+	std::size_t size_of( ply_type type ) {
+		switch( type ) {
+		case ply_type::int8:
+		case ply_type::uint8:
+			return 1;
+		case ply_type::int16:
+		case ply_type::uint16:
+			return 2;
+		case ply_type::int32:
+		case ply_type::uint32:
+		case ply_type::float32:
+			return 4;
+		default:
+			return 8;
+		}
+	}
+	bool parse_type( std::string const& name, ply_type& type ) {
+		static const struct {
+			char const* name;
+			ply_type type;
+		} names[] = {
+			{ "char", ply_type::int8 }, { "int8", ply_type::int8 },
+			{ "uchar", ply_type::uint8 }, { "uint8", ply_type::uint8 },
+			{ "short", ply_type::int16 }, { "int16", ply_type::int16 },
+			{ "ushort", ply_type::uint16 }, { "uint16", ply_type::uint16 },
+			{ "int", ply_type::int32 }, { "int32", ply_type::int32 },
+			{ "uint", ply_type::uint32 }, { "uint32", ply_type::uint32 },
+			{ "float", ply_type::float32 }, { "float32", ply_type::float32 },
+			{ "double", ply_type::float64 }, { "float64", ply_type::float64 }
+		};
+		for( auto const& n : names ) {
+			if( name == n.name ) {
+				type = n.type;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	struct ply_property {
+		std::string name;
+		ply_type type = ply_type::float32;
+		bool list = false;
+		ply_type count_type = ply_type::uint8; // of lists
+	};
+	struct ply_element {
+		std::string name;
+		std::size_t count = 0;
+		std::vector< ply_property > properties;
+	};
+	enum class ply_format {
+		ascii, little_endian, big_endian
+	};
+
+	// reads the values of a PLY file's body, whatever its format
+	class ply_reader {
+		char const* m_p;
+		char const* m_end;
+		ply_format m_format;
+		std::string const& m_filename;
+
+		template< typename T >
+		T load() {
+			if( static_cast< std::size_t >( m_end - m_p ) < sizeof( T ) )
+				throw mesh_error( m_filename, "unexpected end of file" );
+			unsigned char bytes[ sizeof( T ) ];
+			std::memcpy( bytes, m_p, sizeof( T ) );
+			m_p += sizeof( T );
+			const std::uint16_t one = 1;
+			const bool little = *reinterpret_cast< unsigned char const* >( &one ) == 1;
+			if( little != ( m_format == ply_format::little_endian ) )
+				std::reverse( bytes, bytes + sizeof( T ) );
+			T result;
+			std::memcpy( &result, bytes, sizeof( T ) );
+			return result;
+		}
+
+	public:
+		ply_reader( char const* begin, char const* end, ply_format format, std::string const& filename )
+			: m_p{ begin }
+			, m_end{ end }
+			, m_format{ format }
+			, m_filename( filename ) {
+		}
+
+		char const* position() const {
+			return m_p;
+		}
+		void seek( char const* p ) {
+			m_p = p;
+		}
+
+		double read( ply_type type ) {
+			if( m_format == ply_format::ascii ) {
+				double result;
+				while( m_p != m_end && std::isspace( static_cast< unsigned char >( *m_p ) ) )
+					++m_p;
+				if( !parse_number( m_p, m_end, result ) )
+					throw mesh_error( m_filename, "invalid number" );
+				return result;
+			}
+			switch( type ) {
+			case ply_type::int8:
+				return load< std::int8_t >();
+			case ply_type::uint8:
+				return load< std::uint8_t >();
+			case ply_type::int16:
+				return load< std::int16_t >();
+			case ply_type::uint16:
+				return load< std::uint16_t >();
+			case ply_type::int32:
+				return load< std::int32_t >();
+			case ply_type::uint32:
+				return load< std::uint32_t >();
+			case ply_type::float32:
+				return load< float >();
+			default:
+				return load< double >();
+			}
+		}
+		void skip( ply_property const& property ) {
+			if( property.list ) {
+				const auto count = static_cast< std::size_t >( read( property.count_type ) );
+				for( std::size_t i = 0; i < count; ++i )
+					read( property.type );
+			} else {
+				read( property.type );
+			}
+		}
+	};
+
+	// the vertices of binary files without lists in them have a fixed size, so they can be
+	// decoded in parallel
+	void read_ply_vertices( mesh& m, ply_element const& element, ply_reader& reader, ply_format format, char const* end, std::string const& filename, thread_pool& pool ) {
+		std::size_t xyz[ 3 ];
+		for( std::size_t axis = 0; axis < 3; ++axis ) {
+			const char name[ 2 ] = { static_cast< char >( 'x' + axis ), '\0' };
+			const auto iter = std::find_if( element.properties.begin(), element.properties.end(), [ & ]( ply_property const& p ) { return p.name == name; } );
+			if( iter == element.properties.end() || iter->list )
+				throw mesh_error( filename, std::string{ "vertices have no " } + name + " property" );
+			xyz[ axis ] = static_cast< std::size_t >( iter - element.properties.begin() );
+		}
+		m.vertices.resize( element.count );
+
+		const bool fixed = format != ply_format::ascii && std::none_of( element.properties.begin(), element.properties.end(), []( ply_property const& p ) { return p.list; } );
+		if( !fixed ) {
+			double values[ 3 ] = {};
+			for( auto& v : m.vertices ) {
+				for( std::size_t i = 0; i < element.properties.size(); ++i ) {
+					ply_property const& property = element.properties[ i ];
+					if( i == xyz[ 0 ] || i == xyz[ 1 ] || i == xyz[ 2 ] )
+						values[ i == xyz[ 0 ] ? 0 : ( i == xyz[ 1 ] ? 1 : 2 ) ] = reader.read( property.type );
+					else
+						reader.skip( property );
+				}
+				v = { static_cast< float >( values[ 0 ] ), static_cast< float >( values[ 1 ] ), static_cast< float >( values[ 2 ] ) };
+			}
+			return;
+		}
+
+		std::size_t stride = 0;
+		for( auto const& property : element.properties )
+			stride += size_of( property.type );
+		char const* const begin = reader.position();
+		if( static_cast< std::size_t >( end - begin ) / stride < element.count )
+			throw mesh_error( filename, "unexpected end of file" );
+		const std::size_t chunks = chunk_count( stride * element.count, pool );
+		pool.parallel_for( chunks, [ & ]( std::size_t chunk ) {
+			const std::size_t first = element.count * chunk / chunks;
+			const std::size_t last = element.count * ( chunk + 1 ) / chunks;
+			ply_reader local{ begin + first * stride, end, format, filename };
+			double values[ 3 ] = {};
+			for( std::size_t v = first; v < last; ++v ) {
+				for( std::size_t i = 0; i < element.properties.size(); ++i ) {
+					const double value = local.read( element.properties[ i ].type );
+					for( std::size_t axis = 0; axis < 3; ++axis )
+						if( i == xyz[ axis ] )
+							values[ axis ] = value;
+				}
+				m.vertices[ v ] = { static_cast< float >( values[ 0 ] ), static_cast< float >( values[ 1 ] ), static_cast< float >( values[ 2 ] ) };
+			}
+		} );
+		reader.seek( begin + stride * element.count );
+	}
+
+	void read_ply_faces( mesh& m, ply_element const& element, ply_reader& reader, std::string const& filename ) {
+		const auto indices = std::find_if( element.properties.begin(), element.properties.end(), []( ply_property const& p ) {
+			return p.list && ( p.name == "vertex_indices" || p.name == "vertex_index" );
+		} );
+		if( indices == element.properties.end() )
+			throw mesh_error( filename, "faces have no vertex_indices property" );
+		m.indices.reserve( element.count * 3 );
+		std::vector< std::uint32_t > face;
+		for( std::size_t f = 0; f < element.count; ++f ) {
+			for( auto const& property : element.properties ) {
+				if( &property != &*indices ) {
+					reader.skip( property );
+					continue;
+				}
+				const auto count = static_cast< std::size_t >( reader.read( property.count_type ) );
+				face.clear();
+				for( std::size_t i = 0; i < count; ++i ) {
+					const double index = reader.read( property.type );
+					if( index < 0.0 || index >= static_cast< double >( m.vertices.size() ) )
+						throw mesh_error( filename, "face references a missing vertex" );
+					face.push_back( static_cast< std::uint32_t >( index ) );
+				}
+				if( count < 3 )
+					throw mesh_error( filename, "faces need at least three vertices" );
+				for( std::size_t i = 1; i + 1 < count; ++i )
+					m.indices.insert( m.indices.end(), { face[ 0 ], face[ i ], face[ i + 1 ] } );
+			}
+		}
+	}
+
+	void load_ply( mesh& m, mapped_file const& file, std::string const& filename, thread_pool& pool ) {
+		char const* p = file.data();
+		char const* const end = p + file.size();
+		const auto next_line = [ & ] {
+			char const* line_end = std::find( p, end, '\n' );
+			if( line_end == end )
+				throw mesh_error( filename, "unexpected end of header" );
+			std::string result{ p, line_end };
+			if( !result.empty() && result.back() == '\r' )
+				result.pop_back();
+			p = line_end + 1;
+			return result;
+		};
+		const auto words = []( std::string const& line ) {
+			std::vector< std::string > result;
+			for( std::size_t i = 0; i < line.size(); ) {
+				while( i < line.size() && std::isspace( static_cast< unsigned char >( line[ i ] ) ) )
+					++i;
+				const std::size_t start = i;
+				while( i < line.size() && !std::isspace( static_cast< unsigned char >( line[ i ] ) ) )
+					++i;
+				if( i != start )
+					result.emplace_back( line, start, i - start );
+			}
+			return result;
+		};
+
+		if( next_line() != "ply" )
+			throw mesh_error( filename, "not a PLY file" );
+		ply_format format = ply_format::ascii;
+		std::vector< ply_element > elements;
+		while( true ) {
+			const std::vector< std::string > line = words( next_line() );
+			if( line.empty() || line[ 0 ] == "comment" || line[ 0 ] == "obj_info" )
+				continue;
+			if( line[ 0 ] == "end_header" )
+				break;
+			if( line[ 0 ] == "format" && line.size() >= 2 ) {
+				if( line[ 1 ] == "ascii" )
+					format = ply_format::ascii;
+				else if( line[ 1 ] == "binary_little_endian" )
+					format = ply_format::little_endian;
+				else if( line[ 1 ] == "binary_big_endian" )
+					format = ply_format::big_endian;
+				else
+					throw mesh_error( filename, "unknown format " + line[ 1 ] );
+			} else if( line[ 0 ] == "element" && line.size() == 3 ) {
+				ply_element element;
+				element.name = line[ 1 ];
+				element.count = static_cast< std::size_t >( std::stoull( line[ 2 ] ) );
+				elements.push_back( element );
+			} else if( line[ 0 ] == "property" && !elements.empty() ) {
+				ply_property property;
+				bool valid;
+				if( line.size() == 5 && line[ 1 ] == "list" ) {
+					property.list = true;
+					valid = parse_type( line[ 2 ], property.count_type ) && parse_type( line[ 3 ], property.type );
+				} else {
+					valid = line.size() == 3 && parse_type( line[ 1 ], property.type );
+				}
+				if( !valid )
+					throw mesh_error( filename, "invalid property" );
+				property.name = line.back();
+				elements.back().properties.push_back( property );
+			} else {
+				throw mesh_error( filename, "invalid header" );
+			}
+		}
+
+		ply_reader reader{ p, end, format, filename };
+		bool vertices = false;
+		for( auto const& element : elements ) {
+			if( element.name == "vertex" ) {
+				read_ply_vertices( m, element, reader, format, end, filename, pool );
+				vertices = true;
+			} else if( element.name == "face" ) {
+				if( !vertices )
+					throw mesh_error( filename, "faces have to follow the vertices" );
+				read_ply_faces( m, element, reader, filename );
+			} else {
+				for( std::size_t i = 0; i < element.count; ++i )
+					for( auto const& property : element.properties )
+						reader.skip( property );
+			}
+		}
+	}
+
+	bool has_extension( std::string const& filename, char const* extension ) {
+		const std::size_t length = std::strlen( extension );
+		if( filename.size() < length )
+			return false;
+		return std::equal( extension, extension + length, filename.end() - static_cast< std::ptrdiff_t >( length ), []( char a, char b ) {
+			return a == std::tolower( static_cast< unsigned char >( b ) );
+		} );
+	}
+	bool is_absolute( std::string const& path ) {
+		return ( !path.empty() && ( path[ 0 ] == '/' || path[ 0 ] == '\\' ) ) || ( path.size() >= 2 && path[ 1 ] == ':' );
+	}
+}
+
+void glossy::load_mesh( mesh& m, std::string const& filename, thread_pool& pool ) {
+	const mapped_file file{ filename };
+	m.vertices.clear();
+	m.indices.clear();
+	if( file.size() == 0 )
+		throw mesh_error( filename, "empty file" );
+	if( has_extension( filename, ".obj" ) )
+		load_obj( m, file, filename, pool );
+	else if( has_extension( filename, ".ply" ) )
+		load_ply( m, file, filename, pool );
+	else
+		throw std::runtime_error{ "unsupported mesh format (only .obj and .ply): " + filename };
+	if( m.indices.empty() )
+		throw mesh_error( filename, "no triangles" );
+}
+
+void glossy::load_meshes( scene& s, std::string const& directory ) {
+	if( s.meshes.empty() )
+		return;
+	thread_pool pool;
+	for( auto& m : s.meshes )
+		load_mesh( m, is_absolute( m.file ) ? m.file : directory + m.file, pool );
+}
+
+std::string glossy::directory_of( std::string const& path ) {
+	const auto separator = path.find_last_of( "/\\" );
+	return separator == path.npos ? std::string{} : path.substr( 0, separator + 1 );
+}
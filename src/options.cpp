@@ -0,0 +1,142 @@
+#include <glossy/options.hpp>
+#include <glossy/default_scene.hpp>
+#include <glossy/json2glsl.hpp>
+#include <glossy/binary_scene.hpp>
+#include <string>
+#include <stdexcept>
+#include <limits>
+#include <cstdlib>
+#include <cerrno>
+
+char const* const glossy::usage =
+	"usage: Glossy [options] [scene.json | scene.glsb]\n"
+	"\n"
+	"options:\n"
+	"  --help             print this message and exit\n"
+	"  --size WxH         resolution in pixels (default: 2/3 of the desktop)\n"
+	"  --data-driven      keep objects in textures instead of compiling them into the shader\n"
+	"  --watch            reload the scene file when it changes (implies --data-driven)\n"
+	"  --light-samples N  trace N shadow rays per hit towards lights picked by their power\n"
+	"  --no-shader-cache  always compile the shader instead of loading a cached program binary\n"
+	"  --progressive      accumulate one sample per pixel and frame while the view does not change\n"
+	"  --temporal         like --progressive, but reuse the samples when the camera moves\n"
+	"  --hybrid           rasterize the first hits and only trace from there (implies --data-driven)\n"
+	"  --target-fps N     scale the render resolution down to keep N frames per second\n"
+	"  --stats            show frame timings over the image (toggle with F3)\n"
+	"  --stats-log FILE   write the timings of every frame to FILE (.csv, or .jsonl for JSON lines)\n"
+	"  --headless         render offscreen and print frame timings instead of opening a window\n"
+	"  --frames N         number of frames to render in headless mode (default: 100)\n"
+	"  --out FILE         save the last headless frame to FILE\n"
+	"  --sequence FILE    save every headless frame, numbered where FILE has #s (e.g. frame####.png)\n"
+	"  --fps N            frames per second of scene time in headless mode (default: 60)\n"
+	"  --cpu              render headless on the CPU instead of the GPU\n"
+	"  --threads N        number of CPU render threads (default: one per hardware thread)\n";
+
+namespace {
+	unsigned parse_unsigned( std::string const& option, char const* value ) {
+		char* end;
+		errno = 0;
+		const unsigned long result = std::strtoul( value, &end, 10 );
+		if( end == value || *end != '\0' || errno == ERANGE || result == 0 || result > std::numeric_limits< unsigned >::max() )
+			throw std::runtime_error{ option + " expects a positive integer, got " + value };
+		return static_cast< unsigned >( result );
+	}
+}
+
+glossy::options glossy::parse_options( int argc, char** argv ) {
+	options result;
+	for( int i = 1; i < argc; ++i ) {
+		const std::string arg = argv[ i ];
+		const auto value = [ & ]() -> char const* {
+			if( i + 1 >= argc )
+				throw std::runtime_error{ "missing value for " + arg };
+			return argv[ ++i ];
+		};
+
+		if( arg == "--help" || arg == "-h" ) {
+			result.help = true;
+		} else if( arg == "--size" ) {
+			const std::string size = value();
+			const auto x = size.find( 'x' );
+			if( x == size.npos )
+				throw std::runtime_error{ "--size expects WxH, got " + size };
+			result.width = parse_unsigned( arg, size.substr( 0, x ).c_str() );
+			result.height = parse_unsigned( arg, size.substr( x + 1 ).c_str() );
+		} else if( arg == "--data-driven" ) {
+			result.data_driven = true;
+		} else if( arg == "--watch" ) {
+			result.watch = true;
+		} else if( arg == "--light-samples" ) {
+			result.light_samples = parse_unsigned( arg, value() );
+		} else if( arg == "--no-shader-cache" ) {
+			result.shader_cache = false;
+		} else if( arg == "--progressive" ) {
+			result.progressive = true;
+		} else if( arg == "--temporal" ) {
+			result.temporal = true;
+		} else if( arg == "--hybrid" ) {
+			result.hybrid = true;
+		} else if( arg == "--target-fps" ) {
+			result.target_fps = parse_unsigned( arg, value() );
+		} else if( arg == "--stats" ) {
+			result.stats = true;
+		} else if( arg == "--stats-log" ) {
+			result.stats_log = value();
+		} else if( arg == "--headless" ) {
+			result.headless = true;
+		} else if( arg == "--frames" ) {
+			result.frames = parse_unsigned( arg, value() );
+		} else if( arg == "--out" ) {
+			result.out = value();
+		} else if( arg == "--sequence" ) {
+			result.sequence = value();
+			result.headless = true;
+			if( result.sequence.find( '#' ) == std::string::npos )
+				throw std::runtime_error{ "--sequence expects a file name with # for the frame number, got " + result.sequence };
+		} else if( arg == "--fps" ) {
+			result.fps = parse_unsigned( arg, value() );
+		} else if( arg == "--cpu" ) {
+			result.cpu = true;
+			result.headless = true;
+		} else if( arg == "--threads" ) {
+			result.threads = parse_unsigned( arg, value() );
+		} else if( arg.size() > 1 && arg[ 0 ] == '-' ) {
+			throw std::runtime_error{ "unrecognized program option: " + arg };
+		} else {
+			if( !result.scene.empty() )
+				throw std::runtime_error{ "too many scene files provided" };
+			result.scene = arg;
+		}
+	}
+	if( result.watch && result.scene.empty() )
+		throw std::runtime_error{ "--watch needs a scene file" };
+	if( result.progressive && result.temporal )
+		throw std::runtime_error{ "--progressive and --temporal exclude each other" };
+	return result;
+}
+
+glossy::scene glossy::load_scene( options const& opts ) {
+	scene result;
+	if( is_binary_scene( opts.scene ) ) {
+		result = binary2scene( opts.scene );
+	} else if( !opts.scene.empty() ) {
+		result = json2scene( opts.scene );
+	} else {
+		// the default scene is a global stream; rewind it so that it can be loaded more than once
+		default_scene.clear();
+		default_scene.seekg( 0 );
+		result = json2scene( default_scene );
+	}
+	if( opts.data_driven || opts.watch || opts.hybrid )
+		result.data_driven = true;
+	if( opts.light_samples != 0 )
+		result.light_samples = opts.light_samples;
+	return result;
+}
+glossy::shader_options glossy::get_shader_options( options const& opts ) {
+	shader_options result;
+	result.progressive = opts.progressive;
+	result.hybrid = opts.hybrid;
+	result.temporal = opts.temporal;
+	return result;
+}
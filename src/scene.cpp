@@ -0,0 +1,44 @@
+#include <glossy/scene.hpp>
+#include <stdexcept>
+#include <string>
+
+bool glossy::scene::adaptive() const {
+	return SS_min != 0 && SS_min < SS;
+}
+glossy::scene glossy::scene::preview() const {
+	scene result = *this;
+	result.data_driven = true;
+	result.SS = 1;
+	result.SS_min = 0;
+	result.recursion = 0;
+	result.denoise.iterations = 0;
+	return result;
+}
+void glossy::scene::validate() const {
+	if( SS == 0 )
+		throw std::range_error{ "SS must be positive" };
+	if( SS_min > SS )
+		throw std::range_error{ "SS_min must not exceed SS" };
+	if( adaptive_threshold <= 0.0 )
+		throw std::range_error{ "adaptive_threshold must be positive" };
+	if( fovy <= 0.0 || fovy >= 180.0 )
+		throw std::range_error{ "fovy must be in (0, 180)" };
+	if( background.x < 0.0 || background.x > 1.0 )
+		throw std::range_error{ "background.r must be in [0, 1]" };
+	if( background.y < 0.0 || background.y > 1.0 )
+		throw std::range_error{ "background.g must be in [0, 1]" };
+	if( background.z < 0.0 || background.z > 1.0 )
+		throw std::range_error{ "background.b must be in [0, 1]" };
+	if( rendering_distance <= 0.0 )
+		throw std::range_error{ "rendering_distance must be positive" };
+	if( denoise.iterations > denoise_settings::max_iterations )
+		throw std::range_error{ "denoise.iterations must not exceed " + std::to_string( denoise_settings::max_iterations ) };
+	if( denoise.sigma_color <= 0.0 )
+		throw std::range_error{ "denoise.sigma_color must be positive" };
+	if( denoise.sigma_normal <= 0.0 )
+		throw std::range_error{ "denoise.sigma_normal must be positive" };
+	if( denoise.sigma_depth <= 0.0 )
+		throw std::range_error{ "denoise.sigma_depth must be positive" };
+	if( denoise.sigma_albedo <= 0.0 )
+		throw std::range_error{ "denoise.sigma_albedo must be positive" };
+}
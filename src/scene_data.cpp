@@ -0,0 +1,292 @@
+#include <glossy/scene_data.hpp>
+#include <glossy/bvh.hpp>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	using namespace glossy;
+
+	void pack_nodes( bvh const& hierarchy, std::vector< float >& result ) {
+		result.reserve( hierarchy.nodes.size() * 8 );
+		for( auto const& n : hierarchy.nodes ) {
+			result.insert( result.end(), {
+				n.bounds.min.x, n.bounds.min.y, n.bounds.min.z, static_cast< float >( n.first ),
+				n.bounds.max.x, n.bounds.max.y, n.bounds.max.z, static_cast< float >( n.count )
+			} );
+		}
+	}
+
+	// Vose's alias method: every light keeps its own slot with some probability and hands the rest
+	// to an alias, so that picking a slot uniformly and then one of its two lights samples a light
+	// in proportion to its power with a single texel fetch
+	void pack_light_alias( std::vector< float > const& powers, std::vector< float >& result ) {
+		const std::size_t n = powers.size();
+		const float total = std::accumulate( powers.begin(), powers.end(), 0.0f );
+		std::vector< float > pdf( n );
+		for( std::size_t i = 0; i < n; ++i )
+			pdf[ i ] = total > 0.0f ? powers[ i ] / total : 1.0f / n;
+
+		std::vector< float > keep( n, 1.0f );
+		std::vector< std::uint32_t > alias( n );
+		std::iota( alias.begin(), alias.end(), 0u );
+		std::vector< float > scaled( n );
+		std::vector< std::uint32_t > small, large;
+		for( std::size_t i = 0; i < n; ++i ) {
+			scaled[ i ] = pdf[ i ] * n;
+			( scaled[ i ] < 1.0f ? small : large ).push_back( static_cast< std::uint32_t >( i ) );
+		}
+		while( !small.empty() && !large.empty() ) {
+			const std::uint32_t s = small.back();
+			small.pop_back();
+			const std::uint32_t l = large.back();
+			keep[ s ] = scaled[ s ];
+			alias[ s ] = l;
+			scaled[ l ] -= 1.0f - scaled[ s ];
+			if( scaled[ l ] < 1.0f ) {
+				large.pop_back();
+				small.push_back( l );
+			}
+		}
+		// whatever is left is 1 up to rounding and keeps its slot
+
+		result.reserve( n * 4 );
+		for( std::size_t i = 0; i < n; ++i )
+			result.insert( result.end(), { keep[ i ], static_cast< float >( alias[ i ] ), pdf[ i ], pdf[ alias[ i ] ] } );
+	}
+
+	void pack_meshes( std::vector< mesh > const& meshes, scene_data& result ) {
+		std::size_t vertex_count = 0;
+		std::size_t triangle_count = 0;
+		for( auto const& m : meshes ) {
+			vertex_count += m.vertices.size();
+			triangle_count += m.indices.size() / 3;
+		}
+		if( vertex_count > max_mesh_vertices || triangle_count > max_mesh_vertices )
+			throw std::runtime_error{ "meshes may have at most " + std::to_string( max_mesh_vertices ) + " vertices and triangles in total" };
+
+		// one triangle after the other, to be reordered by the BVH
+		struct triangle {
+			std::uint32_t v[ 3 ];
+			std::uint32_t mesh;
+		};
+		std::vector< triangle > triangles;
+		triangles.reserve( triangle_count );
+		std::vector< aabb > boxes;
+		boxes.reserve( triangle_count );
+		std::vector< vec3 > world;
+		result.mesh_vertices.reserve( vertex_count * 4 );
+		result.meshes.reserve( meshes.size() * 8 );
+		for( std::uint32_t i = 0; i < meshes.size(); ++i ) {
+			mesh const& m = meshes[ i ];
+			const auto first = static_cast< std::uint32_t >( result.mesh_vertices.size() / 4 );
+			world.clear();
+			for( auto const& v : m.vertices ) {
+				world.push_back( v * m.scale + m.position );
+				result.mesh_vertices.insert( result.mesh_vertices.end(), { world.back().x, world.back().y, world.back().z, 0.0f } );
+			}
+			for( std::size_t j = 0; j + 2 < m.indices.size(); j += 3 ) {
+				triangles.push_back( { { first + m.indices[ j ], first + m.indices[ j + 1 ], first + m.indices[ j + 2 ] }, i } );
+				aabb box;
+				for( std::size_t k = 0; k < 3; ++k )
+					box.grow( world[ m.indices[ j + k ] ] );
+				boxes.push_back( box );
+			}
+			result.meshes.insert( result.meshes.end(), {
+				m.position.x, m.position.y, m.position.z, 0.0f,
+				m.mat.color.x, m.mat.color.y, m.mat.color.z, static_cast< float >( m.mat.type() )
+			} );
+		}
+
+		const bvh hierarchy = build_bvh( boxes );
+		pack_nodes( hierarchy, result.mesh_bvh );
+		result.mesh_triangles.reserve( triangles.size() * 4 );
+		for( auto i : hierarchy.indices ) {
+			triangle const& t = triangles[ i ];
+			result.mesh_triangles.insert( result.mesh_triangles.end(), {
+				static_cast< float >( t.v[ 0 ] ), static_cast< float >( t.v[ 1 ] ), static_cast< float >( t.v[ 2 ] ), static_cast< float >( t.mesh )
+			} );
+		}
+	}
+}
+
+glossy::data_layout glossy::layout( scene const& s ) {
+	data_layout result;
+	// outside of the data driven mode, the traversal needs at least a root and thus a sphere
+	result.bvh = s.bvh && ( s.data_driven || !s.spheres.empty() );
+	result.spheres = s.data_driven || result.bvh;
+	result.tiles = result.spheres && !result.bvh;
+	result.planes = s.data_driven;
+	result.meshes = !s.meshes.empty();
+	result.view = s.data_driven;
+	if( s.data_driven ) {
+		result.materials = ( 1u << material::type_count ) - 1u;
+	} else {
+		for( auto const& sph : s.spheres )
+			result.materials |= 1u << sph.mat.type();
+		for( auto const& pl : s.planes )
+			result.materials |= 1u << pl.mat.type();
+		for( auto const& m : s.meshes )
+			result.materials |= 1u << m.mat.type();
+	}
+	for( unsigned type = 0; type < material::type_count; ++type ) {
+		if( result.materials & ( 1u << type ) ) {
+			result.lit = result.lit || ( type & material::diffuse_bit );
+			result.reflective = result.reflective || ( type & material::specular_bit );
+		}
+	}
+	result.lights = result.lit && ( s.data_driven || s.light_samples != 0 );
+	result.light_alias = result.lit && s.light_samples != 0;
+	return result;
+}
+
+glossy::scene_data glossy::pack( scene const& s ) {
+	const data_layout what = layout( s );
+	scene_data result;
+
+	if( what.spheres ) {
+		std::vector< sphere > const& spheres = s.spheres;
+		std::vector< std::uint32_t > order( spheres.size() );
+		std::iota( order.begin(), order.end(), 0u );
+		if( what.bvh ) {
+			std::vector< aabb > boxes;
+			boxes.reserve( spheres.size() );
+			for( auto const& sph : spheres ) {
+				const vec3 extent{ sph.radius, sph.radius, sph.radius };
+				aabb box;
+				box.grow( sph.position - extent );
+				box.grow( sph.position + extent );
+				boxes.push_back( box );
+			}
+			const bvh hierarchy = build_bvh( boxes );
+			order = hierarchy.indices;
+			pack_nodes( hierarchy, result.bvh_nodes );
+		}
+
+		result.spheres.reserve( spheres.size() * 8 );
+		for( auto i : order ) {
+			sphere const& sph = spheres[ i ];
+			result.spheres.insert( result.spheres.end(), {
+				sph.position.x, sph.position.y, sph.position.z, sph.radius,
+				sph.mat.color.x, sph.mat.color.y, sph.mat.color.z, static_cast< float >( sph.mat.type() )
+			} );
+		}
+	}
+
+	if( what.planes ) {
+		result.planes.reserve( s.planes.size() * 12 );
+		for( auto const& pl : s.planes ) {
+			// normalized here rather than for every hit
+			const vec3 n = pl.normal / norm( pl.normal );
+			result.planes.insert( result.planes.end(), {
+				pl.position.x, pl.position.y, pl.position.z, 0.0f,
+				n.x, n.y, n.z, 0.0f,
+				pl.mat.color.x, pl.mat.color.y, pl.mat.color.z, static_cast< float >( pl.mat.type() )
+			} );
+		}
+	}
+
+	if( what.lights ) {
+		std::vector< float > powers;
+		for( auto const& l : s.lights ) {
+			if( !l.is_static() )
+				continue;
+			const vec3 p = l.static_position();
+			result.lights.insert( result.lights.end(), {
+				p.x, p.y, p.z, 0.0f,
+				l.color.x, l.color.y, l.color.z, 0.0f
+			} );
+			powers.push_back( 0.2126f * l.color.x + 0.7152f * l.color.y + 0.0722f * l.color.z );
+		}
+		if( what.light_alias )
+			pack_light_alias( powers, result.light_alias );
+	}
+	if( what.meshes )
+		pack_meshes( s.meshes, result );
+	return result;
+}
+
+void glossy::bin_spheres( std::vector< float > const& sphere_data, view const& v, tile_lists& result ) {
+	result.columns = ( v.width + tile_size - 1 ) / tile_size;
+	result.rows = ( v.height + tile_size - 1 ) / tile_size;
+	const std::size_t tile_count = std::size_t{ result.columns } * result.rows;
+	const std::size_t sphere_count = sphere_data.size() / 8;
+	if( tile_count == 0 ) {
+		result.tiles.clear();
+		result.spheres.clear();
+		return;
+	}
+
+	// the rectangle of tiles of every sphere, empty if it has none, and the number of spheres per tile
+	struct rect {
+		unsigned x0, y0, x1, y1; // inclusive
+	};
+	std::vector< rect > rects( sphere_count, rect{ 1, 1, 0, 0 } );
+	std::vector< std::uint32_t > counts( tile_count + 1, 0 );
+	// normalized screen coordinates as in calc, to pixels
+	const float scale = v.height / ( 2.0f * v.fovh );
+	const float center_x = v.width / 2.0f;
+	const float center_y = v.height / 2.0f;
+	// the range of x / z over a circle around ( x, z ) with radius r in front of the camera,
+	// bounded by the tangents through the origin
+	const auto project = []( float x, float z, float r, float& lo, float& hi ) {
+		const float l = std::sqrt( x * x + z * z - r * r );
+		const float denom = z * z - r * r;
+		lo = ( x * z - r * l ) / denom;
+		hi = ( x * z + r * l ) / denom;
+	};
+	// pixels to tiles; the samples of a pixel are spread over it, so one pixel of slack is added
+	const auto tiles = []( float lo, float hi, unsigned pixels, unsigned& first, unsigned& last ) {
+		if( hi + 1.0f < 0.0f || lo - 1.0f >= static_cast< float >( pixels ) )
+			return false;
+		first = static_cast< unsigned >( std::max( lo - 1.0f, 0.0f ) ) / tile_size;
+		last = static_cast< unsigned >( std::min( hi + 1.0f, pixels - 1.0f ) ) / tile_size;
+		return true;
+	};
+	for( std::size_t i = 0; i < sphere_count; ++i ) {
+		const vec3 c{ sphere_data[ 8 * i ], sphere_data[ 8 * i + 1 ], sphere_data[ 8 * i + 2 ] };
+		const float r = sphere_data[ 8 * i + 3 ];
+		const vec3 d = c - v.position;
+		const float x = dot( d, v.right );
+		const float y = dot( d, v.up );
+		const float z = dot( d, v.at );
+		// primary rays point away from the camera and do not hit anything beyond the rendering distance
+		if( z + r <= 0.0f || norm( d ) - r > v.rendering_distance )
+			continue;
+		rect& box = rects[ i ];
+		if( z - r <= 1.0e-4f ) {
+			// around the camera, where it may cover anything
+			box = { 0, 0, result.columns - 1, result.rows - 1 };
+		} else {
+			float x_lo, x_hi, y_lo, y_hi;
+			project( x, z, r, x_lo, x_hi );
+			project( y, z, r, y_lo, y_hi );
+			if( !tiles( x_lo * scale + center_x, x_hi * scale + center_x, v.width, box.x0, box.x1 ) ||
+				!tiles( y_lo * scale + center_y, y_hi * scale + center_y, v.height, box.y0, box.y1 ) ) {
+				box = rect{ 1, 1, 0, 0 };
+				continue;
+			}
+		}
+		for( unsigned ty = box.y0; ty <= box.y1; ++ty )
+			for( unsigned tx = box.x0; tx <= box.x1; ++tx )
+				++counts[ ty * result.columns + tx + 1 ];
+	}
+
+	// a counting sort by tile, which keeps the spheres of a tile in the order of sphere_data
+	std::partial_sum( counts.begin(), counts.end(), counts.begin() );
+	result.tiles.assign( tile_count * 4, 0.0f );
+	for( std::size_t t = 0; t < tile_count; ++t ) {
+		result.tiles[ 4 * t ] = static_cast< float >( counts[ t ] );
+		result.tiles[ 4 * t + 1 ] = static_cast< float >( counts[ t + 1 ] - counts[ t ] );
+	}
+	result.spheres.assign( ( counts[ tile_count ] + 3 ) / 4 * 4, 0.0f );
+	for( std::size_t i = 0; i < sphere_count; ++i ) {
+		rect const& box = rects[ i ];
+		for( unsigned ty = box.y0; ty <= box.y1; ++ty )
+			for( unsigned tx = box.x0; tx <= box.x1; ++tx )
+				result.spheres[ counts[ ty * result.columns + tx ]++ ] = static_cast< float >( i );
+	}
+}
@@ -0,0 +1,92 @@
+#include <glossy/scene_generator.hpp>
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+namespace {
+	// std::uniform_real_distribution differs between standard libraries, std::mt19937 does not
+	class random_source {
+		std::mt19937 m_engine;
+
+	public:
+		explicit random_source( std::uint32_t seed )
+			: m_engine{ seed } {
+		}
+
+		// in [0, 1)
+		float unit() {
+			return static_cast< float >( m_engine() >> 8 ) / 16777216.0f;
+		}
+		float range( float lo, float hi ) {
+			return lo + unit() * ( hi - lo );
+		}
+	};
+
+	// C++14 leaves the order of the operands of << open, so numbers are drawn before printing
+	struct vec {
+		float x, y, z;
+	};
+	std::ostream& operator<<( std::ostream& stream, vec const& v ) {
+		return stream << "[ " << v.x << ", " << v.y << ", " << v.z << " ]";
+	}
+	vec draw( random_source& rng, float lo, float hi ) {
+		const float x = rng.range( lo, hi );
+		const float y = rng.range( lo, hi );
+		const float z = rng.range( lo, hi );
+		return { x, y, z };
+	}
+}
+
+void glossy::generate_scene( std::ostream& stream, generator_settings const& settings ) {
+	random_source rng{ settings.seed };
+	// about one sphere per two square units
+	const float extent = std::max( 5.0f, std::sqrt( static_cast< float >( settings.spheres ) * 2.0f ) / 2.0f );
+
+	const auto flags = stream.flags();
+	const auto precision = stream.precision();
+	// floats have to be written as floats even when they are whole
+	stream.setf( std::ios::fixed, std::ios::floatfield );
+	stream.precision( 3 );
+
+	stream << "{\n"
+			  "\t\"SS\": " << settings.SS << ",\n"
+			  "\t\"recursion\": " << settings.recursion << ",\n"
+			  "\t\"lights\": [";
+	const char* separator = "\n";
+	for( std::size_t i = 0; i < settings.lights; ++i ) {
+		vec position;
+		position.x = rng.range( -extent, extent );
+		position.y = rng.range( 10.0f, 20.0f );
+		position.z = rng.range( 0.0f, 2.0f * extent );
+		// the lights share the power of a single one
+		const float power = 100.0f / settings.lights;
+		const vec color = draw( rng, 0.5f * power, power );
+		stream << separator << "\t\t{ \"position\": " << position << ", \"color\": " << color << " }";
+		separator = ",\n";
+	}
+	for( std::size_t i = 0; i < settings.animated_lights; ++i ) {
+		const float phase = rng.range( 0.0f, 6.283f );
+		const float height = rng.range( 10.0f, 20.0f );
+		stream << separator << "\t\t{ \"position\": [ \"sin( global_time + " << phase << " ) * " << extent
+			   << "\", " << height << ", \"" << extent << " + cos( global_time + " << phase << " ) * " << extent << "\" ] }";
+		separator = ",\n";
+	}
+	stream << "\n\t],\n"
+			  "\t\"objects\": [\n"
+			  "\t\t{ \"shape\": \"plane\", \"material\": { \"checkered\": true } }";
+	for( std::size_t i = 0; i < settings.spheres; ++i ) {
+		const float radius = rng.range( 0.1f, 0.6f );
+		vec position;
+		position.x = rng.range( -extent, extent );
+		position.y = radius + rng.range( 0.0f, 2.0f );
+		position.z = rng.range( 2.0f, 2.0f + 2.0f * extent );
+		const vec color = draw( rng, 0.0f, 1.0f );
+		const bool specular = rng.unit() < 0.5f;
+		stream << ",\n\t\t{ \"shape\": \"sphere\", \"position\": " << position << ", \"radius\": " << radius
+			   << ", \"material\": { \"color\": " << color << ", \"specular\": " << ( specular ? "true" : "false" ) << " } }";
+	}
+	stream << "\n\t]\n}\n";
+
+	stream.flags( flags );
+	stream.precision( precision );
+}
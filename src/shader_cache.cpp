@@ -0,0 +1,132 @@
+#include <glossy/shader_cache.hpp>
+#include <glossy/gl.hpp>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#if defined( _WIN32 ) || defined( WIN32 )
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+namespace {
+	// loading a binary needs a program object, which sf::Shader only creates by compiling something
+	char const* const placeholder = "void main() {\n\tgl_FragColor = vec4( 0.0 );\n}\n";
+
+	constexpr char magic[ 8 ] = { 'g', 'l', 'o', 's', 's', 'y', 'p', '1' };
+	struct header {
+		char magic[ 8 ];
+		std::uint64_t hash;
+		std::uint32_t format;
+		std::uint32_t length;
+	};
+
+	// FNV-1a, which unlike std::hash is the same in every build
+	std::uint64_t hash( std::string const& data, std::uint64_t seed = 14695981039346656037ull ) {
+		for( unsigned char c : data ) {
+			seed ^= c;
+			seed *= 1099511628211ull;
+		}
+		return seed;
+	}
+
+	std::string gl_string( GLenum name ) {
+		auto const* result = reinterpret_cast< char const* >( glGetString( name ) );
+		return result ? result : "";
+	}
+	std::uint64_t key( std::string const& code ) {
+		return hash( code, hash( gl_string( GL_VENDOR ) + '\n' + gl_string( GL_RENDERER ) + '\n' + gl_string( GL_VERSION ) + '\n' ) );
+	}
+
+	// creates directory and its parents; failures surface once the cache file cannot be written
+	void make_directories( std::string const& directory ) {
+		for( std::size_t i = 1; i <= directory.size(); ++i ) {
+			if( i != directory.size() && directory[ i ] != '/' )
+				continue;
+			const std::string prefix = directory.substr( 0, i );
+#if defined( _WIN32 ) || defined( WIN32 )
+			_mkdir( prefix.c_str() );
+#else
+			mkdir( prefix.c_str(), 0755 );
+#endif
+		}
+	}
+}
+
+glossy::shader_cache::shader_cache( std::string directory )
+	: m_directory{ std::move( directory ) } {
+	if( !m_directory.empty() )
+		return;
+	if( char const* xdg = std::getenv( "XDG_CACHE_HOME" ) )
+		m_directory = std::string{ xdg } + "/glossy";
+	else if( char const* home = std::getenv( "HOME" ) )
+		m_directory = std::string{ home } + "/.cache/glossy";
+	else if( char const* local = std::getenv( "LOCALAPPDATA" ) )
+		m_directory = std::string{ local } + "/glossy";
+	else
+		m_directory = ".glossy-cache";
+}
+
+std::string glossy::shader_cache::path( std::string const& code ) const {
+	char name[ 17 ];
+	std::snprintf( name, sizeof( name ), "%016llx", static_cast< unsigned long long >( key( code ) ) );
+	return m_directory + '/' + name + ".bin";
+}
+
+bool glossy::shader_cache::load( sf::Shader& shader, std::string const& code ) const {
+	if( !gl::has_program_binary() )
+		return false;
+	std::ifstream file{ path( code ), std::ifstream::binary };
+	header head;
+	if( !file.read( reinterpret_cast< char* >( &head ), sizeof( head ) ) )
+		return false;
+	if( std::memcmp( head.magic, magic, sizeof( magic ) ) != 0 || head.hash != key( code ) )
+		return false;
+	std::vector< char > binary( head.length );
+	if( !file.read( binary.data(), binary.size() ) )
+		return false;
+
+	if( !shader.loadFromMemory( placeholder, sf::Shader::Fragment ) )
+		return false;
+	const GLuint program = shader.getNativeHandle();
+	gl::ProgramBinary( program, head.format, binary.data(), static_cast< GLsizei >( binary.size() ) );
+	// a driver update may reject binaries of its predecessor without changing the version string
+	GLint linked = GL_FALSE;
+	gl::GetProgramiv( program, GL_LINK_STATUS, &linked );
+	return linked == GL_TRUE;
+}
+
+void glossy::shader_cache::store( sf::Shader const& shader, std::string const& code ) const {
+	if( !gl::has_program_binary() )
+		return;
+	const GLuint program = shader.getNativeHandle();
+	GLint length = 0;
+	gl::GetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length );
+	if( length <= 0 )
+		return;
+	std::vector< char > binary( static_cast< std::size_t >( length ) );
+	header head;
+	std::memcpy( head.magic, magic, sizeof( magic ) );
+	head.hash = key( code );
+	GLenum format = 0;
+	gl::GetProgramBinary( program, length, &length, &format, binary.data() );
+	head.format = format;
+	head.length = static_cast< std::uint32_t >( length );
+
+	make_directories( m_directory );
+	// write to a temporary file first so that concurrent instances never read half a binary
+	const std::string target = path( code );
+	const std::string temporary = target + ".tmp";
+	{
+		std::ofstream file{ temporary, std::ofstream::binary | std::ofstream::trunc };
+		file.write( reinterpret_cast< char const* >( &head ), sizeof( head ) );
+		file.write( binary.data(), head.length );
+		if( !file )
+			return;
+	}
+	std::rename( temporary.c_str(), target.c_str() );
+}
@@ -0,0 +1,149 @@
+#include <glossy/stats_overlay.hpp>
+#include <algorithm>
+#include <sstream>
+#include <cctype>
+#include <cstdint>
+
+namespace {
+	using namespace glossy;
+
+	constexpr unsigned glyph_width = 3;
+	constexpr unsigned glyph_height = 5;
+	constexpr float advance = ( glyph_width + 1 ) * stats_overlay::pixel;
+	constexpr float line_height = ( glyph_height + 2 ) * stats_overlay::pixel;
+	constexpr float margin = 4.0f * stats_overlay::pixel;
+	constexpr float graph_height = 50.0f * stats_overlay::pixel;
+
+	// five rows of three bits, the top row and the left column in the most significant bits.
+	// characters without a glyph are left blank.
+	std::uint16_t glyph( char c ) {
+		switch( std::toupper( static_cast< unsigned char >( c ) ) ) {
+		case '0': return 0b111'101'101'101'111;
+		case '1': return 0b010'110'010'010'111;
+		case '2': return 0b111'001'111'100'111;
+		case '3': return 0b111'001'111'001'111;
+		case '4': return 0b101'101'111'001'001;
+		case '5': return 0b111'100'111'001'111;
+		case '6': return 0b111'100'111'101'111;
+		case '7': return 0b111'001'001'001'001;
+		case '8': return 0b111'101'111'101'111;
+		case '9': return 0b111'101'111'001'111;
+		case '.': return 0b000'000'000'000'010;
+		case ':': return 0b000'010'000'010'000;
+		case '/': return 0b001'001'010'100'100;
+		case '-': return 0b000'000'111'000'000;
+		case 'A': return 0b010'101'111'101'101;
+		case 'C': return 0b011'100'100'100'011;
+		case 'D': return 0b110'101'101'101'110;
+		case 'E': return 0b111'100'110'100'111;
+		case 'F': return 0b111'100'110'100'100;
+		case 'G': return 0b011'100'101'101'011;
+		case 'H': return 0b101'101'111'101'101;
+		case 'I': return 0b111'010'010'010'111;
+		case 'L': return 0b100'100'100'100'111;
+		case 'M': return 0b101'111'111'101'101;
+		case 'N': return 0b110'101'101'101'101;
+		case 'P': return 0b110'101'110'100'100;
+		case 'R': return 0b110'101'110'101'101;
+		case 'S': return 0b011'100'010'001'110;
+		case 'T': return 0b111'010'010'010'010;
+		case 'U': return 0b101'101'101'101'111;
+		case 'V': return 0b101'101'101'101'010;
+		case 'W': return 0b101'101'111'111'101;
+		case 'Y': return 0b101'101'010'010'010;
+		default: return 0;
+		}
+	}
+
+	void add_rect( sf::VertexArray& quads, float left, float top, float width, float height, sf::Color color ) {
+		quads.append( { { left, top }, color } );
+		quads.append( { { left + width, top }, color } );
+		quads.append( { { left + width, top + height }, color } );
+		quads.append( { { left, top + height }, color } );
+	}
+
+	std::string format( char const* label, frame_stats const& stats ) {
+		std::ostringstream line;
+		line.setf( std::ios::fixed );
+		line.precision( 2 );
+		line << label << std::string( 8 - std::min< std::size_t >( 8, std::char_traits< char >::length( label ) ), ' ' );
+		if( stats.count == 0 )
+			line << "-";
+		else
+			line << "min " << stats.min << "  avg " << stats.mean << "  p99 " << stats.p99 << " ms";
+		return line.str();
+	}
+}
+
+void glossy::stats_overlay::add_line( std::string const& line ) {
+	const float top = margin + m_text_size.y;
+	float left = margin;
+	for( char c : line ) {
+		const std::uint16_t bits = glyph( c );
+		for( unsigned y = 0; y < glyph_height; ++y ) {
+			for( unsigned x = 0; x < glyph_width; ++x ) {
+				if( bits & ( 1u << ( ( glyph_height - 1 - y ) * glyph_width + ( glyph_width - 1 - x ) ) ) )
+					add_rect( m_text, left + x * pixel, top + y * pixel, pixel, pixel, sf::Color::White );
+			}
+		}
+		left += advance;
+	}
+	m_text_size.x = std::max( m_text_size.x, left - margin );
+	m_text_size.y += line_height;
+}
+
+void glossy::stats_overlay::set_startup( double ms, bool cache_hit ) {
+	std::ostringstream line;
+	line.setf( std::ios::fixed );
+	line.precision( 2 );
+	line << "startup " << ms << " ms  shader cache " << ( cache_hit ? "hit" : "miss" );
+	m_startup = line.str();
+	// shows up with the next draw
+	m_text.clear();
+}
+
+void glossy::stats_overlay::draw( sf::RenderTarget& target, frame_profiler const& profiler ) {
+	if( m_text.getVertexCount() == 0 || m_refresh.elapsed_s_flt() >= 0.5 ) {
+		m_refresh.start();
+		m_text.clear();
+		m_text_size = {};
+		add_line( format( "frame", profiler.cpu_stats() ) );
+		add_line( format( "gpu", profiler.gpu_stats() ) );
+		for( unsigned s = 0; s < frame_profiler::span_count; ++s ) {
+			const auto sp = static_cast< frame_profiler::span >( s );
+			add_line( format( name( sp ), profiler.span_stats( sp ) ) );
+		}
+		if( !m_startup.empty() )
+			add_line( m_startup );
+	}
+
+	// one bar per frame, the frame time in grey with the GPU time in front of it in green
+	const float bar_width = pixel;
+	const float graph_top = margin + m_text_size.y + margin;
+	const float width = std::max( m_text_size.x, frame_profiler::history * bar_width );
+	sf::VertexArray shapes{ sf::Quads };
+	add_rect( shapes, 0.0f, 0.0f, width + 2.0f * margin, graph_top + graph_height + margin, sf::Color{ 0, 0, 0, 160 } );
+	const auto bar = [ & ]( double ms ) {
+		return static_cast< float >( std::min( ms / graph_ms, 1.0 ) ) * graph_height;
+	};
+	float left = margin;
+	for( auto const& f : profiler.frames() ) {
+		const float cpu = bar( f.cpu_ms );
+		add_rect( shapes, left, graph_top + graph_height - cpu, bar_width, cpu, sf::Color{ 160, 160, 160 } );
+		if( f.gpu_ms >= 0.0 ) {
+			const float gpu = bar( f.gpu_ms );
+			add_rect( shapes, left, graph_top + graph_height - gpu, bar_width, gpu, sf::Color{ 64, 200, 64 } );
+		}
+		left += bar_width;
+	}
+	// 60 frames per second
+	const float budget = bar( 1000.0 / 60.0 );
+	add_rect( shapes, margin, graph_top + graph_height - budget, width, 1.0f, sf::Color{ 200, 64, 64 } );
+
+	const sf::Vector2u size = target.getSize();
+	const sf::View view = target.getView();
+	target.setView( sf::View{ { 0, 0, static_cast< float >( size.x ), static_cast< float >( size.y ) } } );
+	target.draw( shapes );
+	target.draw( m_text );
+	target.setView( view );
+}
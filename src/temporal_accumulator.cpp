@@ -0,0 +1,172 @@
+#include <glossy/temporal_accumulator.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+	using namespace glossy;
+
+	// the tracer's data textures live on the units above; they are rebound before it draws
+	enum : unsigned {
+		current_unit = 1,
+		history_unit = 2
+	};
+
+	// while the camera stands still, the history is the texel's own. otherwise, it is sampled
+	// bilinearly where the new sample's first hit was seen before, skipping the texels that saw
+	// a distance more than 5% off the expected one. the samples of history texel i average to
+	// i + 1 in calc's coordinates, as gl_FragCoord is at the texel's center and the jitter
+	// averages one half.
+	char const* const reproject_code =
+		"#version 130\n"
+		"uniform sampler2D current;\n"
+		"uniform sampler2D history;\n"
+		"uniform vec2 resolution;\n"
+		"uniform vec2 jitter;\n"
+		"uniform float fovh;\n"
+		"uniform vec3 pos;\n"
+		"uniform vec3 at;\n"
+		"uniform vec3 up;\n"
+		"uniform vec3 right;\n"
+		"uniform vec3 previous_pos;\n"
+		"uniform vec3 previous_at;\n"
+		"uniform vec3 previous_up;\n"
+		"uniform vec3 previous_right;\n"
+		"uniform float blend;\n"
+		"uniform bool moving;\n"
+		"uniform bool clamp_history;\n"
+		"void main() {\n"
+		"	ivec2 texel = ivec2( gl_FragCoord.xy );\n"
+		"	vec4 c = texelFetch( current, texel, 0 );\n"
+		"	if( blend >= 1.0 ) {\n"
+		"		gl_FragColor = c;\n"
+		"		return;\n"
+		"	}\n"
+		"	vec3 sum = vec3( 0.0 );\n"
+		"	float weights = 0.0;\n"
+		"	if( !moving ) {\n"
+		"		sum = texelFetch( history, texel, 0 ).rgb;\n"
+		"		weights = 1.0;\n"
+		"	} else {\n"
+		"		vec2 normalized = ( gl_FragCoord.xy + jitter - resolution / 2.0 ) * 2.0 / resolution.y * fovh;\n"
+		"		vec3 d = normalize( at + normalized.x * right + normalized.y * up );\n"
+		"		// misses are infinitely far away, so only their direction counts\n"
+		"		bool miss = c.a < 0.0;\n"
+		"		vec3 q = miss ? d : pos + d * c.a - previous_pos;\n"
+		"		float expected = length( q );\n"
+		"		vec3 v = vec3( dot( q, previous_right ), dot( q, previous_up ), dot( q, previous_at ) );\n"
+		"		if( v.z > 0.0 ) {\n"
+		"			vec2 t = v.xy / v.z / fovh * resolution.y / 2.0 + resolution / 2.0 - 1.0;\n"
+		"			ivec2 base = ivec2( floor( t ) );\n"
+		"			vec2 f = t - floor( t );\n"
+		"			for( int y = 0; y < 2; ++y ) {\n"
+		"				for( int x = 0; x < 2; ++x ) {\n"
+		"					ivec2 i = base + ivec2( x, y );\n"
+		"					if( any( lessThan( i, ivec2( 0 ) ) ) || any( greaterThanEqual( i, ivec2( resolution ) ) ) )\n"
+		"						continue;\n"
+		"					vec4 h = texelFetch( history, i, 0 );\n"
+		"					if( miss ? h.a >= 0.0 : !( abs( h.a - expected ) < 0.05 * expected ) )\n"
+		"						continue;\n"
+		"					float w = ( x == 0 ? 1.0 - f.x : f.x ) * ( y == 0 ? 1.0 - f.y : f.y );\n"
+		"					sum += w * h.rgb;\n"
+		"					weights += w;\n"
+		"				}\n"
+		"			}\n"
+		"		}\n"
+		"	}\n"
+		"	vec3 result = c.rgb;\n"
+		"	if( weights > 1.0e-3 ) {\n"
+		"		vec3 previous = sum / weights;\n"
+		"		if( clamp_history ) {\n"
+		"			vec3 lo = c.rgb;\n"
+		"			vec3 hi = c.rgb;\n"
+		"			for( int y = -1; y <= 1; ++y ) {\n"
+		"				for( int x = -1; x <= 1; ++x ) {\n"
+		"					vec3 n = texelFetch( current, clamp( texel + ivec2( x, y ), ivec2( 0 ), ivec2( resolution ) - 1 ), 0 ).rgb;\n"
+		"					lo = min( lo, n );\n"
+		"					hi = max( hi, n );\n"
+		"				}\n"
+		"			}\n"
+		"			previous = clamp( previous, lo, hi );\n"
+		"		}\n"
+		"		// partly disoccluded history counts less\n"
+		"		result = mix( previous, c.rgb, max( blend, 1.0 - weights ) );\n"
+		"	}\n"
+		"	gl_FragColor = vec4( result, c.a );\n"
+		"}\n";
+
+	char const* const resolve_code =
+		"#version 130\n"
+		"uniform sampler2D average;\n"
+		"void main() {\n"
+		"	gl_FragColor = vec4( texelFetch( average, ivec2( gl_FragCoord.xy ), 0 ).rgb, 1.0 );\n"
+		"}\n";
+
+	bool same_camera( view const& a, view const& b ) {
+		return a.position == b.position && a.at == b.at && a.up == b.up && a.right == b.right;
+	}
+}
+
+glossy::temporal_accumulator::temporal_accumulator() {
+	if( !m_reproject.loadFromMemory( reproject_code, sf::Shader::Fragment ) )
+		throw std::runtime_error{ "unable to process the reprojection shader" };
+	if( !m_resolve.loadFromMemory( resolve_code, sf::Shader::Fragment ) )
+		throw std::runtime_error{ "unable to process the accumulation shader" };
+	m_reproject.setUniform( "current", static_cast< int >( current_unit ) );
+	m_reproject.setUniform( "history", static_cast< int >( history_unit ) );
+	m_resolve.setUniform( "average", static_cast< int >( current_unit ) );
+}
+
+void glossy::temporal_accumulator::set_resolution( unsigned int width, unsigned int height ) {
+	m_current.resize( width, height );
+	for( auto& target : m_history )
+		target.resize( width, height );
+	reset();
+}
+void glossy::temporal_accumulator::reset() {
+	m_samples = 0;
+}
+void glossy::temporal_accumulator::changed() {
+	m_changed = true;
+}
+unsigned glossy::temporal_accumulator::samples() const {
+	return m_samples;
+}
+
+void glossy::temporal_accumulator::draw( tracer& t, sf::RenderTarget& target ) {
+	t.set_jitter( m_frame++ );
+	t.draw( target, &m_current );
+
+	view const& v = t.get_view();
+	const bool moving = !same_camera( v, m_previous );
+	if( moving || m_changed )
+		m_samples = std::min( m_samples, max_history );
+	m_reproject.setUniform( "resolution", sf::Glsl::Vec2{ static_cast< float >( v.width ), static_cast< float >( v.height ) } );
+	m_reproject.setUniform( "jitter", t.get_jitter() );
+	m_reproject.setUniform( "fovh", v.fovh );
+	m_reproject.setUniform( "pos", v.position );
+	m_reproject.setUniform( "at", v.at );
+	m_reproject.setUniform( "up", v.up );
+	m_reproject.setUniform( "right", v.right );
+	m_reproject.setUniform( "previous_pos", m_previous.position );
+	m_reproject.setUniform( "previous_at", m_previous.at );
+	m_reproject.setUniform( "previous_up", m_previous.up );
+	m_reproject.setUniform( "previous_right", m_previous.right );
+	m_reproject.setUniform( "blend", 1.0f / ( m_samples + 1 ) );
+	m_reproject.setUniform( "moving", moving );
+	m_reproject.setUniform( "clamp_history", moving || m_changed );
+
+	float_target& destination = m_history[ 1 - m_latest ];
+	m_current.bind( current_unit );
+	m_history[ m_latest ].bind( history_unit );
+	{
+		const float_target::binding bound{ destination };
+		target.draw( m_shape, float_target::overwrite( &m_reproject ) );
+	}
+	m_latest = 1 - m_latest;
+	++m_samples;
+	m_changed = false;
+	m_previous = v;
+
+	destination.bind( current_unit );
+	target.draw( m_shape, &m_resolve );
+}
@@ -0,0 +1,127 @@
+#include <glossy/thread_pool.hpp>
+#include <exception>
+#include <utility>
+
+namespace {
+	// lets tasks that submit further tasks push them onto their own worker's queue
+	thread_local glossy::thread_pool const* current_pool = nullptr;
+	thread_local std::size_t current_index = 0;
+}
+
+glossy::thread_pool::thread_pool( unsigned threads ) {
+	if( threads == 0 )
+		threads = std::thread::hardware_concurrency();
+	if( threads == 0 )
+		threads = 1;
+	for( unsigned i = 0; i < threads; ++i )
+		m_queues.emplace_back( std::make_unique< queue >() );
+	for( unsigned i = 0; i < threads; ++i )
+		m_threads.emplace_back( [ this, i ]{ work( i ); } );
+}
+glossy::thread_pool::~thread_pool() {
+	{
+		std::lock_guard< std::mutex > lock{ m_mutex };
+		m_stop = true;
+	}
+	m_wakeup.notify_all();
+	for( auto& thread : m_threads )
+		thread.join();
+}
+
+unsigned glossy::thread_pool::size() const {
+	return static_cast< unsigned >( m_threads.size() );
+}
+
+void glossy::thread_pool::push( std::size_t index, task_t task ) {
+	// counted first, so that pop and steal never take m_queued below zero
+	++m_queued;
+	{
+		std::lock_guard< std::mutex > lock{ m_queues[ index ]->mutex };
+		m_queues[ index ]->tasks.emplace_back( std::move( task ) );
+	}
+	// taking the lock orders this notification after a worker's check of m_queued
+	{
+		std::lock_guard< std::mutex > lock{ m_mutex };
+	}
+	m_wakeup.notify_one();
+}
+bool glossy::thread_pool::pop( std::size_t index, task_t& task ) {
+	std::lock_guard< std::mutex > lock{ m_queues[ index ]->mutex };
+	auto& tasks = m_queues[ index ]->tasks;
+	if( tasks.empty() )
+		return false;
+	task = std::move( tasks.back() );
+	tasks.pop_back();
+	--m_queued;
+	return true;
+}
+bool glossy::thread_pool::steal( std::size_t index, task_t& task ) {
+	for( std::size_t i = 1; i <= m_queues.size(); ++i ) {
+		auto& victim = *m_queues[ ( index + i ) % m_queues.size() ];
+		std::lock_guard< std::mutex > lock{ victim.mutex };
+		if( victim.tasks.empty() )
+			continue;
+		task = std::move( victim.tasks.front() );
+		victim.tasks.pop_front();
+		--m_queued;
+		return true;
+	}
+	return false;
+}
+void glossy::thread_pool::work( std::size_t index ) {
+	current_pool = this;
+	current_index = index;
+	for( task_t task;; ) {
+		if( pop( index, task ) || steal( index, task ) ) {
+			task();
+			task = nullptr;
+			continue;
+		}
+		std::unique_lock< std::mutex > lock{ m_mutex };
+		m_wakeup.wait( lock, [ this ]{ return m_stop || m_queued > 0; } );
+		if( m_stop && m_queued == 0 )
+			return;
+	}
+}
+
+void glossy::thread_pool::submit( task_t task ) {
+	if( current_pool == this )
+		push( current_index, std::move( task ) );
+	else
+		push( m_next++ % m_queues.size(), std::move( task ) );
+}
+
+void glossy::thread_pool::parallel_for( std::size_t count, std::function< void( std::size_t ) > const& body ) {
+	// all of this lives on the caller's stack, so the tasks only touch it under done_mutex and
+	// notify before they release it; once remaining is 0 under the lock, no task uses it anymore
+	std::size_t remaining = count;
+	std::mutex done_mutex;
+	std::condition_variable done;
+	std::exception_ptr error;
+
+	for( std::size_t i = 0; i < count; ++i ) {
+		push( i % m_queues.size(), [ &, i ]{
+			std::exception_ptr failure;
+			try {
+				body( i );
+			} catch( ... ) {
+				failure = std::current_exception();
+			}
+			std::lock_guard< std::mutex > lock{ done_mutex };
+			if( failure && !error )
+				error = failure;
+			if( --remaining == 0 )
+				done.notify_all();
+		} );
+	}
+
+	// the calling thread helps until nothing is left to take, then waits for the rest
+	for( task_t task; steal( 0, task ); task = nullptr )
+		task();
+	{
+		std::unique_lock< std::mutex > lock{ done_mutex };
+		done.wait( lock, [ & ]{ return remaining == 0; } );
+	}
+	if( error )
+		std::rethrow_exception( error );
+}
@@ -0,0 +1,363 @@
+#include <glossy/tracer.hpp>
+#include <glossy/json2glsl.hpp>
+#include <glossy/stopwatch.hpp>
+#include <glossy/gl.hpp>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+
+namespace {
+	// texture units of the data textures; unit 0 is left to SFML
+	enum : unsigned {
+		sphere_data_unit = 1,
+		bvh_nodes_unit = 2,
+		plane_data_unit = 3,
+		light_data_unit = 4,
+		history_unit = 5,
+		mesh_vertices_unit = 6,
+		mesh_triangles_unit = 7,
+		mesh_bvh_unit = 8,
+		mesh_data_unit = 9,
+		light_alias_unit = 10,
+		tile_data_unit = 11,
+		tile_spheres_unit = 12,
+		gbuffer_unit = 13 // and the two above, see gbuffer
+	};
+
+	// the radical inverse of i in the given base; successive values of the bases 2 and 3
+	// cover the unit square evenly, whatever number of samples has been taken
+	float halton( unsigned i, unsigned base ) {
+		float result = 0.0f;
+		float digit = 1.0f;
+		for( ++i; i != 0; i /= base ) {
+			digit /= base;
+			result += digit * ( i % base );
+		}
+		return result;
+	}
+
+	// the arrays hold two or three texels, i.e. eight or twelve floats, per entity
+	int count_of( std::vector< float > const& data, std::size_t floats_per_entity ) {
+		return static_cast< int >( data.size() / floats_per_entity );
+	}
+}
+
+glossy::tracer::tracer( scene const& s, shader_options const& opts, bool cache )
+	: m_options{ opts } {
+	stopwatch setup_timer;
+	setup_timer.start();
+	if( !sf::Shader::isAvailable() )
+		throw std::runtime_error{ "sf::Shader not available!" };
+	gl::load();
+	if( cache )
+		m_cache = std::make_unique< shader_cache >();
+	if( opts.hybrid )
+		m_gbuffer = std::make_unique< gbuffer >( sphere_data_unit, plane_data_unit );
+	set_scene( s );
+	m_setup_ms = static_cast< double >( setup_timer.elapsed_ms_flt() );
+}
+
+bool glossy::tracer::animated() const {
+	return m_animated;
+}
+bool glossy::tracer::adaptive() const {
+	return m_adaptive;
+}
+glossy::shader_options const& glossy::tracer::get_options() const {
+	return m_options;
+}
+glossy::denoise_settings const& glossy::tracer::get_denoise() const {
+	return m_denoise;
+}
+bool glossy::tracer::cache_hit() const {
+	return m_cache_hit;
+}
+double glossy::tracer::setup_ms() const {
+	return m_setup_ms;
+}
+double glossy::tracer::compile_ms() const {
+	return m_compile_ms;
+}
+
+glossy::tracer::program glossy::tracer::compile( std::string const& code ) const {
+	stopwatch compile_timer;
+	compile_timer.start();
+	program result;
+	result.shader = std::make_unique< sf::Shader >();
+	result.cache_hit = m_cache && m_cache->load( *result.shader, code );
+	if( !result.cache_hit ) {
+		if( !result.shader->loadFromMemory( code, sf::Shader::Fragment ) ) {
+			std::ofstream dump{ "dump.log", std::ofstream::trunc };
+			dump << code;
+			throw std::runtime_error{ "unable to process shader (see dump.log)" };
+		}
+		if( m_cache )
+			m_cache->store( *result.shader, code );
+	}
+	result.compile_ms = static_cast< double >( compile_timer.elapsed_ms_flt() );
+	return result;
+}
+
+void glossy::tracer::apply( scene const& s, std::string const& code, program* p ) {
+	m_layout = layout( s );
+	// like in scene2glsl
+	m_layout.tiles = m_layout.tiles && !m_options.hybrid;
+	m_adaptive = s.adaptive() && !m_options.progressive && !m_options.hybrid && !m_options.temporal;
+	m_denoise = s.denoise;
+	if( m_options.progressive || m_options.temporal || m_adaptive )
+		m_denoise.iterations = 0;
+	m_animated = std::any_of( s.lights.begin(), s.lights.end(), []( light const& l ) { return !l.is_static(); } );
+	m_recursion = s.recursion;
+	m_light_positions.clear();
+	for( auto const& l : s.lights ) {
+		// without diffuse materials, the shader has no lights
+		if( m_layout.lit && l.is_evaluable() ) {
+			m_light_positions.emplace_back( l.position.x );
+			m_light_positions.emplace_back( l.position.y );
+			m_light_positions.emplace_back( l.position.z );
+		}
+	}
+	if( p ) {
+		m_shader = std::move( p->shader );
+		m_cache_hit = p->cache_hit;
+		m_compile_ms = p->compile_ms;
+		m_code = code;
+
+		// a new shader starts without uniforms
+		m_shader->setUniform( "resolution", m_resolution );
+		set_camera( m_camera );
+		if( m_options.progressive ) {
+			m_shader->setUniform( "history", static_cast< int >( history_unit ) );
+			if( m_history )
+				set_progress( m_samples, *m_history );
+		}
+		if( m_options.temporal )
+			m_shader->setUniform( "jitter", m_jitter );
+		if( m_layout.spheres )
+			m_shader->setUniform( "sphere_data", static_cast< int >( sphere_data_unit ) );
+		if( m_layout.bvh )
+			m_shader->setUniform( "bvh_nodes", static_cast< int >( bvh_nodes_unit ) );
+		if( m_layout.planes )
+			m_shader->setUniform( "plane_data", static_cast< int >( plane_data_unit ) );
+		if( m_layout.lights )
+			m_shader->setUniform( "light_data", static_cast< int >( light_data_unit ) );
+		if( m_layout.light_alias )
+			m_shader->setUniform( "light_alias", static_cast< int >( light_alias_unit ) );
+		if( m_layout.meshes ) {
+			m_shader->setUniform( "mesh_vertices", static_cast< int >( mesh_vertices_unit ) );
+			m_shader->setUniform( "mesh_triangles", static_cast< int >( mesh_triangles_unit ) );
+			m_shader->setUniform( "mesh_bvh", static_cast< int >( mesh_bvh_unit ) );
+			m_shader->setUniform( "mesh_data", static_cast< int >( mesh_data_unit ) );
+		}
+		if( m_layout.tiles ) {
+			m_shader->setUniform( "tile_data", static_cast< int >( tile_data_unit ) );
+			m_shader->setUniform( "tile_spheres", static_cast< int >( tile_spheres_unit ) );
+		}
+		if( m_gbuffer ) {
+			m_shader->setUniform( "gbuffer_position", static_cast< int >( gbuffer_unit ) );
+			m_shader->setUniform( "gbuffer_normal", static_cast< int >( gbuffer_unit + 1 ) );
+			m_shader->setUniform( "gbuffer_material", static_cast< int >( gbuffer_unit + 2 ) );
+		}
+	}
+	set_recursion( m_recursion );
+	// the positions may have changed even if the code did not
+	set_time( m_time );
+	if( m_layout.view ) {
+		m_shader->setUniform( "fovh", std::tan( deg2rad( s.fovy ) / 2.0f ) );
+		m_shader->setUniform( "background", s.background );
+	}
+
+	m_view.fovh = std::tan( deg2rad( s.fovy ) / 2.0f );
+	m_view.rendering_distance = s.rendering_distance;
+	scene_data data = pack( s );
+	m_sphere_count = count_of( data.spheres, 8 );
+	m_plane_count = count_of( data.planes, 12 );
+	if( m_layout.spheres ) {
+		m_sphere_data.upload( data.spheres );
+		m_shader->setUniform( "sphere_count", m_sphere_count );
+	}
+	if( m_layout.tiles ) {
+		// binned by draw
+		m_tile_spheres_data = std::move( data.spheres );
+		m_tiles_dirty = true;
+	}
+	if( m_layout.bvh )
+		m_bvh_nodes.upload( data.bvh_nodes );
+	if( m_layout.planes ) {
+		m_plane_data.upload( data.planes );
+		m_shader->setUniform( "plane_count", m_plane_count );
+	}
+	if( m_layout.lights ) {
+		m_light_data.upload( data.lights );
+		m_shader->setUniform( "light_count", count_of( data.lights, 8 ) );
+	}
+	if( m_layout.light_alias )
+		m_light_alias.upload( data.light_alias );
+	if( m_layout.meshes ) {
+		m_mesh_vertices.upload( data.mesh_vertices );
+		m_mesh_triangles.upload( data.mesh_triangles );
+		m_mesh_bvh.upload( data.mesh_bvh );
+		m_mesh_data.upload( data.meshes );
+		m_shader->setUniform( "triangle_count", count_of( data.mesh_triangles, 4 ) );
+	}
+}
+
+void glossy::tracer::set_scene( scene const& s ) {
+	if( m_build ) {
+		m_build->result.wait();
+		m_build.reset();
+	}
+	const std::string code = scene2glsl( s, m_options );
+	if( code != m_code ) {
+		program p = compile( code );
+		apply( s, code, &p );
+	} else {
+		apply( s, code, nullptr );
+	}
+}
+
+bool glossy::tracer::set_scene_async( scene const& s ) {
+	if( m_build ) {
+		m_build->result.wait();
+		m_build.reset();
+	}
+	std::string code = scene2glsl( s, m_options );
+	if( code == m_code ) {
+		apply( s, code, nullptr );
+		return true;
+	}
+	m_build = std::make_unique< build >();
+	m_build->s = s;
+	m_build->code = std::move( code );
+	std::string const& source = m_build->code;
+	m_build->result = std::async( std::launch::async, [ this, &source ] {
+		// a context of this thread, which shares its objects with the others
+		sf::Context context;
+		program result = compile( source );
+		// the program has to be complete before another context uses it
+		glFinish();
+		return result;
+	} );
+	return false;
+}
+
+bool glossy::tracer::building() const {
+	return m_build != nullptr;
+}
+
+bool glossy::tracer::update() {
+	if( !m_build || m_build->result.wait_for( std::chrono::seconds{ 0 } ) != std::future_status::ready )
+		return false;
+	const std::unique_ptr< build > done = std::move( m_build );
+	program p = done->result.get();
+	apply( done->s, done->code, &p );
+	return true;
+}
+
+void glossy::tracer::set_resolution( unsigned int width, unsigned int height ) {
+	m_resolution = { static_cast< float >( width ), static_cast< float >( height ) };
+	m_view.width = width;
+	m_view.height = height;
+	m_tiles_dirty = true;
+	if( m_gbuffer )
+		m_gbuffer->resize( width, height );
+	m_shader->setUniform( "resolution", m_resolution );
+}
+void glossy::tracer::set_camera( camera const& cam ) {
+	m_camera = cam;
+	m_view.position = cam.get_position();
+	m_view.at = cam.get_at();
+	m_view.up = cam.get_up();
+	m_view.right = cam.get_right();
+	m_tiles_dirty = true;
+	m_shader->setUniform( "pos", cam.get_position() );
+	m_shader->setUniform( "at", cam.get_at() );
+	m_shader->setUniform( "up", cam.get_up() );
+	m_shader->setUniform( "right", cam.get_right() );
+}
+void glossy::tracer::set_time( float seconds ) {
+	m_time = seconds;
+	m_shader->setUniform( "global_time", seconds );
+	if( !m_light_positions.empty() ) {
+		std::vector< sf::Glsl::Vec3 > positions;
+		positions.reserve( m_light_positions.size() / 3 );
+		for( std::size_t i = 0; i < m_light_positions.size(); i += 3 )
+			positions.emplace_back( m_light_positions[ i ]( seconds ), m_light_positions[ i + 1 ]( seconds ), m_light_positions[ i + 2 ]( seconds ) );
+		m_shader->setUniformArray( "light_positions", positions.data(), positions.size() );
+	}
+}
+
+void glossy::tracer::set_recursion( unsigned recursion ) {
+	m_recursion = recursion;
+	// shaders without specular materials do not follow reflections
+	if( m_layout.reflective )
+		m_shader->setUniform( "recursion", static_cast< int >( recursion ) );
+}
+unsigned glossy::tracer::get_recursion() const {
+	return m_recursion;
+}
+
+void glossy::tracer::set_progress( unsigned samples, float_target const& history ) {
+	m_samples = samples;
+	m_history = &history;
+	m_shader->setUniform( "samples", static_cast< float >( samples ) );
+	set_jitter( samples );
+}
+void glossy::tracer::set_jitter( unsigned sample ) {
+	m_jitter = { halton( sample, 2 ), halton( sample, 3 ) };
+	m_shader->setUniform( "jitter", m_jitter );
+}
+sf::Glsl::Vec2 glossy::tracer::get_jitter() const {
+	return m_jitter;
+}
+glossy::view const& glossy::tracer::get_view() const {
+	return m_view;
+}
+
+void glossy::tracer::draw( sf::RenderTarget& target, float_target* into ) {
+	// activating a target binds its framebuffer, so that has to happen before into is bound
+	target.setActive( true );
+	if( m_history )
+		m_history->bind( history_unit );
+	if( m_layout.spheres )
+		m_sphere_data.bind( sphere_data_unit );
+	if( m_layout.bvh )
+		m_bvh_nodes.bind( bvh_nodes_unit );
+	if( m_layout.planes )
+		m_plane_data.bind( plane_data_unit );
+	if( m_layout.lights )
+		m_light_data.bind( light_data_unit );
+	if( m_layout.light_alias )
+		m_light_alias.bind( light_alias_unit );
+	if( m_layout.tiles ) {
+		if( m_tiles_dirty ) {
+			bin_spheres( m_tile_spheres_data, m_view, m_tiles );
+			m_tile_data.upload( m_tiles.tiles );
+			m_tile_spheres.upload( m_tiles.spheres );
+			m_shader->setUniform( "tile_columns", static_cast< int >( m_tiles.columns ) );
+			m_tiles_dirty = false;
+		}
+		m_tile_data.bind( tile_data_unit );
+		m_tile_spheres.bind( tile_spheres_unit );
+	}
+	if( m_layout.meshes ) {
+		m_mesh_vertices.bind( mesh_vertices_unit );
+		m_mesh_triangles.bind( mesh_triangles_unit );
+		m_mesh_bvh.bind( mesh_bvh_unit );
+		m_mesh_data.bind( mesh_data_unit );
+	}
+	if( m_gbuffer ) {
+		// reads the sphere and plane data bound above
+		m_gbuffer->draw( target, m_view, m_jitter, m_sphere_count, m_plane_count );
+		m_gbuffer->bind( gbuffer_unit );
+	}
+	if( into ) {
+		const float_target::binding bound{ *into };
+		target.draw( m_shape, float_target::overwrite( m_shader.get() ) );
+	} else {
+		target.draw( m_shape, m_shader.get() );
+	}
+}
@@ -48,3 +48,6 @@ float glossy::norm( vec3 v ) {
 glossy::vec3 glossy::normalize( vec3 v ) {
 	return v / norm( v );
 }
+glossy::vec3 glossy::mul( vec3 u, vec3 v ) {
+	return { u.x * v.x, u.y * v.y, u.z * v.z };
+}
@@ -1,76 +1,146 @@
 #include <glossy/window.hpp>
-#include <glossy/default_scene.hpp>
-#include <glossy/json2glsl.hpp>
 #include <glossy/stopwatch.hpp>
 #include <glossy/util.hpp>
 #include <string>
-#include <stdexcept>
-#include <cmath>
-#include <fstream>
 #include <iostream>
+#include <exception>
+#include <chrono>
 
 void glossy::window::update_resolution( unsigned int width, unsigned int height ) {
 	m_size.x = width;
 	m_size.y = height;
-	m_shader.setUniform( "resolution", sf::Glsl::Vec2{ static_cast< float >( m_size.x ), static_cast< float >( m_size.y ) } );
+	if( m_governor )
+		m_governor->set_resolution( width, height );
+	update_render_resolution();
 }
-
-sf::Vector3f glossy::window::get_position() const {
-	return m_pos;
+void glossy::window::update_render_resolution() {
+	const sf::Vector2u size = m_governor ? m_governor->get_render_size() : sf::Vector2u{ static_cast< unsigned >( m_size.x ), static_cast< unsigned >( m_size.y ) };
+	m_tracer.set_resolution( size.x, size.y );
+	if( m_accumulator )
+		m_accumulator->set_resolution( size.x, size.y );
+	if( m_temporal )
+		m_temporal->set_resolution( size.x, size.y );
+	if( m_denoiser )
+		m_denoiser->set_resolution( size.x, size.y );
 }
-void glossy::window::set_position( sf::Vector3f const& p ) {
-	m_pos = p;
-	m_shader.setUniform( "pos", m_pos );
+void glossy::window::draw_frame( sf::RenderTarget& target ) {
+	// target's context is active and the same every frame, so the queries can be read here
+	double ms;
+	std::uint64_t frame;
+	while( m_gpu_timer.poll( ms, frame ) ) {
+		m_profiler.set_gpu_ms( frame, ms );
+		if( m_governor )
+			m_governor->report( ms );
+	}
+
+	m_gpu_timer.begin( m_profiler.current() );
+	if( m_accumulator )
+		m_accumulator->draw( m_tracer, target );
+	else if( m_temporal )
+		m_temporal->draw( m_tracer, target );
+	else if( m_denoiser )
+		m_denoiser->draw( m_tracer, target );
+	else
+		m_tracer.draw( target );
+	m_gpu_timer.end();
 }
-void glossy::window::move( sf::Vector3f const& v ) {
-	set_position( get_position() + v );
+void glossy::window::update_camera() {
+	// the temporal accumulator follows the camera on its own
+	m_tracer.set_camera( m_camera );
+	if( m_accumulator )
+		m_accumulator->reset();
 }
-
-void glossy::window::rotate_x( float angle ) {
-	m_alpha += angle;
-	if( m_alpha < 0.0f )
-		m_alpha += two_pi;
-	if( m_alpha >= two_pi )
-		m_alpha -= two_pi;
+void glossy::window::update_title() {
+	std::string title = m_title + ( " - " + std::to_string( m_fps ) + " FPS" );
+	if( m_tracer.adaptive() ) {
+		const double spp = m_accumulator->recent_average_spp();
+		title += " - " + std::to_string( static_cast< unsigned >( spp ) ) + '.' + std::to_string( static_cast< unsigned >( spp * 10.0 ) % 10 ) + " spp";
+	} else if( m_accumulator ) {
+		title += " - " + std::to_string( m_accumulator->samples() ) + " spp";
+	} else if( m_temporal ) {
+		title += " - " + std::to_string( m_temporal->samples() ) + " spp";
+	}
+	title += " - recursion " + std::to_string( m_tracer.get_recursion() );
+	if( m_governor )
+		title += " - " + std::to_string( static_cast< unsigned >( m_governor->get_scale() * 100.0f + 0.5f ) ) + "% resolution";
+	if( m_preview )
+		title += " - preview, compiling the shader";
+	m_window.setTitle( title );
 }
-void glossy::window::rotate_y( float angle ) {
-	m_beta += angle;
-	m_beta = clamp( deg2rad( -90 ), deg2rad( 90 ), m_beta );
+void glossy::window::reload() {
+	if( m_watcher && m_watcher->changed() )
+		m_reload_requested = true;
+	// changes while a parse or a build is running are picked up by the next parse
+	if( m_reload_requested && !m_reload.valid() && !m_tracer.building() ) {
+		m_reload_requested = false;
+		m_reload = std::async( std::launch::async, [ this ] { return load_scene( m_options ); } );
+	}
+	try {
+		if( m_reload.valid() && m_reload.wait_for( std::chrono::seconds{ 0 } ) == std::future_status::ready ) {
+			if( m_tracer.set_scene_async( m_reload.get() ) ) {
+				std::cout << "reloaded " << m_options.scene << '\n';
+				scene_changed();
+			} else {
+				std::cout << "recompiling the shader for " << m_options.scene << '\n';
+			}
+		}
+		if( m_tracer.update() ) {
+			std::cout << ( m_preview ? "compiled the shader" : "reloaded " + m_options.scene ) << " (in " << m_tracer.compile_ms() << " ms)\n";
+			m_preview = false;
+			scene_changed();
+		}
+	} catch( std::exception const& e ) {
+		// the scene never showed, which the constructor reported before the preview
+		if( m_preview )
+			throw;
+		// a half saved or mistyped file; the next save tries again
+		std::cerr << "unable to reload " << m_options.scene << ": " << e.what() << '\n';
+	}
 }
-void glossy::window::update_camera() {
-	const float sin_x = std::sin( m_alpha );
-	const float cos_x = std::cos( m_alpha );
-	const float sin_y = std::sin( m_beta );
-	const float cos_y = std::cos( m_beta );
-	m_at.x = sin_x *  cos_y;
-	m_at.y =          sin_y;
-	m_at.z = cos_x *  cos_y;
-	m_up.x = sin_x * -sin_y;
-	m_up.y =          cos_y;
-	m_up.z = cos_x * -sin_y;
-	m_right = cross( m_up, m_at );
-	m_shader.setUniform( "at", m_at );
-	m_shader.setUniform( "up", m_up );
-	m_shader.setUniform( "right", m_right );
+void glossy::window::scene_changed() {
+	const bool accumulate = m_tracer.get_options().progressive || m_tracer.adaptive();
+	if( accumulate && !m_accumulator ) {
+		m_accumulator = std::make_unique< accumulator >();
+		update_render_resolution();
+	} else if( !accumulate ) {
+		m_accumulator.reset();
+	} else {
+		m_accumulator->reset();
+	}
+	if( m_temporal )
+		m_temporal->reset();
+	const bool denoise = m_tracer.get_denoise().iterations != 0;
+	if( denoise && !m_denoiser ) {
+		m_denoiser = std::make_unique< denoiser >();
+		update_render_resolution();
+	} else if( !denoise ) {
+		m_denoiser.reset();
+	}
 }
 
-glossy::window::window( int argc, char** argv ) {
-	if( argc > 2 )
-		throw std::runtime_error{ "too many program options provided" };
-	if( !sf::Shader::isAvailable() )
-		throw std::runtime_error{ "sf::Shader not available!" };
-	std::string code;
-	if( argc == 2 )
-		code = json2glsl( argv[ 1 ] );
-	else
-		code = json2glsl( default_scene );
-	if( !m_shader.loadFromMemory( code, sf::Shader::Fragment ) ) {
-		std::ofstream dump{ "dump.log", std::ofstream::trunc };
-		dump << code;
-		throw std::runtime_error{ "unable to process shader (see dump.log)" };
+glossy::window::window( options const& opts )
+	: window{ opts, load_scene( opts ) } {
+}
+glossy::window::window( options const& opts, scene const& s )
+	: m_options{ opts }
+	, m_tracer{ s.preview(), get_shader_options( opts ), opts.shader_cache }
+	, m_profiler{ opts.stats_log.empty() ? frame_profiler{} : frame_profiler{ opts.stats_log } }
+	, m_show_stats{ opts.stats } {
+	m_startup.start();
+	// the window opens with the preview instead of waiting for the compiler
+	m_preview = !m_tracer.set_scene_async( s );
+	if( m_preview )
+		std::cout << "compiling the shader in the background\n";
+	if( opts.watch )
+		m_watcher = std::make_unique< file_watcher >( opts.scene );
+	if( opts.target_fps != 0 )
+		m_governor = std::make_unique< governor >( 1000.0 / opts.target_fps );
+	if( opts.width != 0 ) {
+		update_resolution( opts.width, opts.height );
+	} else {
+		const auto desktop = sf::VideoMode::getDesktopMode();
+		update_resolution( desktop.width * 2 / 3, desktop.height * 2 / 3 );
 	}
-	const auto desktop = sf::VideoMode::getDesktopMode();
-	update_resolution( desktop.width * 2 / 3, desktop.height * 2 / 3 );
 	m_window.create( sf::VideoMode{ static_cast< unsigned >( m_size.x ), static_cast< unsigned >( m_size.y ) }, m_title, sf::Style::Default, sf::ContextSettings{ 0, 0, 0, 3, 0 } );
 	m_window.setView( sf::View{ { 0, 1, 1, -1 } } );
 	m_window.setMouseCursorVisible( false );
@@ -78,13 +148,25 @@ glossy::window::window( int argc, char** argv ) {
 	sf::Mouse::setPosition( m_size / 2, m_window );
 	m_window.setKeyRepeatEnabled( false );
 	// m_window.setVerticalSyncEnabled( true );
-	set_position( { 0, 1, 0 } );
+	if( opts.progressive || m_tracer.adaptive() ) {
+		m_accumulator = std::make_unique< accumulator >();
+		update_render_resolution();
+	}
+	if( opts.temporal ) {
+		m_temporal = std::make_unique< temporal_accumulator >();
+		update_render_resolution();
+	}
+	if( m_tracer.get_denoise().iterations != 0 ) {
+		m_denoiser = std::make_unique< denoiser >();
+		update_render_resolution();
+	}
 	update_camera();
 }
 
 int glossy::window::run() {
-	stopwatch global_timer;
-	global_timer.start();
+	// summed frame times rather than a stopwatch, so that pausing can stop the clock
+	float global_time = 0.0f;
+	bool paused = false;
 
 	stopwatch frame_timer;
 	frame_timer.start();
@@ -101,14 +183,17 @@ int glossy::window::run() {
 	bool down = false;
 
 	while( m_window.isOpen() ) {
+		m_profiler.begin_frame();
 		++frames;
 		const auto fps_elapsed = fps_timer.elapsed_s_flt();
 		if( fps_elapsed >= 1.0 ) {
 			fps_timer.start();
-			m_window.setTitle( m_title + ( " - " + std::to_string( static_cast< unsigned >( frames / fps_elapsed + 0.5 ) ) + " FPS" ) );
+			m_fps = static_cast< unsigned >( frames / fps_elapsed + 0.5 );
+			update_title();
 			frames = 0;
 		}
 
+		m_profiler.begin( frame_profiler::events );
 		for( sf::Event event; m_window.pollEvent( event ); ) {
 			bool pressing = false;
 			switch( event.type ) {
@@ -144,6 +229,30 @@ int glossy::window::run() {
 				case sf::Keyboard::LControl:
 					down = pressing;
 					break;
+				case sf::Keyboard::P:
+					if( pressing )
+						paused = !paused;
+					break;
+				case sf::Keyboard::PageUp:
+				case sf::Keyboard::PageDown:
+					if( pressing ) {
+						const unsigned recursion = m_tracer.get_recursion();
+						if( event.key.code == sf::Keyboard::PageUp )
+							m_tracer.set_recursion( recursion + 1 );
+						else if( recursion != 0 )
+							m_tracer.set_recursion( recursion - 1 );
+						if( m_accumulator )
+							m_accumulator->reset();
+						if( m_temporal )
+							m_temporal->reset();
+						// the rest of the title is refreshed once a second
+						update_title();
+					}
+					break;
+				case sf::Keyboard::F3:
+					if( pressing )
+						m_show_stats = !m_show_stats;
+					break;
 				case sf::Keyboard::F12:
 					{
 						sf::Texture tex;
@@ -162,9 +271,9 @@ int glossy::window::run() {
 					const int delta_y =    center.y - event.mouseMove.y;
 					constexpr float factor = 1.0f / 1000.0f;
 					if( delta_x )
-						rotate_x( delta_x * factor );
+						m_camera.rotate_x( delta_x * factor );
 					if( delta_y )
-						rotate_y( delta_y * factor );
+						m_camera.rotate_y( delta_y * factor );
 					if( delta_x || delta_y ) {
 						update_camera();
 						sf::Mouse::setPosition( center, m_window );
@@ -176,24 +285,60 @@ int glossy::window::run() {
 			}
 		}
 
+		m_profiler.end( frame_profiler::events );
+
 		const auto frame_elapsed = frame_timer.elapsed_s_flt();
 		frame_timer.start();
 
+		m_profiler.begin( frame_profiler::update );
 		if( forwards || left || backwards || right || up || down ) {
-			sf::Vector3f offset = m_at * static_cast< float >( forwards - backwards ) + m_right * static_cast< float >( right - left ) + m_up * static_cast< float >( up - down );
+			sf::Vector3f offset = m_camera.get_at() * static_cast< float >( forwards - backwards ) + m_camera.get_right() * static_cast< float >( right - left ) + m_camera.get_up() * static_cast< float >( up - down );
 			float speed = 5;
 			if( sf::Keyboard::isKeyPressed( sf::Keyboard::LShift ) )
 				speed *= 3;
 			speed *= frame_elapsed;
 			offset *= speed;
-			move( offset );
+			m_camera.move( offset );
+			update_camera();
 		}
 
-		m_shader.setUniform( "global_time", static_cast< float >( global_timer.elapsed_s_flt() ) );
+		reload();
+
+		if( !paused ) {
+			global_time += static_cast< float >( frame_elapsed );
+			m_tracer.set_time( global_time );
+			// moving lights change the image every frame
+			if( m_accumulator && m_tracer.animated() )
+				m_accumulator->reset();
+			if( m_temporal && m_tracer.animated() )
+				m_temporal->changed();
+		}
+		m_profiler.end( frame_profiler::update );
 
+		m_profiler.begin( frame_profiler::draw );
 		m_window.clear();
-		m_window.draw( m_shape, &m_shader );
+		if( m_governor ) {
+			if( m_governor->draw( m_window, [ this ]( sf::RenderTarget& target ) { draw_frame( target ); } ) ) {
+				// the accumulated samples no longer match the pixels
+				update_render_resolution();
+			}
+		} else {
+			draw_frame( m_window );
+		}
+		if( m_show_stats )
+			m_overlay.draw( m_window, m_profiler );
+		m_profiler.end( frame_profiler::draw );
+
+		m_profiler.begin( frame_profiler::display );
 		m_window.display();
+		m_profiler.end( frame_profiler::display );
+		m_profiler.end_frame();
+
+		// the preview shows first, so the startup ends with the first frame of the scene's own shader
+		if( m_startup.is_running() && !m_preview ) {
+			m_startup.stop();
+			m_overlay.set_startup( m_tracer.setup_ms() + static_cast< double >( m_startup.elapsed_ms_flt() ), m_tracer.cache_hit() );
+		}
 	}
 	return 0;
 }
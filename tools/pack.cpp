@@ -0,0 +1,20 @@
+#include <glossy/json2glsl.hpp>
+#include <glossy/binary_scene.hpp>
+#include <iostream>
+#include <exception>
+
+// converts a JSON scene into the binary format, which Glossy loads without parsing
+
+int main( int argc, char** argv )
+try {
+	using namespace glossy;
+	if( argc != 3 ) {
+		std::cerr << "usage: glossy-pack scene.json scene" << binary_scene_extension << '\n';
+		return 1;
+	}
+	scene2binary( json2scene( argv[ 1 ] ), argv[ 2 ] );
+	return 0;
+} catch( std::exception const& e ) {
+	std::cerr << e.what() << '\n';
+	return 1;
+}